@@ -0,0 +1,256 @@
+/*
+** Adapt
+**    Solution-adaptive grid: the nodes are moved towards the
+**    shock, keeping their number (the workspace, the blocks and
+**    the solvers are sized for im nodes). The monitor of a node
+**
+**      s = max(sensor/max(sensor), |drho/dx|/max(|drho/dx|))
+**
+**    combines the pressure sensor of the artificial viscosity,
+**    |p+ - 2p + p-|/(p+ + 2p + p-), with the density gradient,
+**    and is smoothed by ADAPT_SMOOTH passes of a [1 2 1]/4
+**    filter. The new grid equidistributes the weight
+**
+**      w = 1 + adapt_strength*s
+**
+**    over the intervals, so the spacing at the shock is about
+**    1 + adapt_strength times smaller than in the smooth regions.
+**    Both ends stay in place. The nodes move ADAPT_RELAX of the
+**    way to the new grid; once none of them would move more than
+**    ADAPT_FREEZE of its cell, the grid is kept as it is and the
+**    field converges on it (the grid of a node moving back and
+**    forth over the shock would never let the residual drop).
+**
+**    The field is remapped conservatively: every node owns the
+**    cell between the midpoints of its intervals, Q is taken
+**    constant in the old cells, and the new Q of a node is the
+**    integral over its new cell divided by the width. The inlet
+**    keeps its values and the exit is set by Boundary.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "main.h"
+#include "adapt.h"
+#include "boundary.h"
+#include "derivative.h"
+#include "initialise.h"
+
+/*
+** Function Face
+**    Left face of the cell of node k; face im is the exit.
+*/
+
+static inline double Face(int im, const double *x, int k)
+{
+	if (k == 0)
+		return x[0];
+	if (k == im)
+		return x[im-1];
+
+	return 0.5*(x[k-1] + x[k]);
+}
+
+/*
+** Function Monitor
+**    Fills s with the smoothed monitor of every node.
+*/
+
+static void Monitor(tData *Data, tResult *Result, double *s)
+{
+	int    i, n, im;
+	double p_prev, p_cur, p_next, rho_prev, rho_next;
+	double sensor, gradient, maxSensor, maxGradient, prev, cur;
+
+	im = Result->im;
+
+	maxSensor   = 0;
+	maxGradient = 0;
+
+	/* Two passes: the largest sensor and gradient, then the monitor */
+	for (n=0; n<2; n++)
+	{
+		for (i=1; i<im-1; i++)
+		{
+			p_prev = (Data->gamma-1)*(Result->Q3[i-1] - 0.5*Result->Q2[i-1]*Result->Q2[i-1]/Result->Q1[i-1])*Result->invA[i-1];
+			p_cur  = (Data->gamma-1)*(Result->Q3[i]   - 0.5*Result->Q2[i]*Result->Q2[i]/Result->Q1[i])*Result->invA[i];
+			p_next = (Data->gamma-1)*(Result->Q3[i+1] - 0.5*Result->Q2[i+1]*Result->Q2[i+1]/Result->Q1[i+1])*Result->invA[i+1];
+
+			rho_prev = Result->Q1[i-1]*Result->invA[i-1];
+			rho_next = Result->Q1[i+1]*Result->invA[i+1];
+
+			sensor   = fabs(p_next - 2*p_cur + p_prev)/(p_next + 2*p_cur + p_prev);
+			gradient = fabs(rho_next - rho_prev)/(Result->x[i+1] - Result->x[i-1]);
+
+			if (n == 0)
+			{
+				if (sensor > maxSensor)
+					maxSensor = sensor;
+				if (gradient > maxGradient)
+					maxGradient = gradient;
+			}
+			else
+			{
+				s[i] = 0;
+				if (maxSensor > 0)
+					s[i] = sensor/maxSensor;
+				if (maxGradient > 0 && gradient/maxGradient > s[i])
+					s[i] = gradient/maxGradient;
+			}
+		}
+	}
+
+	s[0]    = s[1];
+	s[im-1] = s[im-2];
+
+	for (n=0; n<ADAPT_SMOOTH; n++)
+	{
+		prev = s[0];
+		for (i=1; i<im-1; i++)
+		{
+			cur  = s[i];
+			s[i] = 0.25*(prev + 2*cur + s[i+1]);
+			prev = cur;
+		}
+	}
+}
+
+/*
+** Function Adapt
+**   Moves the nodes to the equidistribution of the monitor of
+**   the current field, remaps the field and recomputes the
+**   geometry of the new grid. Freezes the grid (adapt = NULL)
+**   when the nodes have settled.
+**
+** In:       tData   Data   = structure containing all data
+**           tResult Result = structure containing results
+** Out:      tResult Result = field on the new grid
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int Adapt(tData *Data, tResult *Result)
+{
+	int    i, j, k, c, im;
+	double w, target, move, lo, hi, left, right, overlap;
+	double *x, *xNew, *s, *W, *Q[3], *QNew[3];
+
+	im = Result->im;
+	x  = Result->x;
+
+	if (Result->adapt[0] == NULL)
+	{
+		fprintf(stderr, "ERROR in function Adapt: No workspace allocated.\n");
+		return -1;
+	}
+
+	xNew = Result->adapt[0];
+	s    = Result->adapt[1];
+	W    = Result->adapt[2];
+
+	Q[0] = Result->Q1;
+	Q[1] = Result->Q2;
+	Q[2] = Result->Q3;
+
+	for (c=0; c<3; c++)
+		QNew[c] = Result->adapt[3+c];
+
+	Monitor(Data, Result, s);
+
+	/* Cumulative weight of the intervals */
+	W[0] = 0;
+	for (j=0; j<im-1; j++)
+		W[j+1] = W[j] + (1 + Data->adaptStrength*0.5*(s[j] + s[j+1]))*(x[j+1] - x[j]);
+
+	/* Equidistribution: node i gets i/(im-1) of the total weight */
+	xNew[0]    = x[0];
+	xNew[im-1] = x[im-1];
+
+	j = 0;
+	for (i=1; i<im-1; i++)
+	{
+		target = W[im-1]*i/(im-1);
+
+		while (j < im-2 && W[j+1] <= target)
+			j++;
+
+		w       = (W[j+1] - W[j])/(x[j+1] - x[j]);
+		xNew[i] = x[j] + (target - W[j])/w;
+	}
+
+	/* Under-relaxation, or the grid and the shock chase each other */
+	move = 0;
+	for (i=1; i<im-1; i++)
+	{
+		xNew[i] = x[i] + ADAPT_RELAX*(xNew[i] - x[i]);
+
+		if (fabs(xNew[i] - x[i])/Result->dx[i] > move)
+			move = fabs(xNew[i] - x[i])/Result->dx[i];
+	}
+
+	/* The shock has settled: keep this grid for the rest of the run */
+	if (move < ADAPT_FREEZE)
+	{
+		for (c=0; c<6; c++)
+			Result->adapt[c] = NULL;
+
+		return 0;
+	}
+
+	/* Conservative remap of the cells of the nodes 1..im-1 */
+	k = 0;
+	for (i=1; i<im; i++)
+	{
+		lo = Face(im, xNew, i);
+		hi = Face(im, xNew, i+1);
+
+		while (k < im-1 && Face(im, x, k+1) <= lo)
+			k++;
+
+		for (c=0; c<3; c++)
+			QNew[c][i] = 0;
+
+		for (j=k; j<im && Face(im, x, j) < hi; j++)
+		{
+			left    = Face(im, x, j)   > lo ? Face(im, x, j)   : lo;
+			right   = Face(im, x, j+1) < hi ? Face(im, x, j+1) : hi;
+			overlap = right - left;
+
+			if (overlap > 0)
+				for (c=0; c<3; c++)
+					QNew[c][i] += Q[c][j]*overlap;
+		}
+
+		for (c=0; c<3; c++)
+			QNew[c][i] /= hi - lo;
+	}
+
+	for (i=1; i<im; i++)
+	{
+		x[i] = xNew[i];
+
+		for (c=0; c<3; c++)
+			Q[c][i] = QNew[c][i];
+	}
+
+	/* Geometry of the new grid */
+	for (i=0; i<im; i++)
+	{
+		Result->A[i]    = AREA(x[i]);
+		Result->invA[i] = 1/Result->A[i];
+	}
+
+	for (i=0; i<im; i++)
+		Result->dA_dx[i] = Derivative(i, Result);
+
+	CellWidths(Result, 0);
+
+	/* The next iteration calculates the timestep of the new grid */
+	Result->timeStep = 0;
+
+	return Boundary(Data, Result);
+}
@@ -0,0 +1,19 @@
+/*
+** Header-file for Adapt
+*/
+
+#ifndef ADAPT_H
+#define ADAPT_H
+
+/* Passes of the [1 2 1]/4 filter over the monitor */
+#define ADAPT_SMOOTH 4
+
+/* Fraction of the way to the new grid the nodes move */
+#define ADAPT_RELAX  0.5
+
+/* Largest move, in cells, of a grid that is frozen */
+#define ADAPT_FREEZE 0.1
+
+int Adapt(tData*, tResult*);
+
+#endif
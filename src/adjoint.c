@@ -0,0 +1,650 @@
+/*
+** Adjoint
+**    Discrete adjoint of the converged field: the gradient of an
+**    output J to the area A and its slope dA/dx in every node,
+**    in one linear solve instead of one nonlinear solve per
+**    node. The outputs are the thrust and the Mach number at the
+**    exit.
+**
+**    The residual of the inner nodes is the flux balance of
+**    schemes R and M, with the reconstruction and interface
+**    flux of the data, or for MacCormack's scheme that of one
+**    step, R(Q) = (S(Q)-Q)/dt, as for the Newton-Krylov solver,
+**    with the timestep frozen at that of the converged field.
+**    It is evaluated in a workspace of its own with the scalar
+**    kernel and without the accelerations (multigrid, Newton,
+**    integrators, smoothing), which change the path to the
+**    steady state but not the state; scheme I is the first
+**    order Roe scheme there. The exit node follows from
+**    Boundary, so the residual includes its dependence on the
+**    inner nodes. With R(Q, A) = 0,
+**
+**      (dR/dQ)^T psi = (dJ/dQ)^T
+**      dJ/dA = dJ/dA (Q fixed) - psi^T dR/dA
+**
+**    and the same for dA/dx. Any residual with the same zero
+**    gives the same gradient.
+**
+**    The residual of a node depends on the nodes up to
+**    ADJOINT_REACH away (MUSCL and MacCormack reach two, first
+**    order Roe one), so dR/dQ is block-banded. Its columns are
+**    central differences of the residual, perturbing every
+**    (2*ADJOINT_REACH+1)-th node at once: 6*(2*ADJOINT_REACH+1)
+**    residuals for the whole Jacobian. The columns of dR/dA and
+**    dR/d(dA/dx) come the same way. The transposed Jacobian is
+**    stored as a band and solved by Gaussian elimination with
+**    partial pivoting, O(im).
+**
+**    Like the Newton-Krylov solver, the differences do not see
+**    the switches of the scheme (limiters, entropy fix,
+**    artificial viscosity) change; the gradient is that of the
+**    field as converged. The residual of MacCormack's scheme
+**    depends a little on the timestep, which is held fixed.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "main.h"
+#include "adjoint.h"
+#include "boundary.h"
+#include "eh.h"
+#include "memory.h"
+#include "norms.h"
+#include "roe.h"
+#include "flux.h"
+#include "schemes.h"
+#include "timestep.h"
+
+typedef struct
+{
+	tData   Data;      /* data of the residual: the scheme alone */
+	tResult W;         /* workspace of the residual */
+	int     output;    /* ADJOINT_THRUST or ADJOINT_MACH */
+	int     n;         /* unknowns, 3*(im-2) */
+	int     kl;        /* bandwidth of the Jacobian */
+
+	double  *Qs[3];    /* field before the step of a residual */
+	double  *Rp, *Rm;  /* residuals of the fields perturbed up and down */
+	double  *psi;      /* dJ/dQ, then the adjoint */
+	double  *band;     /* transposed Jacobian, then its factors */
+	int     *pivot;
+
+	double  *memory;
+} tAdjoint;
+
+/*
+** Function Band
+**    Element (r, c) of the band; row r holds the columns r-kl up
+**    to r+2*kl, room for the fill of the pivoting.
+*/
+
+static inline double *Band(tAdjoint *J, int r, int c)
+{
+	return &J->band[(size_t)r*(3*J->kl+1) + c - r + J->kl];
+}
+
+/*
+** Function Term
+**    The part of the output J that node i of the workspace
+**    adds: all of it in the exit node, nothing elsewhere.
+*/
+
+static double Term(tAdjoint *J, int i)
+{
+	double  gamma, rho, u, p;
+	tResult *W = &J->W;
+
+	if (i != W->im-1)
+		return 0;
+
+	gamma = J->Data.gamma;
+
+	rho = W->Q1[i]*W->invA[i];
+	u   = W->Q2[i]/W->Q1[i];
+	p   = (gamma-1)*(W->Q3[i] - 0.5*W->Q2[i]*u)*W->invA[i];
+
+	if (J->output == ADJOINT_MACH)
+		return fabs(u)/sqrt(gamma*p/rho);
+
+	return W->Q2[i]*u + p*W->A[i];
+}
+
+/*
+** Function Local
+**    The terms of J that a change of node j changes: its own
+**    and, through Boundary, that of the exit node.
+*/
+
+static double Local(tAdjoint *J, int j)
+{
+	Boundary(&J->Data, &J->W);
+
+	return Term(J, j) + (j != J->W.im-1 ? Term(J, J->W.im-1) : 0);
+}
+
+/*
+** Function RoeResidual
+**    R of Roe's scheme, or of the interface flux of the data,
+**    from the fluxes of the field as it is.
+**    The sweep of the scheme reconstructs the interface left of
+**    a node from the node already updated, which makes its step
+**    depend on all nodes upstream; the steady state is the same.
+*/
+
+static void RoeResidual(tAdjoint *J, double *R)
+{
+	int     i, recon;
+	double  gamma, epsilon, kappa;
+	double  E_l[3], E_r[3], E_left[3], E_right[3];
+	tConservative left, right;
+	tResult *W = &J->W;
+
+	gamma   = J->Data.gamma;
+	epsilon = J->Data.epsilon;
+	kappa   = J->Data.kappa;
+	recon   = Reconstruction(&J->Data);
+
+	for (i=0; i<W->im-1; i++)
+	{
+		Reconstruct(recon, gamma, kappa, W->im, W->Q1, W->Q2, W->Q3, i, &left, &right);
+
+		E_l[0] = W->E1[i];
+		E_l[1] = W->E2[i];
+		E_l[2] = W->E3[i];
+
+		E_r[0] = W->E1[i+1];
+		E_r[1] = W->E2[i+1];
+		E_r[2] = W->E3[i+1];
+
+		InterfaceFlux(J->Data.flux, gamma, epsilon, &left, &right, E_l, E_r, E_right);
+
+		if (i>0)
+		{
+			R[3*(i-1)]   = -(E_right[0] - E_left[0])/W->dx[i];
+			R[3*(i-1)+1] = -(E_right[1] - E_left[1])/W->dx[i] + W->H2[i];
+			R[3*(i-1)+2] = -(E_right[2] - E_left[2])/W->dx[i];
+		}
+
+		E_left[0] = E_right[0];
+		E_left[1] = E_right[1];
+		E_left[2] = E_right[2];
+	}
+}
+
+/*
+** Function Residual
+**    R of the field of the workspace; the exit node is set by
+**    Boundary first, the field is left as it was.
+*/
+
+static int Residual(tAdjoint *J, double *R)
+{
+	int     ret;
+	int     i, c, im;
+	double  dummy, dt;
+	double  *Q[3];
+	tResult *W = &J->W;
+
+	im   = W->im;
+	Q[0] = W->Q1;
+	Q[1] = W->Q2;
+	Q[2] = W->Q3;
+
+	ret = Boundary(&J->Data, W);
+
+	if (ret != -1)
+		ret = CalcEH(&J->Data, W);
+
+	if (ret == -1)
+		return ret;
+
+	if (J->Data.scheme != 'C')
+	{
+		RoeResidual(J, R);
+		return ret;
+	}
+
+	for (c=0; c<3; c++)
+		memcpy(J->Qs[c], Q[c], im*sizeof(double));
+
+	ret = W->solver(&J->Data, W, &dummy);
+
+	for (i=1; i<im-1; i++)
+	{
+		dt = W->dt ? W->dt[i] : W->timeStep;
+
+		for (c=0; c<3; c++)
+			R[3*(i-1)+c] = (Q[c][i] - J->Qs[c][i])/dt;
+	}
+
+	for (c=0; c<3; c++)
+		memcpy(Q[c], J->Qs[c], im*sizeof(double));
+
+	return ret;
+}
+
+/*
+** Function SetArea
+**    Sets the area of node j of the workspace; the inlet keeps
+**    its density, velocity and energy, so its Q scales along.
+*/
+
+static void SetArea(tAdjoint *J, tResult *Result, int j, double A)
+{
+	tResult *W = &J->W;
+
+	W->A[j]    = A;
+	W->invA[j] = 1/A;
+
+	if (j == 0)
+	{
+		W->Q1[0] = Result->Q1[0]*A*Result->invA[0];
+		W->Q2[0] = Result->Q2[0]*A*Result->invA[0];
+		W->Q3[0] = Result->Q3[0]*A*Result->invA[0];
+	}
+}
+
+/*
+** Function Perturb
+**    Sets variable v (0..2: Q1..Q3, 3: A, 4: dA/dx) of node j of
+**    the workspace to its converged value plus h.
+*/
+
+static void Perturb(tAdjoint *J, tResult *Result, int v, int j, double h)
+{
+	switch (v)
+	{
+		case 0:  J->W.Q1[j] = Result->Q1[j] + h; break;
+		case 1:  J->W.Q2[j] = Result->Q2[j] + h; break;
+		case 2:  J->W.Q3[j] = Result->Q3[j] + h; break;
+		case 3:  SetArea(J, Result, j, Result->A[j] + h); break;
+		default: J->W.dA_dx[j] = Result->dA_dx[j] + h; break;
+	}
+}
+
+/*
+** Function Columns
+**    Central differences of R to variable v of the nodes
+**    first, first+stride, ... up to last, all at once, into Rp.
+*/
+
+static int Columns(tAdjoint *J, tResult *Result, int v, int first, int last, int stride, double h)
+{
+	int ret;
+	int j, k;
+
+	for (j=first; j<=last; j+=stride)
+		Perturb(J, Result, v, j, h);
+
+	ret = Residual(J, J->Rp);
+
+	for (j=first; j<=last; j+=stride)
+		Perturb(J, Result, v, j, -h);
+
+	if (ret != -1)
+		ret = Residual(J, J->Rm);
+
+	for (j=first; j<=last; j+=stride)
+		Perturb(J, Result, v, j, 0);
+
+	for (k=0; k<J->n; k++)
+		J->Rp[k] = (J->Rp[k] - J->Rm[k])/(2*h);
+
+	return ret;
+}
+
+/*
+** Function Factor
+**    LU factorisation of the band with partial pivoting, in
+**    place; the multipliers stay in the rows they were made for.
+**    Returns -1 for a singular matrix.
+*/
+
+static int Factor(tAdjoint *J)
+{
+	int    i, k, p, c, last;
+	double big, m, t;
+
+	for (k=0; k<J->n; k++)
+	{
+		p   = k;
+		big = fabs(*Band(J, k, k));
+		for (i=k+1; i<=k+J->kl && i<J->n; i++)
+			if (fabs(*Band(J, i, k)) > big)
+			{
+				big = fabs(*Band(J, i, k));
+				p   = i;
+			}
+
+		if (big == 0)
+			return -1;
+
+		J->pivot[k] = p;
+		last = (k+2*J->kl < J->n) ? k+2*J->kl : J->n-1;
+
+		if (p != k)
+			for (c=k; c<=last; c++)
+			{
+				t               = *Band(J, k, c);
+				*Band(J, k, c)  = *Band(J, p, c);
+				*Band(J, p, c)  = t;
+			}
+
+		for (i=k+1; i<=k+J->kl && i<J->n; i++)
+		{
+			m = *Band(J, i, k)/(*Band(J, k, k));
+			*Band(J, i, k) = m;
+
+			if (m != 0)
+				for (c=k+1; c<=last; c++)
+					*Band(J, i, c) -= m*(*Band(J, k, c));
+		}
+	}
+
+	return 0;
+}
+
+/*
+** Function Substitute
+**    Solves the factorised band system in place.
+*/
+
+static void Substitute(tAdjoint *J, double *x)
+{
+	int    i, k, c, last;
+	double t;
+
+	for (k=0; k<J->n; k++)
+	{
+		if (J->pivot[k] != k)
+		{
+			t              = x[k];
+			x[k]           = x[J->pivot[k]];
+			x[J->pivot[k]] = t;
+		}
+
+		for (i=k+1; i<=k+J->kl && i<J->n; i++)
+			x[i] -= *Band(J, i, k)*x[k];
+	}
+
+	for (k=J->n-1; k>=0; k--)
+	{
+		last = (k+2*J->kl < J->n) ? k+2*J->kl : J->n-1;
+
+		t = x[k];
+		for (c=k+1; c<=last; c++)
+			t -= *Band(J, k, c)*x[c];
+
+		x[k] = t/(*Band(J, k, k));
+	}
+}
+
+/*
+** Function Adjoint
+**   Gradient of an output of the converged field to the area
+**   and the area slope of every node.
+**
+** In:       tData   Data   = structure containing all data
+**           tResult Result = converged field
+**           int     output = ADJOINT_THRUST or ADJOINT_MACH
+** Out:      double  value  = the output
+**           double  dJdA   = dJ/dA of every node (im)
+**           double  dJdS   = dJ/d(dA/dx) of every node (im)
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int Adjoint(tData *Data, tResult *Result, int output, double *value, double *dJdA, double *dJdS)
+{
+	int     ret;
+	int     i, j, r, c, v, s, im, stride, lo, hi;
+	double  h, Jp, Jm, sum, scale[5];
+	double  *Q[3], *grad, *next;
+	tAdjoint J;
+
+	ret    = 0;
+	im     = Result->im;
+	stride = 2*ADJOINT_REACH+1;
+
+	/* The residual of the scheme alone */
+	J.Data = *Data;
+	J.Data.im            = im;
+	J.Data.scheme        = (Data->scheme == 'I') ? 'R' : Data->scheme;
+	J.Data.kernel        = KERNEL_SCALAR;
+	J.Data.threads       = 0;
+	J.Data.solver        = SOLVER_MARCH;
+	J.Data.mgLevels      = 1;
+	J.Data.irs           = 0;
+	J.Data.integrator    = INTEGRATOR_EULER;
+	J.Data.adapt         = 0;
+	J.Data.extrapolate   = 0;
+	J.Data.sequence      = 0;
+	J.Data.stopRule      = STOP_RESIDUAL;
+	J.Data.stopEquations = 1;
+	J.Data.stopNorm      = NORM_L2;
+
+	J.output = output;
+	J.n      = 3*(im-2);
+	J.kl     = 3*ADJOINT_REACH+2;
+	J.pivot  = malloc(J.n*sizeof(int));
+	J.memory = malloc(((size_t)J.n*(3*J.kl+4) + 3*(size_t)im)*sizeof(double));
+
+	if (J.pivot == NULL || J.memory == NULL)
+	{
+		fprintf(stderr, "ERROR in function Adjoint: could not allocate memory...\n");
+		free(J.pivot);
+		free(J.memory);
+		return -1;
+	}
+
+	next   = J.memory;
+	J.band = next; next += (size_t)J.n*(3*J.kl+1);
+	J.Rp   = next; next += J.n;
+	J.Rm   = next; next += J.n;
+	J.psi  = next; next += J.n;
+	for (c=0; c<3; c++)
+	{
+		J.Qs[c] = next;
+		next   += im;
+	}
+
+	memset(J.band, 0, (size_t)J.n*(3*J.kl+1)*sizeof(double));
+
+	ret = InitMem(NULL, &J.Data, &J.W);
+
+	/* The converged field on the grid of the run, and its timestep */
+	if (ret != -1)
+	{
+		memcpy(J.W.x,     Result->x,     im*sizeof(double));
+		memcpy(J.W.dx,    Result->dx,    im*sizeof(double));
+		memcpy(J.W.A,     Result->A,     im*sizeof(double));
+		memcpy(J.W.dA_dx, Result->dA_dx, im*sizeof(double));
+		memcpy(J.W.invA,  Result->invA,  im*sizeof(double));
+		memcpy(J.W.Q1,    Result->Q1,    im*sizeof(double));
+		memcpy(J.W.Q2,    Result->Q2,    im*sizeof(double));
+		memcpy(J.W.Q3,    Result->Q3,    im*sizeof(double));
+
+		ret = Boundary(&J.Data, &J.W);
+	}
+
+	if (ret != -1)
+		ret = TimeStep(&J.Data, &J.W);
+
+	if (ret != -1)
+	{
+		*value = 0;
+		for (i=0; i<im; i++)
+			*value += Term(&J, i);
+	}
+
+	/* Steps of the differences */
+	Q[0] = Result->Q1;
+	Q[1] = Result->Q2;
+	Q[2] = Result->Q3;
+
+	for (v=0; v<5; v++)
+	{
+		scale[v] = 0;
+		for (i=0; i<im; i++)
+		{
+			h = (v < 3) ? Q[v][i] : (v == 3 ? Result->A[i] : Result->dA_dx[i]);
+			if (fabs(h) > scale[v])
+				scale[v] = fabs(h);
+		}
+
+		scale[v] = ADJOINT_STEP*(scale[v] > 0 ? scale[v] : 1);
+	}
+
+	/* dJ/dQ of the inner nodes */
+	for (i=1; i<im-1 && ret!=-1; i++)
+		for (c=0; c<3; c++)
+		{
+			h = scale[c];
+
+			Perturb(&J, Result, c, i, h);
+			Jp = Local(&J, i);
+
+			Perturb(&J, Result, c, i, -h);
+			Jm = Local(&J, i);
+
+			Perturb(&J, Result, c, i, 0);
+			J.psi[3*(i-1)+c] = (Jp - Jm)/(2*h);
+		}
+
+	/* dR/dQ, stored transposed */
+	for (s=1; s<=stride && ret!=-1; s++)
+		for (c=0; c<3 && ret!=-1; c++)
+		{
+			ret = Columns(&J, Result, c, s, im-2, stride, scale[c]);
+
+			for (j=s; j<=im-2; j+=stride)
+			{
+				lo = (j-ADJOINT_REACH > 1)  ? j-ADJOINT_REACH : 1;
+				hi = (j+ADJOINT_REACH < im-2) ? j+ADJOINT_REACH : im-2;
+
+				for (i=lo; i<=hi; i++)
+					for (r=0; r<3; r++)
+						*Band(&J, 3*(j-1)+c, 3*(i-1)+r) = J.Rp[3*(i-1)+r];
+			}
+		}
+
+	if (ret != -1 && Factor(&J) == -1)
+	{
+		fprintf(stderr, "ERROR in function Adjoint: The Jacobian of the residual is singular.\n");
+		ret = -1;
+	}
+
+	if (ret != -1)
+		Substitute(&J, J.psi);
+
+	/* dJ/dA and dJ/d(dA/dx): the direct part, minus psi^T dR */
+	for (v=3; v<5 && ret!=-1; v++)
+	{
+		grad = (v == 3) ? dJdA : dJdS;
+
+		for (j=0; j<im; j++)
+		{
+			h = scale[v];
+
+			Perturb(&J, Result, v, j, h);
+			Jp = Local(&J, j);
+
+			Perturb(&J, Result, v, j, -h);
+			Jm = Local(&J, j);
+
+			Perturb(&J, Result, v, j, 0);
+			grad[j] = (Jp - Jm)/(2*h);
+		}
+
+		for (s=0; s<stride && ret!=-1; s++)
+		{
+			ret = Columns(&J, Result, v, s, im-1, stride, scale[v]);
+
+			for (j=s; j<im; j+=stride)
+			{
+				lo = (j-ADJOINT_REACH > 1)  ? j-ADJOINT_REACH : 1;
+				hi = (j+ADJOINT_REACH < im-2) ? j+ADJOINT_REACH : im-2;
+
+				sum = 0;
+				for (i=lo; i<=hi; i++)
+					for (r=0; r<3; r++)
+						sum += J.psi[3*(i-1)+r]*J.Rp[3*(i-1)+r];
+
+				grad[j] -= sum;
+			}
+		}
+	}
+
+	if (J.W.arena)
+		FreeMem(&J.W);
+
+	free(J.pivot);
+	free(J.memory);
+
+	return ret;
+}
+
+/*
+** Function AdjointName
+**    Returns a readable name of an output for reports.
+*/
+
+char *AdjointName(int output)
+{
+	return (output == ADJOINT_MACH) ? "exit Mach number" : "thrust";
+}
+
+/*
+** Function WriteAdjoint
+**   Writes the gradient of the adjoint solve as GNUPlot data:
+**   x, A, dA/dx, dJ/dA and dJ/d(dA/dx) of every node.
+**
+** In:       FILE    log      = pointer to log file
+**           char    fileName = name of the gradient file
+**           tResult Result   = structure containing results
+**           int     output   = ADJOINT_THRUST or ADJOINT_MACH
+**           double  value    = the output
+**           double  dJdA     = dJ/dA of every node
+**           double  dJdS     = dJ/d(dA/dx) of every node
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int WriteAdjoint(FILE *log, char *fileName, tResult *Result, int output,
+                 double value, double *dJdA, double *dJdS)
+{
+	int  i;
+	FILE *file;
+
+	file = fopen(fileName, "w");
+	if (file == NULL)
+	{
+		fprintf(stderr, "ERROR in function WriteAdjoint: Could not open '%s'.\n", fileName);
+		return -1;
+	}
+
+	fprintf(file, "# Gradient of the %s, %.10e\n", AdjointName(output), value);
+	fprintf(file, "# x A dA/dx dJ/dA dJ/d(dA/dx)\n");
+
+	for (i=0; i<Result->im; i++)
+		fprintf(file, "%.10e %.10e %.10e %.10e %.10e\n", Result->x[i], Result->A[i], Result->dA_dx[i], dJdA[i], dJdS[i]);
+
+	if (fclose(file) != 0)
+	{
+		fprintf(stderr, "ERROR in function WriteAdjoint: Could not write '%s'.\n", fileName);
+		return -1;
+	}
+
+	if (log)
+		fprintf(log, "\nAdjoint: gradient of the %s (%.6e) written to '%s'.\n\n", AdjointName(output), value, fileName);
+
+	return 0;
+}
@@ -0,0 +1,21 @@
+/*
+** Header-file for Adjoint
+*/
+
+#ifndef ADJOINT_H
+#define ADJOINT_H
+
+/* Name of the gradient file of a run */
+#define ADJOINT_FILE  "nozzle.adj"
+
+/* Nodes on either side of a node that its residual depends on */
+#define ADJOINT_REACH 2
+
+/* Step of the finite differences, relative to the largest value of the variable */
+#define ADJOINT_STEP  1e-6
+
+int  Adjoint(tData*, tResult*, int, double*, double*, double*);
+char *AdjointName(int);
+int  WriteAdjoint(FILE*, char*, tResult*, int, double, double*, double*);
+
+#endif
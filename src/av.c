@@ -3,14 +3,14 @@
 
 #include "main.h"
 #include "av.h"
+#include "trace.h"
 
 /*
 ** Function CalcAV
 **    Creates the source term using artificial viscosity at a 
 **    given node.
 **
-** In:       FILE    log     = logfile
-**           double  gamma   = constant
+** In:       double  gamma   = constant
 **           double  epsilon = constant factor for artificial viscosity
 **           int     i       = current node number
 **           int     im      = last node number
@@ -24,7 +24,7 @@
 ** Author:   J.L. Klaufus
 */
 
-int CalcAV(FILE *log, double gamma, double epsilon, int i, int im, double A, double *Q1, double *Q2, double* Q3, tAV *AV)
+int CalcAV(double gamma, double epsilon, int i, int im, double A, double *Q1, double *Q2, double* Q3, tAV *AV)
 {
 	int    ret;
 	int    ii;
@@ -139,11 +139,7 @@ int CalcAV(FILE *log, double gamma, double epsilon, int i, int im, double A, dou
 		if (p_next+2*p_cur+p_prev < 0)
 		{
 			fprintf(stderr, "ERROR in function AV: p_term division by zero\n");
-			fprintf(log   , "ERROR in function AV: p_term division by zero\n");
-			fprintf(log   , "  i = %d\n", i);
-			fprintf(log   , "  P1 = %10.4f\n", p_prev);
-			fprintf(log   , "  P2 = %10.4f\n", p_cur);
-			fprintf(log   , "  P3 = %10.4f\n", p_next);
+			TRACE(TRACE_AV, TRACE_ERROR, TRACE_EV_ERROR, i, p_prev, p_cur, p_next, 0);
 
 			p_term =  0;
 			ret    = -1;
@@ -184,43 +180,7 @@ int CalcAV(FILE *log, double gamma, double epsilon, int i, int im, double A, dou
 		AV->D3 = epsilon*p_term*(Q3_next-2*Q3_cur+Q1_prev);
 		*/
 
-		/* Write report */
-		if (log)
-		{
-			fprintf(log, "\n***** FUNCTION AV *****\n");
-
-			fprintf(log, "  I        = %10d\n", i);
-
-			fprintf(log, "  Rho_prev = %10.3f\n", rho_prev);
-			fprintf(log, "  Rho_cur  = %10.3f\n", rho_cur);
-			fprintf(log, "  Rho_next = %10.3f\n", rho_next);
-
-			fprintf(log, "  P_prev   = %10.3f\n", p_prev);
-				fprintf(log, "  P_cur    = %10.3f\n", p_cur);
-			fprintf(log, "  P_next   = %10.3f\n", p_next);
-
-			fprintf(log, "  U_prev   = %10.3f\n", u_prev);
-			fprintf(log, "  U_cur    = %10.3f\n", u_cur);
-			fprintf(log, "  U_next   = %10.3f\n", u_next);
-
-			fprintf(log, "  A_prev   = %10.3f\n", a_prev);
-			fprintf(log, "  A_cur    = %10.3f\n", a_cur);
-			fprintf(log, "  A_next   = %10.3f\n", a_next);
-
-			fprintf(log, "  U_plus   = %10.3f\n", u_plus);
-			fprintf(log, "  U_min    = %10.3f\n", u_min);
-
-			fprintf(log, "  AV_plus  = %10.3f\n", av_plus);
-			fprintf(log, "  AV_min   = %10.3f\n", av_min);
-
-			fprintf(log, "  P_term   = %10.3f\n", p_term);
-
-			fprintf(log, "  D1       = %10.3f\n", AV->D1);
-			fprintf(log, "  D2       = %10.3f\n", AV->D2);
-			fprintf(log, "  D3       = %10.3f\n", AV->D3);
-
-			fprintf(log, "\n***********************\n");
-		}
+		TRACE(TRACE_AV, TRACE_CELL, TRACE_EV_AV, i, AV->D1, AV->D2, AV->D3, p_term);
 	}
 
 	return ret;
@@ -12,6 +12,6 @@ typedef struct
 	double D3;
 } tAV;
 
-int CalcAV(FILE*, double, double, int, int, double, double*, double*, double*, tAV*);
+int CalcAV(double, double, int, int, double, double*, double*, double*, tAV*);
 
 #endif
@@ -0,0 +1,492 @@
+/*
+** Program Bench
+**   Runs the schemes of program Nozzle for a fixed number of
+**   iterations on a range of grid sizes and reports the time
+**   per cell update, the achieved memory bandwidth and the
+**   number of iterations per second.
+**
+**   Every datafile given on the commandline is run with
+**   im = 100, 1000, ... up to the maximum grid size. The
+**   results are written to a machine readable file; when a
+**   baseline file is given, every case is compared against
+**   the matching case (scheme, flux and im) of the baseline.
+**
+**   With -f the datafiles of schemes R and M are run with every
+**   interface flux, and each is also solved on its own grid
+**   until the stopping rule holds. The flux table then lists
+**   the floating point operations per interface, the time per
+**   iteration and the iterations to converge of every flux.
+**
+** Use:      nozzle-bench [-n ITERATIONS] [-w WORK] [-m MAXIM]
+**                        [-k KERNEL] [-f] [-o FILENAME]
+**                        [-b BASELINE] DATAFILE...
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "main.h"
+#include "data.h"
+#include "eh.h"
+#include "initialise.h"
+#include "memory.h"
+#include "nozzle.h"
+#include "roe.h"
+#include "flux.h"
+#include "roebatch.h"
+#include "solve.h"
+#include "timer.h"
+
+#define MAXCASES 256
+
+/* Most iterations of a solve to convergence (-f) */
+#define MAXCONVERGE 1000000
+
+static char *kernelNames[] = {"scalar", "fused", "simd"};
+
+typedef struct
+{
+	char   scheme;
+	int    kernel;
+	int    flux;
+	int    im;
+	int    iterations;
+	double seconds;
+	double nsPerCell;
+	double bandwidth;
+	double itPerSec;
+	double residual;
+	double ulp;
+} tBench;
+
+typedef struct
+{
+	char   scheme;
+	int    flux;
+	int    im;
+	int    iterations;  /* to convergence, -1 if not converged */
+	double usPerIt;
+	double residual;
+} tConverge;
+
+/*
+** Function Traffic
+**   Estimates the number of bytes moved between memory and
+**   processor per cell update. Every array streamed through
+**   once counts 8 bytes; arrays read by more than one pass
+**   count once per pass.
+**
+** In:       tData Data  = structure containing all data
+** Out:      -
+** Return:   double bytes = bytes per cell update
+**
+** Author:   J.L. Klaufus
+*/
+
+static double Traffic(tData *Data)
+{
+	int arrays;
+
+	if (Data->kernel == KERNEL_FUSED)
+	{
+		/* One sweep: x, A, 1/A, dA/dx, Q1..Q3 in; Q1..Q3 out */
+		arrays = 10;
+
+		/* MacCormack also writes Q-bar (read back from cache) */
+		if (Data->scheme == 'C')
+			arrays += 3;
+
+		return 8.0*arrays;
+	}
+
+	if (Data->kernel == KERNEL_SIMD && Data->scheme != 'C')
+	{
+		/* CalcEH, TimeStep as below                            */
+		/* States (MUSCL only): Q1..Q3 in; left, right out      */
+		/* Fluxes: left, right (or Q), E1..E3 in; F1..F3 out    */
+		/* Update: x, 1/A, Q1..Q3, F1..F3, H2 in; Q1..Q3 out    */
+		arrays = 10 + 5 + 9 + 12;
+		if (Data->scheme == 'M')
+			arrays += 9 + 3;
+
+		return 8.0*arrays;
+	}
+
+	/* CalcEH: A, 1/A, dA/dx, Q1..Q3 in; E1..E3, H2 out */
+	/* TimeStep: x, 1/A, Q1..Q3 in                      */
+	arrays = 10 + 5;
+
+	if (Data->scheme == 'C')
+	{
+		/* Predictor: x, A, 1/A, dA/dx, Q, E, H2 in; Q_b, E_b, H2_b out */
+		/* Corrector: x, 1/A, Q, Q_b, E_b, H2_b in; Q_bb, Q out          */
+		arrays += 18 + 18;
+	}
+	else
+	{
+		/* Sweep: x, 1/A, Q, E, H2 in; Q out */
+		arrays += 13;
+	}
+
+	return 8.0*arrays;
+}
+
+/*
+** Function ReadBaseline
+**   Reads the cases of an earlier benchmark run.
+**
+** In:       char   fileName = name of the baseline file
+** Out:      tBench Base     = array of baseline cases
+** Return:   number of cases read, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+static int ReadBaseline(char *fileName, tBench *Base)
+{
+	FILE *baseFile;
+	char line[256];
+	char kernel[50], flux[50];
+	int  n, k;
+
+	baseFile = fopen(fileName, "r");
+	if (baseFile == NULL)
+		return -1;
+
+	n = 0;
+	while (n < MAXCASES && fgets(line, sizeof(line), baseFile))
+	{
+		if (line[0] == '#')
+			continue;
+
+		/* Baselines from before the fluxes have no flux column: Roe */
+		strcpy(flux, "roe");
+		if (sscanf(line, " %c %49s %d %d %lf %lf %lf %lf %lf %49s",
+		           &Base[n].scheme, kernel, &Base[n].im, &Base[n].iterations,
+		           &Base[n].seconds, &Base[n].nsPerCell, &Base[n].bandwidth,
+		           &Base[n].itPerSec, &Base[n].residual, flux) >= 9)
+		{
+			Base[n].kernel = 0;
+			for (k=0; k<(int)(sizeof(kernelNames)/sizeof(kernelNames[0])); k++)
+				if (strcmp(kernel, kernelNames[k]) == 0)
+					Base[n].kernel = k;
+
+			Base[n].flux = FLUX_ROE;
+			for (k=0; k<NFLUX; k++)
+				if (strcmp(flux, FluxName(k)) == 0)
+					Base[n].flux = k;
+			n++;
+		}
+	}
+
+	fclose(baseFile);
+
+	return n;
+}
+
+/*
+** Function RunCase
+**   Runs a single case for a fixed number of iterations.
+**
+** In:       tData  Data  = structure containing all data
+**           int    iterations = number of iterations
+** Out:      tBench Bench = timing results
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+static int RunCase(tData *Data, int iterations, tBench *Bench)
+{
+	int     ret;
+	int     i;
+	double  residual, normResidual;
+	double  t1, t2;
+	tResult Result;
+
+	ret = InitMem(NULL, Data, &Result);
+
+	if (ret != -1)
+		ret = Init(NULL, Data, &Result);
+
+	residual     = 0;
+	normResidual = 1;
+
+	t1 = WallTime();
+	for (i=1; i<=iterations && ret != -1; i++)
+	{
+		ret = Iterate(Data, &Result, &residual);
+
+		if (i==1)
+			normResidual = residual;
+	}
+	t2 = WallTime();
+
+	Bench->scheme     = Data->scheme;
+	Bench->kernel     = Data->kernel;
+	Bench->flux       = Data->flux;
+	Bench->im         = Data->im;
+	Bench->iterations = iterations;
+	Bench->seconds    = t2-t1;
+	Bench->nsPerCell  = 1e9*Bench->seconds/((double)iterations*Data->im);
+	Bench->bandwidth  = Traffic(Data)/Bench->nsPerCell;
+	Bench->itPerSec   = iterations/Bench->seconds;
+	Bench->residual   = residual/normResidual;
+
+	/* Check the SIMD Roe flux against the scalar one on the final field */
+	Bench->ulp = 0;
+	if (ret != -1 && Data->kernel == KERNEL_SIMD && Data->scheme != 'C')
+	{
+		ret = CalcEH(Data, &Result);
+		if (ret != -1)
+			Bench->ulp = RoeBatchCheck(Data, &Result);
+
+		if (Bench->ulp < 0 || Bench->ulp > ROEBATCH_MAXULP)
+		{
+			fprintf(stderr, "ERROR in function Bench: SIMD Roe flux (%s) differs %g ULP from scalar.\n",
+			        ISAName(Result.isa), Bench->ulp);
+			ret = -1;
+		}
+	}
+
+	FreeMem(&Result);
+
+	return ret;
+}
+
+/*
+** Function ConvergeCase
+**   Solves a case on its own grid until the stopping rule of
+**   the data holds, through the library interface.
+**
+** In:       tData     Data     = structure containing all data
+** Out:      tConverge Converge = iterations and time per iteration
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+static int ConvergeCase(tData *Data, tConverge *Converge)
+{
+	int     ret;
+	int     iterations;
+	double  residual;
+	double  t1, t2;
+	tNozzle *N;
+
+	iterations = 0;
+	residual   = 0;
+
+	N = NozzleCreate(Data);
+	if (N == NULL)
+		return -1;
+
+	ret = NozzleInit(N);
+
+	t1 = WallTime();
+	if (ret != -1)
+		ret = NozzleSolve(N, MAXCONVERGE, &iterations, &residual);
+	t2 = WallTime();
+
+	NozzleDestroy(N);
+
+	Converge->scheme     = Data->scheme;
+	Converge->flux       = Data->flux;
+	Converge->im         = Data->im;
+	Converge->iterations = (ret == 1) ? iterations : -1;
+	Converge->usPerIt    = (iterations > 0) ? 1e6*(t2-t1)/iterations : 0;
+	Converge->residual   = residual;
+
+	return (ret == -1) ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int    ret;
+	int    i, j, k, f;
+	int    nBase, nCases, nConverge;
+	int    iterations, work, maxIm, dataIm;
+	int    kernel, fluxes, nFlux;
+
+	char   *outFileName  = "bench.dat";
+	char   *baseFileName = NULL;
+	FILE   *outFile      = NULL;
+
+	tData  Data;
+	tBench Base[MAXCASES];
+	tBench Bench[MAXCASES];
+
+	tConverge Converge[MAXCASES];
+
+	ret        = 0;
+	iterations = 0;
+	work       = 10000000;
+	maxIm      = 10000000;
+	nCases     = 0;
+	nConverge  = 0;
+	nBase      = 0;
+	kernel     = -1;
+	fluxes     = 0;
+
+	/* First pass over the commandline: options */
+	for (i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+			iterations = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-w") == 0 && i+1 < argc)
+			work = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-m") == 0 && i+1 < argc)
+			maxIm = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+			outFileName = argv[++i];
+		else if (strcmp(argv[i], "-b") == 0 && i+1 < argc)
+			baseFileName = argv[++i];
+		else if (strcmp(argv[i], "-f") == 0)
+			fluxes = 1;
+		else if (strcmp(argv[i], "-k") == 0 && i+1 < argc)
+		{
+			i++;
+			for (k=0; k<(int)(sizeof(kernelNames)/sizeof(kernelNames[0])); k++)
+				if (strcmp(argv[i], kernelNames[k]) == 0)
+					kernel = k;
+		}
+		else if (argv[i][0] == '-')
+		{
+			printf("\nUnknown commandline option: '%s'\n", argv[i]);
+			printf("Use : nozzle-bench [-n ITERATIONS] [-w WORK] [-m MAXIM] [-k KERNEL] [-f] [-o FILENAME] [-b BASELINE] DATAFILE...\n");
+			return -1;
+		}
+	}
+
+	if (baseFileName)
+	{
+		nBase = ReadBaseline(baseFileName, Base);
+		if (nBase == -1)
+		{
+			printf("No baseline found in '%s'; not comparing.\n", baseFileName);
+			nBase = 0;
+		}
+	}
+
+	/* Second pass: run every datafile on all grid sizes */
+	for (i=1; i<argc && ret != -1; i++)
+	{
+		if (argv[i][0] == '-')
+		{
+			/* -f is the only option without a value */
+			if (strcmp(argv[i], "-f") != 0)
+				i++;
+			continue;
+		}
+
+		ret = ReadData(NULL, argv[i], &Data);
+
+		if (kernel != -1)
+			Data.kernel = kernel;
+
+		/* Every flux (-f) for schemes R and M, else the flux of the datafile */
+		nFlux = (fluxes && (Data.scheme == 'R' || Data.scheme == 'M')) ? NFLUX : 1;
+		dataIm = Data.im;
+
+		for (f=0; f<nFlux && ret != -1; f++)
+		{
+			if (nFlux > 1)
+			{
+				Data.flux = f;
+				CheckOptions(&Data);
+			}
+
+			if (nFlux > 1 && nConverge < MAXCASES)
+			{
+				Data.im = dataIm;
+				ret = ConvergeCase(&Data, &Converge[nConverge]);
+				if (ret != -1)
+					nConverge++;
+			}
+
+			for (k=100; k<=maxIm && ret != -1 && nCases < MAXCASES; k*=10)
+			{
+				Data.im = k;
+
+				/* Fixed iteration count, or a fixed number of cell updates */
+				j = iterations;
+				if (j <= 0)
+				{
+					j = work/k;
+					if (j < 10)
+						j = 10;
+				}
+
+				ret = RunCase(&Data, j, &Bench[nCases]);
+				if (ret != -1)
+					nCases++;
+			}
+		}
+	}
+
+	/* Report and store */
+	outFile = fopen(outFileName, "w");
+	if (outFile == NULL)
+	{
+		fprintf(stderr, "ERROR in function Bench: Could not open '%s'.\n", outFileName);
+		ret = -1;
+	}
+	else
+		fprintf(outFile, "# kernel         im iterations    seconds ns/cell     GB/s      it/s   residual flux\n");
+
+	printf("\nScheme Kernel Flux            im Iterations  ns/cell     GB/s         it/s   vs base\n");
+	for (i=0; i<nCases; i++)
+	{
+		printf("     %c %-6s %-7s %10d %10d %8.2f %8.2f %12.1f", Bench[i].scheme, kernelNames[Bench[i].kernel],
+		       Bench[i].scheme == 'C' ? "-" : FluxName(Bench[i].flux), Bench[i].im, Bench[i].iterations, Bench[i].nsPerCell, Bench[i].bandwidth,
+		       Bench[i].itPerSec);
+
+		for (j=0; j<nBase; j++)
+		{
+			if (Base[j].scheme == Bench[i].scheme && Base[j].flux == Bench[i].flux && Base[j].im == Bench[i].im)
+			{
+				printf("   %6.2fx", Base[j].nsPerCell/Bench[i].nsPerCell);
+				break;
+			}
+		}
+		if (Bench[i].kernel == KERNEL_SIMD && Bench[i].scheme != 'C')
+			printf("   (%g ulp)", Bench[i].ulp);
+		printf("\n");
+
+		if (outFile)
+			fprintf(outFile, "%c %-6s %10d %10d %10.4f %7.2f %8.3f %9.1f %10.3e %s\n", Bench[i].scheme,
+			        kernelNames[Bench[i].kernel], Bench[i].im,
+			        Bench[i].iterations, Bench[i].seconds, Bench[i].nsPerCell, Bench[i].bandwidth,
+			        Bench[i].itPerSec, Bench[i].residual, FluxName(Bench[i].flux));
+	}
+
+	/* The fluxes solved to convergence */
+	if (nConverge > 0)
+	{
+		printf("\nScheme Flux    flops/interface         im  us/iteration  iterations   residual\n");
+		for (i=0; i<nConverge; i++)
+		{
+			printf("     %c %-7s %15d %10d %13.2f", Converge[i].scheme, FluxName(Converge[i].flux),
+			       FluxFlops(Converge[i].flux), Converge[i].im, Converge[i].usPerIt);
+
+			if (Converge[i].iterations == -1)
+				printf("  not conv.");
+			else
+				printf(" %11d", Converge[i].iterations);
+
+			printf(" %10.3e\n", Converge[i].residual);
+		}
+	}
+
+	if (outFile)
+	{
+		fclose(outFile);
+		printf("\nResults written to %s\n", outFileName);
+	}
+
+	return ret;
+}
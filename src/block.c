@@ -0,0 +1,722 @@
+/*
+** Domain decomposition
+**    Splits the grid into one contiguous block of cells per
+**    thread. The threads are started once per solve and wait on
+**    a barrier between the iterations. An iteration runs in
+**    three phases, separated by barriers:
+**
+**      1. E and H in the own cells, and the smallest timestep,
+**      2. MacCormack predictor, or the Roe interface fluxes,
+**      3. MacCormack corrector, or the conservative update.
+**
+**    The blocks share the arrays of the workspace, so the halo
+**    of a block is read in place from its neighbours; the
+**    barriers make sure it is up to date. The widest halo is
+**    that of MUSCL, cells i-1..i+2 for the interface right of
+**    cell i; CalcAV needs i-1..i+1.
+**
+**    All Roe fluxes are computed from the old field before any
+**    cell is updated (Jacobi, as in RoeBatch), so the field does
+**    not depend on the number of threads. The blocks consist of
+**    whole chunks of BLOCK_CHUNK cells; the residual is summed
+**    per chunk and the chunk sums in chunk order, so it does not
+**    depend on the number of threads either.
+**
+** Author:   J.L. Klaufus
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "main.h"
+#include "av.h"
+#include "block.h"
+#include "eh.h"
+#include "maccormack.h"
+#include "norms.h"
+#include "roe.h"
+#include "roebatch.h"
+#include "schemes.h"
+#include "timestep.h"
+#include "trace.h"
+
+typedef struct
+{
+	pthread_mutex_t lock;
+	pthread_cond_t  cond;
+	int             count;
+	int             arrived;
+	int             cycle;
+} tBarrier;
+
+typedef struct sBlocks tBlocks;
+
+/* The phases of one iteration in one block */
+typedef int (*tPhases)(tBlocks*, int);
+
+typedef struct
+{
+	tBlocks *Blocks;
+	int     id;
+} tBlockThread;
+
+struct sBlocks
+{
+	int          nThreads;
+	int          nChunks;
+	int          isa;
+	int          stop;
+
+	tPhases      phases;
+	tData        *Data;
+	tResult      *Result;
+
+	tBarrier     barrier;
+	pthread_t    *threads;
+	tBlockThread *args;
+
+	int          *status;
+	double       *timeSteps;
+	double       *chunkResidual;
+	double       *chunkNorms;    /* NORMS per chunk */
+};
+
+/*
+** Function Wait
+**    Barrier of all threads of the blocks. Unlike a
+**    pthread_barrier_t, the number of threads can be lowered
+**    while the first threads are already waiting.
+*/
+
+static void Wait(tBarrier *Barrier)
+{
+	int cycle;
+
+	pthread_mutex_lock(&Barrier->lock);
+
+	cycle = Barrier->cycle;
+	if (++Barrier->arrived >= Barrier->count)
+	{
+		Barrier->arrived = 0;
+		Barrier->cycle++;
+		pthread_cond_broadcast(&Barrier->cond);
+	}
+	else
+		while (cycle == Barrier->cycle)
+			pthread_cond_wait(&Barrier->cond, &Barrier->lock);
+
+	pthread_mutex_unlock(&Barrier->lock);
+}
+
+/*
+** Function Range
+**    First chunk, last chunk (exclusive), first cell and last
+**    cell (exclusive) of the block of thread id.
+*/
+
+static void Range(tBlocks *Blocks, int id, int *c0, int *c1, int *first, int *last)
+{
+	*c0    = (int)((long long)Blocks->nChunks*id/Blocks->nThreads);
+	*c1    = (int)((long long)Blocks->nChunks*(id+1)/Blocks->nThreads);
+	*first = *c0*BLOCK_CHUNK;
+	*last  = *c1*BLOCK_CHUNK;
+
+	if (*last > Blocks->Result->im)
+		*last = Blocks->Result->im;
+}
+
+/*
+** Function EHTimeStep
+**    Phase 1: E and H in the cells [first, last) and the
+**    smallest timestep of the inner cells among them; with
+**    local time stepping also their own timesteps. Returns
+**    after the barrier, with the smallest timestep of all
+**    blocks.
+*/
+
+static int EHTimeStep(tBlocks *Blocks, int id, int first, int last, double *timeStep)
+{
+	int     ret;
+	int     i, im, t;
+	double  gamma, CFL;
+	double  E[3], H2, p;
+	double  localTimeStep, minTimeStep;
+	tResult *Result = Blocks->Result;
+
+	ret         = 0;
+	im          = Result->im;
+	gamma       = Blocks->Data->gamma;
+	CFL         = Blocks->Data->CFL;
+	minTimeStep = HUGE_VAL;
+
+	for (i=first; i<last; i++)
+	{
+		NodeEH(gamma, Result->Q1[i], Result->Q2[i], Result->Q3[i],
+		       Result->A[i], Result->invA[i], Result->dA_dx[i], E, &H2, &p);
+
+		Result->E1[i] = E[0];
+		Result->E2[i] = E[1];
+		Result->E3[i] = E[2];
+		Result->H2[i] = H2;
+
+		TRACE(TRACE_EH, TRACE_CELL, TRACE_EV_EH, i, E[0], E[1], E[2], H2);
+
+		if (i > 0 && i < im-1)
+		{
+			if (CellTimeStep(gamma, CFL, Result->dx[i], Result->invA[i],
+			                 Result->Q1[i], Result->Q2[i], Result->Q3[i], &localTimeStep) == -1)
+			{
+				TRACE(TRACE_TIMESTEP, TRACE_ERROR, TRACE_EV_ERROR, i, Result->Q1[i], Result->Q2[i], Result->Q3[i], 0);
+				ret = -1;
+			}
+			else
+			{
+				if (Result->dt)
+					Result->dt[i] = localTimeStep;
+
+				if (localTimeStep < minTimeStep)
+					minTimeStep = localTimeStep;
+			}
+		}
+	}
+
+	/* Cells 0 and 1 are in the first chunk, of thread 0 */
+	if (Result->dt && first == 0 && im > 2)
+		Result->dt[0] = Result->dt[1];
+
+	Blocks->timeSteps[id] = minTimeStep;
+
+	Wait(&Blocks->barrier);
+
+	/* The minimum is exact, so every thread finds the same timestep */
+	*timeStep = HUGE_VAL;
+	for (t=0; t<Blocks->nThreads; t++)
+		if (Blocks->timeSteps[t] < *timeStep)
+			*timeStep = Blocks->timeSteps[t];
+
+	if (id == 0)
+	{
+		Result->timeStep = *timeStep;
+		TRACE(TRACE_TIMESTEP, TRACE_CALL, TRACE_EV_TIMESTEP, -1, *timeStep, 0, 0, 0);
+	}
+
+	return ret;
+}
+
+/*
+** Function RoePhases
+**    One Roe iteration in the block of thread id; compiled once
+**    per reconstruction. The interface right of cell i belongs
+**    to the block of cell i.
+*/
+
+__attribute__((always_inline))
+static inline int RoePhases(tBlocks *Blocks, int id, const int recon)
+{
+	int     ret;
+	int     i, im, n, c;
+	int     c0, c1, first, last, lo, hi;
+	double  timeStep, tau;
+	double  rhoBefore, rhoAfter, Q2Before, Q3Before, sum;
+	double  *norms;
+	double  *L[3], *R[3];
+	double  *F1, *F2, *F3;
+	tData   *Data   = Blocks->Data;
+	tResult *Result = Blocks->Result;
+
+	tConservative left, right;
+
+	im = Result->im;
+	Range(Blocks, id, &c0, &c1, &first, &last);
+
+	F1 = Result->scratch[6];
+	F2 = Result->scratch[7];
+	F3 = Result->scratch[8];
+
+	/* Phase 1 */
+	ret = EHTimeStep(Blocks, id, first, last, &timeStep);
+
+	/* Phase 2: the fluxes through the interfaces [first, last), reading the halo i-1..i+2 */
+	n = (last < im-1 ? last : im-1) - first;
+	if (n > 0)
+	{
+		if (recon == RECON_CONSTANT)
+		{
+			L[0] = Result->Q1;   L[1] = Result->Q2;   L[2] = Result->Q3;
+			R[0] = Result->Q1+1; R[1] = Result->Q2+1; R[2] = Result->Q3+1;
+		}
+		else
+		{
+			L[0] = Result->scratch[0]; L[1] = Result->scratch[1]; L[2] = Result->scratch[2];
+			R[0] = Result->scratch[3]; R[1] = Result->scratch[4]; R[2] = Result->scratch[5];
+
+			for (i=first; i<first+n; i++)
+			{
+				Reconstruct(recon, Data->gamma, Data->kappa, im, Result->Q1, Result->Q2, Result->Q3, i,
+				            &left, &right);
+
+				L[0][i] = left.Q1;  L[1][i] = left.Q2;  L[2][i] = left.Q3;
+				R[0][i] = right.Q1; R[1][i] = right.Q2; R[2][i] = right.Q3;
+			}
+		}
+
+		RoeFluxBatch(Blocks->isa, n, Data->gamma, Data->epsilon,
+		             L[0]+first, L[1]+first, L[2]+first, R[0]+first, R[1]+first, R[2]+first,
+		             Result->E1+first, Result->E2+first, Result->E3+first, F1+first, F2+first, F3+first);
+	}
+
+	Wait(&Blocks->barrier);
+
+	/* Phase 3: update of the own inner cells, reading the flux left of the block */
+	for (c=c0; c<c1; c++)
+	{
+		lo  = (c*BLOCK_CHUNK > 1) ? c*BLOCK_CHUNK : 1;
+		hi  = ((c+1)*BLOCK_CHUNK < im-1) ? (c+1)*BLOCK_CHUNK : im-1;
+		sum = 0;
+
+		norms = Blocks->chunkNorms + c*NORMS;
+		ClearNorms(norms);
+
+		if (Result->monitor == NULL)
+			norms = NULL;
+
+		for (i=lo; i<hi; i++)
+		{
+			/* Use density for residual calculation */
+			rhoBefore = Result->Q1[i]*Result->invA[i];
+			Q2Before  = Result->Q2[i];
+			Q3Before  = Result->Q3[i];
+
+			/* Local time stepping: the timestep of the node */
+			if (Result->dt)
+				timeStep = Result->dt[i];
+
+			tau = timeStep/Result->dx[i];
+			Result->Q1[i] += -tau*(F1[i] - F1[i-1]);
+			Result->Q2[i] += -tau*(F2[i] - F2[i-1]) + timeStep*Result->H2[i];
+			Result->Q3[i] += -tau*(F3[i] - F3[i-1]);
+
+			/* Calculate the residual and the norms */
+			rhoAfter = Result->Q1[i]*Result->invA[i];
+			sum     += AddNorms(norms, (rhoAfter-rhoBefore)/timeStep,
+			                    Result->Q2[i]-Q2Before, Result->Q3[i]-Q3Before, Result->invA[i]/timeStep);
+		}
+
+		Blocks->chunkResidual[c] = sum;
+	}
+
+	/* Trace the new field */
+	if (TRACE_ON(TRACE_SOLVER, TRACE_CELL))
+		for (i=first; i<last; i++)
+			TRACE(TRACE_SOLVER, TRACE_CELL, TRACE_EV_FIELD, i, Result->Q1[i], Result->Q2[i], Result->Q3[i], 0);
+
+	return ret;
+}
+
+static int RoeConstantPhases(tBlocks *Blocks, int id)
+{
+	return RoePhases(Blocks, id, RECON_CONSTANT);
+}
+
+static int RoeVanLeerPhases(tBlocks *Blocks, int id)
+{
+	return RoePhases(Blocks, id, RECON_VANLEER);
+}
+
+static int RoeVanAlbadaPhases(tBlocks *Blocks, int id)
+{
+	return RoePhases(Blocks, id, RECON_VANALBADA);
+}
+
+static int RoeKappaPhases(tBlocks *Blocks, int id)
+{
+	return RoePhases(Blocks, id, RECON_KAPPA);
+}
+
+/*
+** Function MacCormackPhases
+**    One MacCormack iteration in the block of thread id; the
+**    same operations as MacCormack.
+*/
+
+static int MacCormackPhases(tBlocks *Blocks, int id)
+{
+	int     ret;
+	int     i, im, c;
+	int     c0, c1, first, last, lo, hi;
+	double  A, invA, rho, e, p, u;
+	double  gamma, epsilon;
+	double  timeStep, tau;
+	double  rhoBefore, rhoAfter, Q2Before, Q3Before, sum;
+	double  *norms;
+	double  *Q1_b, *Q2_b, *Q3_b;
+	double  *Q1_bb, *Q2_bb, *Q3_bb;
+	double  *E1_b, *E2_b, *E3_b;
+	double  *H2_b;
+	tAV     AV;
+	tResult *Result = Blocks->Result;
+
+	im      = Result->im;
+	gamma   = Blocks->Data->gamma;
+	epsilon = Blocks->Data->epsilon;
+	Range(Blocks, id, &c0, &c1, &first, &last);
+
+	AV.D1 = AV.D2 = AV.D3 = 0;
+
+	Q1_b  = Result->scratch[0];
+	Q2_b  = Result->scratch[1];
+	Q3_b  = Result->scratch[2];
+
+	Q1_bb = Result->scratch[3];
+	Q2_bb = Result->scratch[4];
+	Q3_bb = Result->scratch[5];
+
+	E1_b  = Result->scratch[6];
+	E2_b  = Result->scratch[7];
+	E3_b  = Result->scratch[8];
+
+	H2_b  = Result->scratch[9];
+
+	/* Phase 1 */
+	ret = EHTimeStep(Blocks, id, first, last, &timeStep);
+
+	/* Phase 2: predictor in [first, last) of [0, im-2], reading the halo i-1..i+1 */
+	for (i=first; i<last && i<im-1; i++)
+	{
+		/* Local time stepping: the timestep of the node */
+		if (Result->dt)
+			timeStep = Result->dt[i];
+
+		tau = timeStep/(Result->x[i+1] - Result->x[i]);
+
+		/* Calculate artificial viscosity */
+		if (CalcAV(gamma, epsilon, i, im, Result->A[i], Result->Q1, Result->Q2, Result->Q3, &AV) == -1)
+			ret = -1;
+
+		/* Calculate Q-bar */
+		Q1_b[i] = Result->Q1[i] - tau*(Result->E1[i+1]-Result->E1[i]) + tau*AV.D1;
+		Q2_b[i] = Result->Q2[i] - tau*(Result->E2[i+1]-Result->E2[i]) + tau*AV.D2 + timeStep*Result->H2[i];
+		Q3_b[i] = Result->Q3[i] - tau*(Result->E3[i+1]-Result->E3[i]) + tau*AV.D3;
+
+		/* Get primitives */
+		A    = Result->A[i];
+		invA = Result->invA[i];
+		rho  = Q1_b[i]*invA;
+		u    = Q2_b[i]/Q1_b[i];
+		e    = Q3_b[i]*invA;
+		p    = (e-0.5*rho*u*u)*(gamma-1);
+
+		/* Calculate E-bar and H-bar */
+		E1_b[i] = rho*u*A;
+		E2_b[i] = (rho*u*u+p)*A;
+		E3_b[i] = u*(e+p)*A;
+		H2_b[i] = p*Result->dA_dx[i]*invA;
+	}
+
+	Wait(&Blocks->barrier);
+
+	/* Phase 3: corrector in the own inner cells, reading the halo i-1..i+1 of the predictor */
+	for (c=c0; c<c1; c++)
+	{
+		lo  = (c*BLOCK_CHUNK > 1) ? c*BLOCK_CHUNK : 1;
+		hi  = ((c+1)*BLOCK_CHUNK < im-1) ? (c+1)*BLOCK_CHUNK : im-1;
+		sum = 0;
+
+		norms = Blocks->chunkNorms + c*NORMS;
+		ClearNorms(norms);
+
+		if (Result->monitor == NULL)
+			norms = NULL;
+
+		for (i=lo; i<hi; i++)
+		{
+			if (Result->dt)
+				timeStep = Result->dt[i];
+
+			tau = timeStep/(Result->x[i] - Result->x[i-1]);
+
+			/* Calculate artificial viscosity */
+			if (CalcAV(gamma, epsilon, i, im-1, Result->A[i], Q1_b, Q2_b, Q3_b, &AV) == -1)
+				ret = -1;
+
+			/* Calculate Q-double-bar */
+			Q1_bb[i] = Result->Q1[i] - tau*(E1_b[i]-E1_b[i-1]) + tau*AV.D1;
+			Q2_bb[i] = Result->Q2[i] - tau*(E2_b[i]-E2_b[i-1]) + tau*AV.D2 + timeStep*H2_b[i];
+			Q3_bb[i] = Result->Q3[i] - tau*(E3_b[i]-E3_b[i-1]) + tau*AV.D3;
+
+			/* Use density for residual calculation */
+			rhoBefore = Result->Q1[i]*Result->invA[i];
+			Q2Before  = Result->Q2[i];
+			Q3Before  = Result->Q3[i];
+
+			/* Calculate Q at the new timestep */
+			Result->Q1[i] = 0.5*(Q1_b[i] + Q1_bb[i]);
+			Result->Q2[i] = 0.5*(Q2_b[i] + Q2_bb[i]);
+			Result->Q3[i] = 0.5*(Q3_b[i] + Q3_bb[i]);
+
+			/* Calculate the residual and the norms */
+			rhoAfter = Result->Q1[i]*Result->invA[i];
+			sum     += AddNorms(norms, (rhoAfter-rhoBefore)/timeStep,
+			                    Result->Q2[i]-Q2Before, Result->Q3[i]-Q3Before, Result->invA[i]/timeStep);
+		}
+
+		Blocks->chunkResidual[c] = sum;
+	}
+
+	/* Trace the new field */
+	if (TRACE_ON(TRACE_SOLVER, TRACE_CELL))
+		for (i=first; i<last; i++)
+			TRACE(TRACE_SOLVER, TRACE_CELL, TRACE_EV_FIELD, i, Result->Q1[i], Result->Q2[i], Result->Q3[i], 0);
+
+	return ret;
+}
+
+/*
+** Function BlockThread
+**    Waits for an iteration, runs its phases in the own block
+**    and waits until all blocks are done.
+*/
+
+static void *BlockThread(void *arg)
+{
+	tBlockThread *Thread = arg;
+	tBlocks      *Blocks = Thread->Blocks;
+
+	for (;;)
+	{
+		Wait(&Blocks->barrier);
+		if (Blocks->stop)
+			break;
+
+		TRACE_ITERATION();
+		Blocks->status[Thread->id] = Blocks->phases(Blocks, Thread->id);
+
+		Wait(&Blocks->barrier);
+	}
+
+	return NULL;
+}
+
+/*
+** Function RunBlocks
+**    Runs one iteration on all blocks; the calling thread works
+**    on block 0.
+*/
+
+static int RunBlocks(tData *Data, tResult *Result, tPhases phases, double *residual)
+{
+	int     ret;
+	int     t, c;
+	tBlocks *Blocks = Result->blocks;
+
+	if (Blocks == NULL)
+	{
+		fprintf(stderr, "ERROR in function RunBlocks: Blocks are not started.\n");
+		return -1;
+	}
+
+	ret = 0;
+
+	Blocks->Data   = Data;
+	Blocks->phases = phases;
+
+	Wait(&Blocks->barrier);
+	Blocks->status[0] = phases(Blocks, 0);
+	Wait(&Blocks->barrier);
+
+	for (t=0; t<Blocks->nThreads; t++)
+		if (Blocks->status[t] == -1)
+			ret = -1;
+
+	/* In chunk order, whatever the number of threads */
+	*residual = 0;
+	ClearNorms(Result->norms);
+	for (c=0; c<Blocks->nChunks; c++)
+	{
+		*residual += Blocks->chunkResidual[c];
+		MergeNorms(Result->norms, Blocks->chunkNorms + c*NORMS);
+	}
+
+	return ret;
+}
+
+int BlockMacCormack(tData *Data, tResult *Result, double *residual)
+{
+	return RunBlocks(Data, Result, MacCormackPhases, residual);
+}
+
+int BlockRoeConstant(tData *Data, tResult *Result, double *residual)
+{
+	return RunBlocks(Data, Result, RoeConstantPhases, residual);
+}
+
+int BlockRoeVanLeer(tData *Data, tResult *Result, double *residual)
+{
+	return RunBlocks(Data, Result, RoeVanLeerPhases, residual);
+}
+
+int BlockRoeVanAlbada(tData *Data, tResult *Result, double *residual)
+{
+	return RunBlocks(Data, Result, RoeVanAlbadaPhases, residual);
+}
+
+int BlockRoeKappa(tData *Data, tResult *Result, double *residual)
+{
+	return RunBlocks(Data, Result, RoeKappaPhases, residual);
+}
+
+/*
+** Function StartBlocks
+**    Splits the grid into blocks of whole chunks and starts one
+**    thread per block, the calling thread included. There are
+**    no more blocks than chunks. If not all threads can be
+**    started, the grid is split over the threads that did.
+**
+** In:       FILE    log    = pointer to log file
+**           tData   Data   = structure containing all data
+** Out:      tResult Result = blocks are set
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StartBlocks(FILE *log, tData *Data, tResult *Result)
+{
+	int     ret;
+	int     t, started;
+	int     nThreads, nChunks;
+	tBlocks *Blocks;
+
+	ret = 0;
+	Result->blocks = NULL;
+
+	if (Data->threads <= 0)
+		return ret;
+
+	if (Result->nScratch < (Data->scheme == 'C' ? MACCORMACK_SCRATCH : ROEBATCH_SCRATCH))
+	{
+		fprintf(stderr, "ERROR in function StartBlocks: No workspace allocated.\n");
+		return -1;
+	}
+
+	nChunks  = (Result->im + BLOCK_CHUNK-1)/BLOCK_CHUNK;
+	nThreads = (Data->threads < nChunks) ? Data->threads : nChunks;
+
+	Blocks = calloc(1, sizeof(tBlocks));
+	if (Blocks)
+	{
+		Blocks->threads       = malloc(nThreads*sizeof(pthread_t));
+		Blocks->args          = malloc(nThreads*sizeof(tBlockThread));
+		Blocks->status        = calloc(nThreads, sizeof(int));
+		Blocks->timeSteps     = malloc(nThreads*sizeof(double));
+		Blocks->chunkResidual = calloc(nChunks, sizeof(double));
+		Blocks->chunkNorms    = calloc(nChunks*NORMS, sizeof(double));
+	}
+
+	if (Blocks == NULL || Blocks->threads == NULL || Blocks->args == NULL || Blocks->status == NULL ||
+	    Blocks->timeSteps == NULL || Blocks->chunkResidual == NULL || Blocks->chunkNorms == NULL)
+	{
+		fprintf(stderr, "ERROR in function StartBlocks: could not allocate memory...\n");
+		if (Blocks)
+		{
+			free(Blocks->threads);
+			free(Blocks->args);
+			free(Blocks->status);
+			free(Blocks->timeSteps);
+			free(Blocks->chunkResidual);
+			free(Blocks->chunkNorms);
+			free(Blocks);
+		}
+		return -1;
+	}
+
+	Blocks->nThreads = nThreads;
+	Blocks->nChunks  = nChunks;
+	Blocks->isa      = (Data->kernel == KERNEL_SIMD) ? Result->isa : ISA_SCALAR;
+	Blocks->Data     = Data;
+	Blocks->Result   = Result;
+
+	pthread_mutex_init(&Blocks->barrier.lock, NULL);
+	pthread_cond_init(&Blocks->barrier.cond, NULL);
+	Blocks->barrier.count   = nThreads;
+	Blocks->barrier.arrived = 0;
+	Blocks->barrier.cycle   = 0;
+
+	/* Thread 0 is the calling thread */
+	started = 1;
+	for (t=1; t<nThreads; t++)
+	{
+		Blocks->args[t].Blocks = Blocks;
+		Blocks->args[t].id     = t;
+
+		if (pthread_create(&Blocks->threads[t], NULL, BlockThread, &Blocks->args[t]) != 0)
+			break;
+		started++;
+	}
+
+	/* The started threads are still waiting for the first iteration */
+	if (started < nThreads)
+	{
+		fprintf(stderr, "WARNING: Only %d of %d threads started.\n", started, nThreads);
+
+		pthread_mutex_lock(&Blocks->barrier.lock);
+		Blocks->barrier.count = started;
+		Blocks->nThreads      = started;
+		pthread_mutex_unlock(&Blocks->barrier.lock);
+	}
+
+	Result->blocks = Blocks;
+
+	if (log)
+		fprintf(log, "\n   Blocks: %d threads, %d chunks of %d cells\n\n", Blocks->nThreads, nChunks, BLOCK_CHUNK);
+
+	return ret;
+}
+
+/*
+** Function StopBlocks
+**    Stops the threads of the blocks and frees them.
+**
+** In:       tResult Result = structure containing results
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StopBlocks(tResult *Result)
+{
+	int     ret;
+	int     t;
+	tBlocks *Blocks = Result->blocks;
+
+	ret = 0;
+
+	if (Blocks == NULL)
+		return ret;
+
+	Blocks->stop = 1;
+	Wait(&Blocks->barrier);
+
+	for (t=1; t<Blocks->nThreads; t++)
+		pthread_join(Blocks->threads[t], NULL);
+
+	pthread_mutex_destroy(&Blocks->barrier.lock);
+	pthread_cond_destroy(&Blocks->barrier.cond);
+
+	free(Blocks->threads);
+	free(Blocks->args);
+	free(Blocks->status);
+	free(Blocks->timeSteps);
+	free(Blocks->chunkResidual);
+	free(Blocks->chunkNorms);
+	free(Blocks);
+
+	Result->blocks = NULL;
+
+	return ret;
+}
@@ -0,0 +1,20 @@
+/*
+** Header-file for Block
+*/
+
+#ifndef BLOCK_H
+#define BLOCK_H
+
+/* Cells per chunk; the residual is summed per chunk, in chunk order */
+#define BLOCK_CHUNK 2048
+
+int StartBlocks(FILE*, tData*, tResult*);
+int StopBlocks(tResult*);
+
+int BlockMacCormack(tData*, tResult*, double*);
+int BlockRoeConstant(tData*, tResult*, double*);
+int BlockRoeVanLeer(tData*, tResult*, double*);
+int BlockRoeVanAlbada(tData*, tResult*, double*);
+int BlockRoeKappa(tData*, tResult*, double*);
+
+#endif
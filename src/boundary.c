@@ -14,8 +14,9 @@
 
 #include "main.h"
 #include "boundary.h"
+#include "trace.h"
 
-int Boundary(FILE *log, tData *Data, tResult *Result)
+int Boundary(tData *Data, tResult *Result)
 {
 	int ret;
 
@@ -64,45 +65,19 @@ int Boundary(FILE *log, tData *Data, tResult *Result)
 	rho3 = rho2 + (rho2-rho1)/(X2-X1)*(X3-X2);
 	p3   = p2   + (p2-p1)/(X2-X1)*(X3-X2);
 
+	/* Steep transients (e.g. multigrid corrections): constant extrapolation keeps rho and p positive */
+	if (rho3 <= 0 || p3 <= 0)
+	{
+		rho3 = rho2;
+		p3   = p2;
+	}
+
 	/* Store values */
 	Result->Q1[im] = rho3*A3;
 	Result->Q2[im] = rho3*A3*u3;
 	Result->Q3[im] = (0.5*rho3*u3*u3 + p3/(gamma-1))*A3;
 
-	/* Write report */
-	if (log)
-	{
-		fprintf(log, "\n***** FUNCTION BOUNDARY *****\n\n");
-
-		fprintf(log, "  X1   = %10.3f\n", X1);
-		fprintf(log, "  X2   = %10.3f\n", X2);
-		fprintf(log, "  X3   = %10.3f\n", X3);
-
-		fprintf(log, "  A1   = %10.3f\n", Result->A[im-2]);
-		fprintf(log, "  A2   = %10.3f\n", Result->A[im-1]);
-		fprintf(log, "  A3   = %10.3f\n", Result->A[im]);
-
-		fprintf(log, "  u1   = %10.3f\n", u1);
-		fprintf(log, "  u2   = %10.3f\n", u2);
-		fprintf(log, "  u3   = %10.3f\n", u3);
-
-		fprintf(log, "  rho1 = %10.3f\n", rho1);
-		fprintf(log, "  rho2 = %10.3f\n", rho2);
-		fprintf(log, "  rho3 = %10.3f\n", rho3);
-
-		fprintf(log, "  p1   = %10.3f\n", p1);
-		fprintf(log, "  p2   = %10.3f\n", p2);
-		fprintf(log, "  p3   = %10.3f\n", p3);
-
-		fprintf(log, "  Et1  = %10.3f\n", Et1);
-		fprintf(log, "  Et2  = %10.3f\n", Et2);
-
-		fprintf(log, "  Q1   = %10.3f\n", Result->Q1[im]);
-		fprintf(log, "  Q2   = %10.3f\n", Result->Q2[im]);
-		fprintf(log, "  Q3   = %10.3f\n", Result->Q3[im]);
-
-		fprintf(log, "\n*****************************\n\n");
-	}
+	TRACE(TRACE_BOUNDARY, TRACE_CALL, TRACE_EV_BOUNDARY, im, rho3, u3, p3, 0);
 
 	return ret;
 }
@@ -5,6 +5,6 @@
 #ifndef BOUNDARY_H
 #define BOUNDARY_H
 
-int Boundary(FILE*, tData*, tResult*);
+int Boundary(tData*, tResult*);
 
 #endif
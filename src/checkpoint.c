@@ -0,0 +1,279 @@
+/*
+** Checkpoint
+**    Snapshots of the flow field for restarts. A checkpoint is a
+**    header of CHECKPOINT_HEADER bytes followed by the arrays x,
+**    A, Q1, Q2 and Q3 of im doubles each, in the byte order of
+**    the machine that wrote it:
+**
+**      magic        8 bytes  CHECKPOINT_MAGIC
+**      version      int32    CHECKPOINT_VERSION
+**      im           int32    number of nodes
+**      iteration    int64    iterations done
+**      sweeps       int64    steps of the scheme done
+**      timeStep     double   smallest timestep of the last iteration
+**      normResidual double   residual of the first iteration
+**      residual     double   normalised residual of the last iteration
+**      length       double   length of the nozzle
+**
+**    A checkpoint is written to a temporary file which is then
+**    renamed, so a run killed while writing leaves the previous
+**    checkpoint intact. It is read through mmap: the arrays are
+**    used in place, without a copy into a buffer first.
+**
+** Author:   J.L. Klaufus
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "main.h"
+#include "boundary.h"
+#include "checkpoint.h"
+
+typedef struct
+{
+	char    magic[8];
+	int32_t version;
+	int32_t im;
+	int64_t iteration;
+	int64_t sweeps;
+	double  timeStep;
+	double  normResidual;
+	double  residual;
+	double  length;
+} tCheckpointHeader;
+
+/*
+** Function WriteCheckpoint
+**   Writes the flow field and the state of the iteration.
+**
+** In:       char    fileName     = name of the checkpoint
+**           tData   Data         = structure containing all data
+**           tResult Result       = structure containing results
+**           int     iteration    = iterations done
+**           double  normResidual = residual of the first iteration
+**           double  residual     = normalised residual
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int WriteCheckpoint(char *fileName, tData *Data, tResult *Result, int iteration, double normResidual, double residual)
+{
+	int    ret;
+	int    j;
+	size_t im;
+	char   tmpName[FILENAME_MAX];
+	char   header[CHECKPOINT_HEADER];
+	FILE   *file;
+	double *arrays[5];
+
+	tCheckpointHeader H;
+
+	ret = 0;
+	im  = (size_t)Data->im;
+
+	memset(&H, 0, sizeof(H));
+	memcpy(H.magic, CHECKPOINT_MAGIC, 8);
+	H.version      = CHECKPOINT_VERSION;
+	H.im           = Data->im;
+	H.iteration    = iteration;
+	H.sweeps       = Result->sweeps;
+	H.timeStep     = Result->timeStep;
+	H.normResidual = normResidual;
+	H.residual     = residual;
+	H.length       = Data->length;
+
+	memset(header, 0, CHECKPOINT_HEADER);
+	memcpy(header, &H, sizeof(H));
+
+	arrays[0] = Result->x;
+	arrays[1] = Result->A;
+	arrays[2] = Result->Q1;
+	arrays[3] = Result->Q2;
+	arrays[4] = Result->Q3;
+
+	snprintf(tmpName, sizeof(tmpName), "%s.tmp", fileName);
+
+	file = fopen(tmpName, "wb");
+	if (file == NULL)
+		ret = -1;
+
+	if (ret != -1 && fwrite(header, 1, CHECKPOINT_HEADER, file) != CHECKPOINT_HEADER)
+		ret = -1;
+
+	for (j=0; j<5 && ret!=-1; j++)
+		if (fwrite(arrays[j], sizeof(double), im, file) != im)
+			ret = -1;
+
+	if (file && fclose(file) != 0)
+		ret = -1;
+
+	if (ret != -1 && rename(tmpName, fileName) != 0)
+		ret = -1;
+
+	if (ret == -1)
+	{
+		fprintf(stderr, "ERROR in function WriteCheckpoint: Could not write '%s'.\n", fileName);
+		remove(tmpName);
+	}
+
+	return ret;
+}
+
+/*
+** Function Interpolate
+**    Value of Q/A of a checkpoint at position X, linear between
+**    its nodes and constant beyond its ends.
+*/
+
+static double Interpolate(int im, const double *x, const double *Q, const double *A, double X)
+{
+	int lo, hi, mid;
+
+	if (X <= x[0])
+		return Q[0]/A[0];
+	if (X >= x[im-1])
+		return Q[im-1]/A[im-1];
+
+	lo = 0;
+	hi = im-1;
+	while (hi - lo > 1)
+	{
+		mid = (lo + hi)/2;
+		if (x[mid] <= X)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return Q[lo]/A[lo] + (Q[hi]/A[hi] - Q[lo]/A[lo])*(X - x[lo])/(x[hi] - x[lo]);
+}
+
+/*
+** Function ReadCheckpoint
+**   Starts from the flow field of a checkpoint instead of the
+**   uniform field of Init, which must have been called. On the
+**   same grid the field is taken as it is, and the iteration
+**   continues where the checkpoint left it. On another grid
+**   rho, rho*u and Et are interpolated linearly in x and the
+**   iteration count starts at 0; the normalisation of the
+**   residual is always that of the checkpoint. The inlet keeps
+**   the values of the data-file and the exit is set by Boundary.
+**
+** In:       FILE    log          = pointer to log file
+**           char    fileName     = name of the checkpoint
+**           tData   Data         = structure containing all data
+** Out:      tResult Result       = field of the checkpoint
+**           int     iteration    = iterations done
+**           double  normResidual = residual of the first iteration
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int ReadCheckpoint(FILE *log, char *fileName, tData *Data, tResult *Result, int *iteration, double *normResidual)
+{
+	int    ret;
+	int    i, c, im, same;
+	int    fd;
+	size_t size;
+	void   *map;
+	double *x, *A, *Q[3], *Qn[3];
+
+	struct stat st;
+	tCheckpointHeader H;
+
+	ret = 0;
+	map = MAP_FAILED;
+	im  = 0;
+
+	fd = open(fileName, O_RDONLY);
+	if (fd == -1 || fstat(fd, &st) == -1)
+	{
+		fprintf(stderr, "ERROR in function ReadCheckpoint: Could not open '%s'.\n", fileName);
+		ret = -1;
+	}
+	else if ((size_t)st.st_size < CHECKPOINT_HEADER)
+		ret = -1;
+	else
+	{
+		map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED)
+			ret = -1;
+	}
+
+	if (ret != -1)
+	{
+		memcpy(&H, map, sizeof(H));
+		im   = H.im;
+		size = CHECKPOINT_HEADER + 5*(size_t)(im > 0 ? im : 0)*sizeof(double);
+
+		if (memcmp(H.magic, CHECKPOINT_MAGIC, 8) != 0 || H.version != CHECKPOINT_VERSION ||
+		    im < 3 || (size_t)st.st_size != size || H.normResidual <= 0)
+			ret = -1;
+	}
+
+	if (ret == -1 && fd != -1)
+		fprintf(stderr, "ERROR in function ReadCheckpoint: '%s' is not a checkpoint of this version.\n", fileName);
+
+	if (ret != -1)
+	{
+		x    = (double*)((char*)map + CHECKPOINT_HEADER);
+		A    = x + im;
+		Q[0] = A + im;
+		Q[1] = Q[0] + im;
+		Q[2] = Q[1] + im;
+
+		Qn[0] = Result->Q1;
+		Qn[1] = Result->Q2;
+		Qn[2] = Result->Q3;
+
+		same = (im == Data->im && memcmp(x, Result->x, im*sizeof(double)) == 0 &&
+		                          memcmp(A, Result->A, im*sizeof(double)) == 0);
+
+		/* Inner nodes; the inlet is a boundary condition of the data-file */
+		for (i=1; i<Data->im; i++)
+			for (c=0; c<3; c++)
+			{
+				if (same)
+					Qn[c][i] = Q[c][i];
+				else
+					Qn[c][i] = Interpolate(im, x, Q[c], A, Result->x[i])*Result->A[i];
+			}
+
+		*normResidual = H.normResidual;
+		*iteration    = same ? (int)H.iteration : 0;
+
+		if (same)
+			Result->sweeps = H.sweeps;
+
+		/* The first iteration calculates the timestep of this field */
+		Result->timeStep = 0;
+
+		ret = Boundary(Data, Result);
+
+		printf("Restarting from '%s': %s, iteration %d, residual %10.7f.\n", fileName,
+		       same ? "same grid" : "interpolated", (int)H.iteration, H.residual);
+
+		if (log)
+			fprintf(log, "\nRestart from '%s' (im = %d, iteration %ld, %s).\n\n", fileName, im,
+			        (long)H.iteration, same ? "same grid" : "interpolated");
+	}
+
+	if (map != MAP_FAILED)
+		munmap(map, (size_t)st.st_size);
+
+	if (fd != -1)
+		close(fd);
+
+	return ret;
+}
@@ -0,0 +1,20 @@
+/*
+** Header-file for Checkpoint
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#define CHECKPOINT_MAGIC   "NZCHKPT\0"
+#define CHECKPOINT_VERSION 1
+
+/* Size of the header; the arrays start at this offset */
+#define CHECKPOINT_HEADER  64
+
+/* Name of the checkpoint of a run */
+#define CHECKPOINT_FILE    "nozzle.chk"
+
+int WriteCheckpoint(char*, tData*, tResult*, int, double, double);
+int ReadCheckpoint(FILE*, char*, tData*, tResult*, int*, double*);
+
+#endif
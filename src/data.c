@@ -13,10 +13,585 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "main.h"
 #include "data.h"
+#include "extrapolate.h"
+#include "integrator.h"
+#include "multigrid.h"
+#include "newton.h"
+#include "norms.h"
+#include "result.h"
+#include "roe.h"
+#include "flux.h"
+#include "timestep.h"
+
+/*
+** Function DefaultData
+**   Sets the optional settings to their defaults. These are
+**   only changed by keywords following the fixed part of the
+**   data-file.
+**
+** In:       -
+** Out:      Data = structure containing all data
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void DefaultData(tData *Data)
+{
+	Data->limiter = LIMITER_VANLEER;
+	Data->flux    = FLUX_ROE;
+	Data->kernel  = KERNEL_SCALAR;
+	Data->isa     = ISA_AUTO;
+	Data->threads = 0;
+
+	Data->timeStepping  = TIMESTEP_GLOBAL;
+	Data->cflRamp       = 20;
+	Data->solver        = SOLVER_MARCH;
+	Data->newtonCFL     = 1000;
+	Data->irs           = 0;
+	Data->integrator    = INTEGRATOR_EULER;
+	Data->checkpoint    = 0;
+	Data->sequence      = 0;
+	Data->sequenceTol   = 1e-4;
+	Data->adapt         = 0;
+	Data->adaptStrength = 10;
+
+	Data->extrapolate      = 0;
+	Data->extrapolation    = EXTRAPOLATION_MPE;
+	Data->extrapolateEvery = 5;
+
+	Data->stopRule      = STOP_RESIDUAL;
+	Data->stopNorm      = NORM_L2;
+	Data->stopEquations = 1;
+	Data->stopTol       = SMALL;
+	Data->stopOutputs   = 1e-5;
+	Data->stopWindow    = 100;
+
+	Data->adjoint = ADJOINT_NONE;
+
+	Data->mgLevels = 1;
+	Data->mgCycle  = MGCYCLE_V;
+	Data->mgPre    = 1;
+	Data->mgPost   = 1;
+}
+
+/*
+** Function SetOption
+**   Sets one optional setting from its keyword and value.
+**
+** In:       key   = keyword
+**           value = value
+** Out:      Data  = structure containing all data
+** Return:   0 on success, -1 on an unknown keyword or value
+**
+** Author:   J.L. Klaufus
+*/
+
+int SetOption(tData *Data, char *key, char *value)
+{
+	int  ret;
+	char *end;
+
+	ret = 0;
+
+	if (strcmp(key, "limiter") == 0)
+	{
+		if (strcmp(value, "vanleer") == 0)
+			Data->limiter = LIMITER_VANLEER;
+		else if (strcmp(value, "vanalbada") == 0)
+			Data->limiter = LIMITER_VANALBADA;
+		else if (strcmp(value, "kappa") == 0)
+			Data->limiter = LIMITER_KAPPA;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "flux") == 0)
+	{
+		if (strcmp(value, "roe") == 0)
+			Data->flux = FLUX_ROE;
+		else if (strcmp(value, "hll") == 0)
+			Data->flux = FLUX_HLL;
+		else if (strcmp(value, "hllc") == 0)
+			Data->flux = FLUX_HLLC;
+		else if (strcmp(value, "ausm") == 0)
+			Data->flux = FLUX_AUSM;
+		else if (strcmp(value, "rusanov") == 0)
+			Data->flux = FLUX_RUSANOV;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "kernel") == 0)
+	{
+		if (strcmp(value, "scalar") == 0)
+			Data->kernel = KERNEL_SCALAR;
+		else if (strcmp(value, "fused") == 0)
+			Data->kernel = KERNEL_FUSED;
+		else if (strcmp(value, "simd") == 0)
+			Data->kernel = KERNEL_SIMD;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "isa") == 0)
+	{
+		if (strcmp(value, "auto") == 0)
+			Data->isa = ISA_AUTO;
+		else if (strcmp(value, "scalar") == 0)
+			Data->isa = ISA_SCALAR;
+		else if (strcmp(value, "avx2") == 0)
+			Data->isa = ISA_AVX2;
+		else if (strcmp(value, "avx512") == 0)
+			Data->isa = ISA_AVX512;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "threads") == 0)
+	{
+		Data->threads = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->threads < 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "timestep") == 0)
+	{
+		if (strcmp(value, "global") == 0)
+			Data->timeStepping = TIMESTEP_GLOBAL;
+		else if (strcmp(value, "local") == 0)
+			Data->timeStepping = TIMESTEP_LOCAL;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "cfl_ramp") == 0)
+	{
+		Data->cflRamp = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->cflRamp < 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "solver") == 0)
+	{
+		if (strcmp(value, "march") == 0)
+			Data->solver = SOLVER_MARCH;
+		else if (strcmp(value, "newton") == 0)
+			Data->solver = SOLVER_NEWTON;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "newton_cfl") == 0)
+	{
+		Data->newtonCFL = strtod(value, &end);
+		if (*end != '\0' || Data->newtonCFL <= 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "irs") == 0)
+	{
+		Data->irs = strtod(value, &end);
+		if (*end != '\0' || Data->irs < 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "integrator") == 0)
+	{
+		if (strcmp(value, "euler") == 0)
+			Data->integrator = INTEGRATOR_EULER;
+		else if (strcmp(value, "ssprk2") == 0)
+			Data->integrator = INTEGRATOR_SSPRK2;
+		else if (strcmp(value, "ssprk3") == 0)
+			Data->integrator = INTEGRATOR_SSPRK3;
+		else if (strcmp(value, "lsrk4") == 0)
+			Data->integrator = INTEGRATOR_LSRK4;
+		else if (strcmp(value, "lsrk5") == 0)
+			Data->integrator = INTEGRATOR_LSRK5;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "checkpoint") == 0)
+	{
+		Data->checkpoint = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->checkpoint < 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "sequence") == 0)
+	{
+		Data->sequence = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->sequence < 0 || Data->sequence > 20)
+			ret = -1;
+	}
+	else if (strcmp(key, "sequence_tol") == 0)
+	{
+		Data->sequenceTol = strtod(value, &end);
+		if (*end != '\0' || Data->sequenceTol <= 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "adapt") == 0)
+	{
+		Data->adapt = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->adapt < 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "adapt_strength") == 0)
+	{
+		Data->adaptStrength = strtod(value, &end);
+		if (*end != '\0' || Data->adaptStrength < 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "extrapolate") == 0)
+	{
+		Data->extrapolate = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->extrapolate < 0 || Data->extrapolate > EXTRAPOLATE_MAX)
+			ret = -1;
+	}
+	else if (strcmp(key, "extrapolation") == 0)
+	{
+		if (strcmp(value, "rre") == 0)
+			Data->extrapolation = EXTRAPOLATION_RRE;
+		else if (strcmp(value, "mpe") == 0)
+			Data->extrapolation = EXTRAPOLATION_MPE;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "extrapolate_every") == 0)
+	{
+		Data->extrapolateEvery = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->extrapolateEvery < 1)
+			ret = -1;
+	}
+	else if (strcmp(key, "adjoint") == 0)
+	{
+		if (strcmp(value, "none") == 0)
+			Data->adjoint = ADJOINT_NONE;
+		else if (strcmp(value, "thrust") == 0)
+			Data->adjoint = ADJOINT_THRUST;
+		else if (strcmp(value, "mach") == 0)
+			Data->adjoint = ADJOINT_MACH;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "stop_rule") == 0)
+	{
+		if (strcmp(value, "residual") == 0)
+			Data->stopRule = STOP_RESIDUAL;
+		else if (strcmp(value, "outputs") == 0)
+			Data->stopRule = STOP_OUTPUTS;
+		else if (strcmp(value, "any") == 0)
+			Data->stopRule = STOP_ANY;
+		else if (strcmp(value, "all") == 0)
+			Data->stopRule = STOP_ALL;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "stop_norm") == 0)
+	{
+		if (strcmp(value, "l1") == 0)
+			Data->stopNorm = NORM_L1;
+		else if (strcmp(value, "l2") == 0)
+			Data->stopNorm = NORM_L2;
+		else if (strcmp(value, "linf") == 0)
+			Data->stopNorm = NORM_LINF;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "stop_equations") == 0)
+	{
+		if (strcmp(value, "density") == 0)
+			Data->stopEquations = 1;
+		else if (strcmp(value, "all") == 0)
+			Data->stopEquations = 3;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "stop_tol") == 0)
+	{
+		Data->stopTol = strtod(value, &end);
+		if (*end != '\0' || Data->stopTol <= 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "stop_outputs") == 0)
+	{
+		Data->stopOutputs = strtod(value, &end);
+		if (*end != '\0' || Data->stopOutputs <= 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "stop_window") == 0)
+	{
+		Data->stopWindow = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->stopWindow < 1)
+			ret = -1;
+	}
+	else if (strcmp(key, "mg_levels") == 0)
+	{
+		Data->mgLevels = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->mgLevels < 1)
+			ret = -1;
+	}
+	else if (strcmp(key, "mg_cycle") == 0)
+	{
+		if (strcmp(value, "v") == 0)
+			Data->mgCycle = MGCYCLE_V;
+		else if (strcmp(value, "w") == 0)
+			Data->mgCycle = MGCYCLE_W;
+		else
+			ret = -1;
+	}
+	else if (strcmp(key, "mg_pre") == 0)
+	{
+		Data->mgPre = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->mgPre < 0)
+			ret = -1;
+	}
+	else if (strcmp(key, "mg_post") == 0)
+	{
+		Data->mgPost = (int)strtol(value, &end, 10);
+		if (*end != '\0' || Data->mgPost < 0)
+			ret = -1;
+	}
+	else
+		ret = -1;
+
+	if (ret == -1)
+		fprintf(stderr, "ERROR in function ReadData: Invalid setting '%s %s'.\n", key, value);
+
+	return ret;
+}
+
+/*
+** Function Shock
+**   A supersonic inlet and an exit velocity below that of the
+**   inlet: the flow has a shock.
+*/
+
+static int Shock(tData *Data)
+{
+	double u_start;
+
+	u_start = Data->M_start*sqrt(Data->gamma*Data->p_start/Data->rho_start);
+
+	return Data->M_start > 1 && Data->u_exit < u_start;
+}
+
+/*
+** Function CheckOptions
+**   Drops the optional settings the scheme does not support:
+**   the implicit scheme has one kernel, is not split into
+**   blocks and is no multigrid smoother; the Newton-Krylov
+**   solver needs an explicit scheme and has no coarse grids.
+**   MacCormack and MUSCL-Roe use at most 2 multigrid levels,
+**   a flow with a shock at most 4. MacCormack with local time
+**   stepping needs a CFL below 1.
+**   Neither smooths the residual. The multistage integrators
+**   and the interface fluxes other than Roe's are for schemes
+**   R and M, with the scalar kernel.
+**
+** In:       Data = structure containing all data
+** Out:      Data = structure containing all data
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void CheckOptions(tData *Data)
+{
+	if (Data->scheme == 'I' && (Data->kernel != KERNEL_SCALAR || Data->threads > 0 || Data->mgLevels > 1))
+	{
+		fprintf(stderr, "WARNING: scheme I ignores the kernel, threads and mg_levels settings.\n");
+		Data->kernel   = KERNEL_SCALAR;
+		Data->threads  = 0;
+		Data->mgLevels = 1;
+	}
+
+	if (Data->integrator != INTEGRATOR_EULER && (Data->scheme == 'C' || Data->scheme == 'I' || Data->solver == SOLVER_NEWTON))
+	{
+		fprintf(stderr, "WARNING: schemes C and I and solver newton ignore the integrator setting.\n");
+		Data->integrator = INTEGRATOR_EULER;
+	}
+
+	if (Data->integrator != INTEGRATOR_EULER && (Data->kernel != KERNEL_SCALAR || Data->threads > 0))
+	{
+		fprintf(stderr, "WARNING: integrator %s ignores the kernel and threads settings.\n", IntegratorName(Data->integrator));
+		Data->kernel  = KERNEL_SCALAR;
+		Data->threads = 0;
+	}
+
+	if (Data->flux != FLUX_ROE && (Data->scheme == 'C' || Data->scheme == 'I'))
+	{
+		fprintf(stderr, "WARNING: schemes C and I ignore the flux setting.\n");
+		Data->flux = FLUX_ROE;
+	}
+
+	if (Data->flux != FLUX_ROE && (Data->kernel != KERNEL_SCALAR || Data->threads > 0))
+	{
+		fprintf(stderr, "WARNING: flux %s ignores the kernel and threads settings.\n", FluxName(Data->flux));
+		Data->kernel  = KERNEL_SCALAR;
+		Data->threads = 0;
+	}
+
+	if (Data->irs > 0 && (Data->scheme == 'I' || Data->solver == SOLVER_NEWTON))
+	{
+		fprintf(stderr, "WARNING: scheme I and solver newton ignore the irs setting.\n");
+		Data->irs = 0;
+	}
+
+	if (Data->solver == SOLVER_NEWTON && Data->scheme == 'I')
+	{
+		fprintf(stderr, "WARNING: scheme I ignores solver newton.\n");
+		Data->solver = SOLVER_MARCH;
+	}
+
+	if (Data->solver == SOLVER_NEWTON && Data->mgLevels > 1)
+	{
+		fprintf(stderr, "WARNING: solver newton ignores the mg_levels setting.\n");
+		Data->mgLevels = 1;
+	}
+
+	if (Data->solver == SOLVER_NEWTON && Data->scheme == 'C' && Data->newtonCFL > NEWTON_CFL_C)
+	{
+		fprintf(stderr, "WARNING: scheme C with solver newton uses newton_cfl %g instead of %g.\n",
+		        (double)NEWTON_CFL_C, Data->newtonCFL);
+		Data->newtonCFL = NEWTON_CFL_C;
+	}
+
+	if (Data->timeStepping == TIMESTEP_LOCAL && Data->scheme == 'C' && Data->CFL > TIMESTEP_LOCAL_CFL_C)
+	{
+		fprintf(stderr, "WARNING: scheme C with timestep local uses CFL %g instead of %g.\n",
+		        TIMESTEP_LOCAL_CFL_C, Data->CFL);
+		Data->CFL = TIMESTEP_LOCAL_CFL_C;
+	}
+
+	if (Data->mgLevels > MULTIGRID_LEVELS_CM && (Data->scheme == 'C' || Data->scheme == 'M'))
+	{
+		fprintf(stderr, "WARNING: schemes C and M use at most %d multigrid levels.\n", MULTIGRID_LEVELS_CM);
+		Data->mgLevels = MULTIGRID_LEVELS_CM;
+	}
+
+	if (Data->mgLevels > MULTIGRID_LEVELS_SHOCK && Shock(Data))
+	{
+		fprintf(stderr, "WARNING: a flow with a shock uses at most %d multigrid levels.\n", MULTIGRID_LEVELS_SHOCK);
+		Data->mgLevels = MULTIGRID_LEVELS_SHOCK;
+	}
+
+	if (Data->adapt > 0 && (Data->scheme == 'C' || Data->solver == SOLVER_NEWTON || Data->mgLevels > 1))
+	{
+		fprintf(stderr, "WARNING: scheme C, solver newton and multigrid ignore the adapt setting.\n");
+		Data->adapt = 0;
+	}
+
+	if (Data->extrapolate > 0 && (Data->solver == SOLVER_NEWTON || Data->mgLevels > 1 || Data->adapt > 0))
+	{
+		fprintf(stderr, "WARNING: solver newton, multigrid and adapt ignore the extrapolate setting.\n");
+		Data->extrapolate = 0;
+	}
+}
+
+/*
+** Function ReadOptions
+**   Reads the optional settings following the fixed part of
+**   the data-file; one 'keyword value' pair per line:
+**
+**     limiter vanleer|vanalbada|kappa
+**                            limiter of the MUSCL-scheme; kappa
+**                            uses the kappa of the fixed part
+**     flux    roe|hll|hllc|ausm|rusanov
+**                            interface flux of schemes R and M:
+**                            Roe (default), HLL, HLLC, AUSM+ or
+**                            Rusanov
+**     kernel  scalar|fused|simd
+**                            separate passes (default), one fused
+**                            sweep per iteration, or batched SIMD
+**                            Roe fluxes
+**     isa     auto|scalar|avx2|avx512
+**                            instruction set of the SIMD kernel;
+**                            auto (default) checks the processor
+**     threads N              split the grid into blocks over N
+**                            threads; 0 (default) is not split
+**     timestep global|local  smallest timestep of all nodes
+**                            (default), or the timestep of each
+**                            node for steady-state runs
+**     cfl_ramp N             steps of the implicit scheme in which
+**                            the CFL grows to the CFL of the
+**                            fixed part (default 20)
+**     solver  march|newton   march in time with the scheme
+**                            (default), or solve the steady
+**                            state with Newton-Krylov
+**     newton_cfl X           CFL the start-up of solver newton
+**                            grows to in cfl_ramp steps
+**                            (default 1000; 20 at most for
+**                            scheme C)
+**     integrator euler|ssprk2|ssprk3|lsrk4|lsrk5
+**                            time integration of schemes R and M:
+**                            forward Euler (default), SSP
+**                            Runge-Kutta or low storage steady
+**                            state Runge-Kutta
+**     irs     X              coefficient of the implicit residual
+**                            smoothing; 0 (default) is none
+**     checkpoint N           write nozzle.chk every N iterations
+**                            and at the end; 0 (default) is none
+**     sequence N             solve first on N coarser grids of
+**                            (im-1)/2^k + 1 nodes; 0 (default) is
+**                            no grid sequencing
+**     sequence_tol X         tolerance of the coarse grids
+**                            (default 1e-4)
+**     adapt   N              move the nodes towards the shock
+**                            every N iterations; 0 (default) is
+**                            a fixed uniform grid
+**     adapt_strength X       the spacing at the shock is about
+**                            1+X times smaller than elsewhere
+**                            (default 10)
+**     extrapolate N          extrapolate the field from every
+**                            N+1 iterates; 0 (default) is none
+**     extrapolate_every N    take an iterate every N iterations
+**                            into the window (default 5)
+**     stop_rule residual|outputs|any|all
+**                            stop on the residual (default), on
+**                            the outputs, on either or on both
+**     stop_norm l1|l2|linf   norm of the residual (default l2)
+**     stop_equations density|all
+**                            equations of the residual (default
+**                            density)
+**     stop_tol X             tolerance of the residual, relative
+**                            to the first iteration (default 1e-7)
+**     stop_outputs X         largest change of the outputs over
+**                            a window (default 1e-5)
+**     stop_window N          iterations of the window (default 100)
+**     extrapolation rre|mpe  reduced rank or minimal polynomial
+**                            (default) extrapolation
+**     adjoint none|thrust|mach
+**                            gradient of the thrust or the exit
+**                            Mach number to the area after the
+**                            run; none (default) is no gradient
+**     mg_levels N            grids of the FAS multigrid cycle;
+**                            1 (default) is no multigrid
+**     mg_cycle v|w           V-cycle (default) or W-cycle
+**     mg_pre N               smoothing steps before the coarse
+**                            grid correction (default 1)
+**     mg_post N              smoothing steps after it (default 1)
+**
+** In:       dataFile = opened data-file
+** Out:      Data     = structure containing all data
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+static int ReadOptions(FILE *dataFile, tData *Data)
+{
+	int  ret, n;
+	char key[50], value[50];
+
+	ret = 0;
+
+	while (ret != -1 && (n = fscanf(dataFile, "%49s %49s", key, value)) == 2)
+		ret = SetOption(Data, key, value);
+
+	/* A keyword without a value on the last line */
+	if (ret != -1 && n == 1)
+	{
+		fprintf(stderr, "ERROR in function ReadData: Invalid setting '%s'.\n", key);
+		ret = -1;
+	}
+
+	return ret;
+}
 
 int ReadData(FILE *log, char *dataFileName, tData *Data)
 {
@@ -48,6 +623,9 @@ int ReadData(FILE *log, char *dataFileName, tData *Data)
 		fscanf(dataFile, "%lf %lf %lf", &CFL, &epsilon, &kappa);
 		fscanf(dataFile, "%d", &im);
 
+		DefaultData(Data);
+		ret = ReadOptions(dataFile, Data);
+
 		fclose(dataFile);
 
 		Data->gamma     = gamma;
@@ -63,6 +641,8 @@ int ReadData(FILE *log, char *dataFileName, tData *Data)
 		Data->kappa     = kappa;
 		Data->im        = im;
 
+		CheckOptions(Data);
+
 		/* Write report */
 		if (log)
 		{
@@ -80,6 +660,41 @@ int ReadData(FILE *log, char *dataFileName, tData *Data)
 			fprintf(log, "   epsilon   = %10.3f\n", Data->epsilon);
 			fprintf(log, "   kappa     = %10.3f\n", Data->kappa);
 			fprintf(log, "   im        = %10d\n", Data->im);
+			fprintf(log, "   limiter   = %s\n", Data->limiter == LIMITER_VANALBADA ? "vanalbada" :
+			                                   (Data->limiter == LIMITER_KAPPA ? "kappa" : "vanleer"));
+			fprintf(log, "   flux      = %s\n", FluxName(Data->flux));
+			fprintf(log, "   kernel    = %s\n", Data->kernel == KERNEL_FUSED ? "fused" :
+			                                   (Data->kernel == KERNEL_SIMD ? "simd" : "scalar"));
+			fprintf(log, "   threads   = %10d\n", Data->threads);
+			fprintf(log, "   timestep  = %s\n", Data->timeStepping == TIMESTEP_LOCAL ? "local" : "global");
+			fprintf(log, "   cfl_ramp  = %10d\n", Data->cflRamp);
+			fprintf(log, "   solver    = %s\n", Data->solver == SOLVER_NEWTON ? "newton" : "march");
+			fprintf(log, "   newton_cfl= %10.3f\n", Data->newtonCFL);
+			fprintf(log, "   irs       = %10.3f\n", Data->irs);
+			fprintf(log, "   integrator= %s\n", IntegratorName(Data->integrator));
+			fprintf(log, "   checkpoint= %10d\n", Data->checkpoint);
+			fprintf(log, "   sequence  = %10d\n", Data->sequence);
+			fprintf(log, "   seq_tol   = %10.3e\n", Data->sequenceTol);
+			fprintf(log, "   adapt     = %10d\n", Data->adapt);
+			fprintf(log, "   adapt_str = %10.3f\n", Data->adaptStrength);
+			fprintf(log, "   extrapol  = %10d\n", Data->extrapolate);
+			fprintf(log, "   method    = %s\n", Data->extrapolation == EXTRAPOLATION_MPE ? "mpe" : "rre");
+			fprintf(log, "   every     = %10d\n", Data->extrapolateEvery);
+			fprintf(log, "   stop_rule = %s\n", Data->stopRule == STOP_OUTPUTS ? "outputs" :
+			                                   (Data->stopRule == STOP_ANY ? "any" :
+			                                   (Data->stopRule == STOP_ALL ? "all" : "residual")));
+			fprintf(log, "   stop_norm = %s\n", Data->stopNorm == NORM_L1 ? "l1" :
+			                                   (Data->stopNorm == NORM_LINF ? "linf" : "l2"));
+			fprintf(log, "   stop_eqs  = %s\n", Data->stopEquations == 3 ? "all" : "density");
+			fprintf(log, "   stop_tol  = %10.3e\n", Data->stopTol);
+			fprintf(log, "   stop_out  = %10.3e\n", Data->stopOutputs);
+			fprintf(log, "   stop_win  = %10d\n", Data->stopWindow);
+			fprintf(log, "   adjoint   = %s\n", Data->adjoint == ADJOINT_THRUST ? "thrust" :
+			                                   (Data->adjoint == ADJOINT_MACH ? "mach" : "none"));
+			fprintf(log, "   mg_levels = %10d\n", Data->mgLevels);
+			fprintf(log, "   mg_cycle  = %s\n", Data->mgCycle == MGCYCLE_W ? "w" : "v");
+			fprintf(log, "   mg_pre    = %10d\n", Data->mgPre);
+			fprintf(log, "   mg_post   = %10d\n", Data->mgPost);
 
 			fprintf(log, "\n*****************************\n\n");
 		}
@@ -94,20 +709,79 @@ int ReadData(FILE *log, char *dataFileName, tData *Data)
 }
 
 
+/*
+** Function ReadCase
+**   Reads one case of a sweep table. A row holds the fixed
+**   settings of the data-file in the same order, on one line:
+**
+**     gamma R M_start p_start rho_start u_exit length scheme CFL epsilon kappa im
+**
+**   optionally followed by 'keyword value' pairs. Empty lines
+**   and lines starting with '#' are skipped.
+**
+** In:       line = row of the case table
+** Out:      Data = structure containing all data
+** Return:   1 for a case, 0 for a comment, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int ReadCase(char *line, tData *Data)
+{
+	int  ret;
+	int  n;
+	char key[50], value[50];
+	char first;
+
+	if (sscanf(line, " %c", &first) != 1 || first == '#')
+		return 0;
+
+	DefaultData(Data);
+
+	ret = 1;
+	n   = 0;
+	if (sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %c %lf %lf %lf %d%n",
+	           &Data->gamma, &Data->R, &Data->M_start, &Data->p_start, &Data->rho_start,
+	           &Data->u_exit, &Data->length, &Data->scheme, &Data->CFL, &Data->epsilon,
+	           &Data->kappa, &Data->im, &n) != 12)
+	{
+		fprintf(stderr, "ERROR in function ReadCase: Incomplete case '%s'.\n", line);
+		ret = -1;
+	}
+
+	for (line+=n; ret != -1 && sscanf(line, "%49s %49s%n", key, value, &n) == 2; line+=n)
+	{
+		if (SetOption(Data, key, value) == -1)
+			ret = -1;
+	}
+
+	CheckOptions(Data);
+
+	return ret;
+}
+
+
 /*
 ** Function WriteData.
 ** Writes data to files
 **
-** In:       tResult Result = structure containing all results
+** In:       char    fileName  = name of the result file
+**           tData   Data      = structure containing all data
+**           tResult Result    = structure containing all results
+**           int     iteration = iterations done
+**           double  residual  = normalised residual
 **
 ** Out:      -
 **
 ** Return:   0 on success, -1 on failure
 **
+** Datfiles: nozzle.res (default): binary result file; nozzleconv
+**           converts it to the GNUPlot text of WriteGNUData.
+**
 ** Author:   J.L. Klaufus
 */
 
-int WriteData(FILE *log, tData *Data, tResult *Result)
+int WriteData(FILE *log, char *fileName, tData *Data, tResult *Result, int iteration, double residual)
 {
 	int   ret;
 
@@ -115,7 +789,7 @@ int WriteData(FILE *log, tData *Data, tResult *Result)
 
 	ret = 0;
 
-	ret = WriteGNUData(&(*log), &(*Data), &(*Result));
+	ret = WriteResult(fileName, Data, Result, iteration, residual);
 
 	if (log)
 	{
@@ -138,57 +812,35 @@ int WriteData(FILE *log, tData *Data, tResult *Result)
 ** Writes data in an ASCII format suitable for the visualisation
 ** package GNUPlot.
 **
-** In:       tResult Result  = structure containing all results.
+** In:       char    fileName = name of the GNUPlot datafile
+**           tResult Result   = structure containing all results.
 **
 ** Out:      -
 **
 ** Return:   0 on success, -1 on failure
 **
-** Datfiles: nozzle.gnu: Data file containing flow characteristics.
+** Datfiles: nozzle.gnu (default): Data file containing flow characteristics.
 **
 ** Author:   J.L. Klaufus
 */
 
-int WriteGNUData(FILE *log, tData *Data, tResult *Result)
+int WriteGNUData(FILE *log, char *fileName, tData *Data, tResult *Result)
 {
 	FILE   *dataFile = NULL;
 
 	int    ret;
-	int    i;
-
-	double x, A;
-	double gamma, R;
-	double rho, u, e, T, p, a, M;
 
 	printf("Creating GNUPlot datafile...\n"); 
 
 	ret = 0;
 
-	R     = Data->R;
-	gamma = Data->gamma;
-
 	/*
 	** Write data for GNUPlot
 	*/
-	dataFile = fopen("nozzle.gnu", "w");
+	dataFile = fopen(fileName, "w");
 	if (dataFile)
 	{
-		fprintf(dataFile, "# I          x          A        rho          u          T          p          M\n");
-		for (i=0; i<Result->im; i++)
-		{
-			/* Solve for primitives */
-			x     = Result->x[i];
-			A     = Result->A[i];
-			rho   = Result->Q1[i]/A;
-			u     = Result->Q2[i]/Result->Q1[i];
-			e     = Result->Q3[i]/A;
-			p     = (e-0.5*rho*u*u)*(gamma-1);
-			T     = e*(gamma-1)/R;
-			a     = sqrt(gamma*p/rho);
-			M     = u/a;
-
-			fprintf(dataFile, "%3d %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", i, x, A, rho, u, T, p, M);
-		}
+		WriteGNUField(dataFile, Data, Result);
 	}
 	else
 	{
@@ -216,3 +868,45 @@ int WriteGNUData(FILE *log, tData *Data, tResult *Result)
 	return ret;
 }
 
+/*
+** Function WriteGNUField.
+** Writes the flow characteristics of all nodes as a GNUPlot
+** data block to an opened stream.
+**
+** In:       FILE    dataFile = opened stream
+**           tData   Data     = structure containing all data
+**           tResult Result   = structure containing all results.
+** Out:      -
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void WriteGNUField(FILE *dataFile, tData *Data, tResult *Result)
+{
+	int    i;
+
+	double x, A;
+	double gamma, R;
+	double rho, u, e, T, p, a, M;
+
+	R     = Data->R;
+	gamma = Data->gamma;
+
+	fprintf(dataFile, "# I          x          A        rho          u          T          p          M\n");
+	for (i=0; i<Result->im; i++)
+	{
+		/* Solve for primitives */
+		x     = Result->x[i];
+		A     = Result->A[i];
+		rho   = Result->Q1[i]/A;
+		u     = Result->Q2[i]/Result->Q1[i];
+		e     = Result->Q3[i]/A;
+		p     = (e-0.5*rho*u*u)*(gamma-1);
+		T     = e*(gamma-1)/R;
+		a     = sqrt(gamma*p/rho);
+		M     = u/a;
+
+		fprintf(dataFile, "%3d %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", i, x, A, rho, u, T, p, M);
+	}
+}
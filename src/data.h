@@ -5,9 +5,14 @@
 #ifndef DATA_H
 #define DATA_H
 
-int ReadData(FILE*, char*, tData*);
-int WriteData(FILE*, tData*, tResult*);
-int WriteVigieData(FILE*, tResult*);
-int WriteGNUData(FILE*, tData*, tResult*);
+void DefaultData(tData*);
+int  SetOption(tData*, char*, char*);
+void CheckOptions(tData*);
+int  ReadData(FILE*, char*, tData*);
+int  ReadCase(char*, tData*);
+int  WriteData(FILE*, char*, tData*, tResult*, int, double);
+int  WriteVigieData(FILE*, tResult*);
+int  WriteGNUData(FILE*, char*, tData*, tResult*);
+void WriteGNUField(FILE*, tData*, tResult*);
 
 #endif
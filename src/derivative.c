@@ -3,13 +3,14 @@
 
 #include "main.h"
 #include "derivative.h"
+#include "trace.h"
 
 /*
 ** Function Derivative
-**   Calculates the derivative of the area function.
+**   Calculates the derivative of the area function. Only used
+**   by Init to fill the dA_dx table of the (fixed) grid.
 **
-** In:      log    = name of logfile
-**          i      = node number
+** In:      i      = node number
 **          Result = structure containing results
 ** Out:     -
 ** Return:  dA_dx  = derivative of area function at node i
@@ -17,7 +18,7 @@
 ** Author: J.L. Klaufus
 */
 
-double Derivative(FILE *log, int i, tResult *Result)
+double Derivative(int i, tResult *Result)
 {
 	double dA_dx, dA_dx_old;
 	double X1, X2;
@@ -75,15 +76,7 @@ double Derivative(FILE *log, int i, tResult *Result)
 	dA_dx = 0.347*0.8/cosh(0.8*X1-4);
 	*/
 
-		/* Write report */
-	if (log)
-	{
-		fprintf(log, "\n***** FUNCTION DERIVATIVE *****\n\n");
-
-		fprintf(log, "  dA_dx = %10.3f\n", dA_dx);
-
-		fprintf(log, "\n*******************************\n\n");
-	}
+	TRACE(TRACE_GRID, TRACE_CELL, TRACE_EV_DERIV, i, dA_dx, 0, 0, 0);
 
 	return dA_dx;
 }
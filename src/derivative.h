@@ -5,6 +5,6 @@
 #ifndef DERIVATIVE_H
 #define DERIVATIVE_H
 
-double Derivative(FILE*, int, tResult*);
+double Derivative(int, tResult*);
 
 #endif
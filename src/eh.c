@@ -13,47 +13,33 @@
 #include <math.h>
 
 #include "main.h"
-#include "derivative.h"
 #include "eh.h"
+#include "trace.h"
 
-int CalcEH(FILE *log, tData *Data, tResult *Result)
+int CalcEH(tData *Data, tResult *Result)
 {
 	int ret;
 	int i;
 
 	double gamma;
-	double A, rho, u, p, Et;
+	double E[3], H2, p;
 
 	/*printf("Calculating vectors E and H...\n");*/
 
 	ret = 0;
 
+	gamma = Data->gamma;
 	for (i=0; i<Result->im; i++)
 	{
-		/* Solve for primitives */
-		gamma = Data->gamma;
-		A     = Result->A[i];
-		rho   = Result->Q1[i]/A;
-		u     = Result->Q2[i]/Result->Q1[i];
-		Et    = Result->Q3[i]/A;
-		p     = (Et-0.5*rho*u*u)*(gamma-1);
-
-		/* Calculate the vectors */
-		Result->E1[i] = rho*u*A;
-		Result->E2[i] = (rho*u*u + p)*A;
-		Result->E3[i] = u*(Et + p)*A;
-		Result->H2[i] = p*Derivative(&(*log), i, &(*Result));
-	}
-
-	if (log)
-	{
-		fprintf(log, "\n***** FUNCTION CALCEH *****\n\n");
+		NodeEH(gamma, Result->Q1[i], Result->Q2[i], Result->Q3[i],
+		       Result->A[i], Result->invA[i], Result->dA_dx[i], E, &H2, &p);
 
-		fprintf(log, "  I         E1         E2         E3         H2\n");
-		for (i=0; i<Result->im; i++)
-			fprintf(log, "%3d %10.4f %10.4f %10.4f %10.4f\n", i, Result->E1[i], Result->E2[i], Result->E3[i], Result->H2[i]);
+		Result->E1[i] = E[0];
+		Result->E2[i] = E[1];
+		Result->E3[i] = E[2];
+		Result->H2[i] = H2;
 
-		fprintf(log, "\n*****************************\n\n");
+		TRACE(TRACE_EH, TRACE_CELL, TRACE_EV_EH, i, E[0], E[1], E[2], H2);
 	}
 
 	return ret;
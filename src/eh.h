@@ -5,6 +5,42 @@
 #ifndef EH_H
 #define EH_H
 
-int    CalcEH(FILE*, tData*, tResult*);
+int    CalcEH(tData*, tResult*);
+
+/*
+** Function NodeEH
+**   Calculates the vectors E and H in a single node. Used by
+**   CalcEH and by the fused kernels, which compute E and H on
+**   the fly instead of storing them.
+**
+** In:       double gamma    = constant
+**           double Q1,Q2,Q3 = conservative variables in the node
+**           double A, invA  = area and 1/area in the node
+**           double dA_dx    = area derivative in the node
+** Out:      double E        = flux vector E1..E3
+**           double H2       = source term
+**           double p        = pressure
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline void NodeEH(double gamma, double Q1, double Q2, double Q3, double A, double invA, double dA_dx,
+                          double *E, double *H2, double *p)
+{
+	double rho, u, Et;
+
+	/* Solve for primitives */
+	rho   = Q1*invA;
+	u     = Q2/Q1;
+	Et    = Q3*invA;
+	*p    = (Et-0.5*rho*u*u)*(gamma-1);
+
+	/* Calculate the vectors */
+	E[0]  = rho*u*A;
+	E[1]  = (rho*u*u + *p)*A;
+	E[2]  = u*(Et + *p)*A;
+	*H2   = *p*dA_dx;
+}
 
 #endif
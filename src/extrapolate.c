@@ -0,0 +1,389 @@
+/*
+** Extrapolate
+**    Vector extrapolation of the iterates of the scheme. The
+**    window holds n+1 consecutive fields x0..xn; with the
+**    differences u[j] = x[j+1] - x[j] the extrapolated field is
+**
+**      s = sum gamma[j] x[j+1],   sum gamma[j] = 1
+**
+**    Reduced rank extrapolation (RRE) takes the gamma that
+**    minimise |sum gamma[j] u[j]|; minimal polynomial
+**    extrapolation (MPE) takes gamma = c/sum c, with c the least
+**    squares coefficients of sum c[j] u[j] = -u[m], c[m] = 1, of
+**    the last independent difference m. Both come from a QR
+**    factorisation of the differences by modified Gram-Schmidt,
+**    in which differences that are (nearly) dependent on the
+**    previous ones end the factorisation. Every component is
+**    scaled with its largest value in the field, so that rho*A
+**    and Et*A weigh alike.
+**
+**    The window takes the field of every extrapolate_every-th
+**    iteration: the consecutive fields of the schemes differ
+**    too little in their slow modes to tell them apart. The
+**    extrapolated field is tried with one step of the scheme,
+**    and kept only if the residual of that step is below
+**    EXTRAPOLATE_ACCEPT times the residual of the last step
+**    before it; otherwise the last iterate is restored. Either
+**    way the window starts anew. The extrapolation only needs
+**    the field and the residual, so it works for every scheme
+**    and kernel of Step.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "main.h"
+#include "boundary.h"
+#include "extrapolate.h"
+#include "solve.h"
+
+typedef struct
+{
+	int    n;                              /* differences of one extrapolation */
+	int    stored;                         /* iterates in the window */
+	int    count;                          /* iterations since the last iterate */
+
+	double *X[EXTRAPOLATE_MAX+1][3];       /* iterates */
+	double *U[EXTRAPOLATE_MAX][3];         /* scaled differences, orthonormalised */
+
+	double *memory;
+} tExtrapolation;
+
+/*
+** Function Dot
+**    Inner product of two scaled fields over the inner nodes.
+*/
+
+static double Dot(int im, double **a, double **b)
+{
+	int    i, c;
+	double sum;
+
+	sum = 0;
+	for (c=0; c<3; c++)
+		for (i=1; i<im-1; i++)
+			sum += a[c][i]*b[c][i];
+
+	return sum;
+}
+
+/*
+** Function StartExtrapolation
+**    Allocates the window of iterates of the extrapolation.
+**
+** In:       FILE    log    = pointer to log file
+**           tData   Data   = structure containing all data
+** Out:      tResult Result = extrapolation is set
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StartExtrapolation(FILE *log, tData *Data, tResult *Result)
+{
+	int    j, c, im;
+	double *next;
+
+	tExtrapolation *E;
+
+	Result->extrapolation = NULL;
+
+	if (Data->extrapolate <= 0)
+		return 0;
+
+	im = Data->im;
+
+	E = calloc(1, sizeof(tExtrapolation));
+	if (E)
+		E->memory = malloc(3*(2*(size_t)Data->extrapolate + 1)*im*sizeof(double));
+
+	if (E == NULL || E->memory == NULL)
+	{
+		fprintf(stderr, "ERROR in function StartExtrapolation: could not allocate memory...\n");
+		free(E);
+		return -1;
+	}
+
+	E->n      = Data->extrapolate;
+	E->stored = 0;
+	E->count  = 0;
+
+	next = E->memory;
+	for (j=0; j<=E->n; j++)
+		for (c=0; c<3; c++)
+		{
+			E->X[j][c] = next;
+			next += im;
+		}
+
+	for (j=0; j<E->n; j++)
+		for (c=0; c<3; c++)
+		{
+			E->U[j][c] = next;
+			next += im;
+		}
+
+	Result->extrapolation = E;
+
+	if (log)
+		fprintf(log, "\n   Extrapolation: %s over %d iterates\n\n",
+		        Data->extrapolation == EXTRAPOLATION_MPE ? "MPE" : "RRE", E->n+1);
+
+	return 0;
+}
+
+/*
+** Function StopExtrapolation
+**    Frees the window of iterates of the extrapolation.
+**
+** In:       tResult Result = structure containing results
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StopExtrapolation(tResult *Result)
+{
+	tExtrapolation *E = Result->extrapolation;
+
+	if (E)
+	{
+		free(E->memory);
+		free(E);
+	}
+
+	Result->extrapolation = NULL;
+
+	return 0;
+}
+
+/*
+** Function Coefficients
+**    The gamma of the extrapolation from the QR factorisation of
+**    the first k differences (k = n: all independent; for MPE,
+**    column k of R holds the projections of difference k).
+**    Returns the number of gamma, 0 if there is nothing to
+**    extrapolate.
+*/
+
+static int Coefficients(int method, int n, int k, double R[EXTRAPOLATE_MAX][EXTRAPOLATE_MAX], double *gamma)
+{
+	int    i, j, m;
+	double sum, y[EXTRAPOLATE_MAX];
+
+	if (method == EXTRAPOLATION_MPE)
+	{
+		/* The last independent difference is the right hand side */
+		m = (k < n) ? k : n-1;
+		if (m < 1)
+			return 0;
+
+		for (i=m-1; i>=0; i--)
+		{
+			sum = -R[i][m];
+			for (j=i+1; j<m; j++)
+				sum -= R[i][j]*gamma[j];
+			gamma[i] = sum/R[i][i];
+		}
+		gamma[m] = 1;
+		m++;
+	}
+	else
+	{
+		/* R^T R d = 1 */
+		m = k;
+		if (m < 1)
+			return 0;
+
+		for (i=0; i<m; i++)
+		{
+			sum = 1;
+			for (j=0; j<i; j++)
+				sum -= R[j][i]*y[j];
+			y[i] = sum/R[i][i];
+		}
+
+		for (i=m-1; i>=0; i--)
+		{
+			sum = y[i];
+			for (j=i+1; j<m; j++)
+				sum -= R[i][j]*gamma[j];
+			gamma[i] = sum/R[i][i];
+		}
+	}
+
+	sum = 0;
+	for (i=0; i<m; i++)
+		sum += gamma[i];
+
+	if (sum == 0 || !isfinite(sum))
+		return 0;
+
+	for (i=0; i<m; i++)
+		gamma[i] /= sum;
+
+	return m;
+}
+
+/*
+** Function Extrapolate
+**   Adds the field of the last step to the window and, when the
+**   window is full, tries the extrapolated field.
+**
+** In:       tData   Data     = structure containing all data
+**           tResult Result   = structure containing results
+**           double  residual = residual of the last step
+** Out:      tResult Result   = extrapolated field, if accepted
+**           double  residual = residual of the step from it, if accepted
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int Extrapolate(tData *Data, tResult *Result, double *residual)
+{
+	int    ret;
+	int    i, j, l, c, n, k, m, im, valid;
+	double norm, trial, scale[3], gamma[EXTRAPOLATE_MAX+1];
+	double norms[NORMS];
+	double R[EXTRAPOLATE_MAX][EXTRAPOLATE_MAX];
+	double *Q[3];
+
+	tExtrapolation *E = Result->extrapolation;
+
+	ret = 0;
+	im  = Result->im;
+	n   = E->n;
+
+	Q[0] = Result->Q1;
+	Q[1] = Result->Q2;
+	Q[2] = Result->Q3;
+
+	if (++E->count < Data->extrapolateEvery)
+		return 0;
+
+	E->count = 0;
+
+	for (c=0; c<3; c++)
+		for (i=0; i<im; i++)
+			E->X[E->stored][c][i] = Q[c][i];
+
+	if (++E->stored <= n)
+		return 0;
+
+	E->stored = 0;
+
+	/* Scaled differences */
+	for (c=0; c<3; c++)
+	{
+		scale[c] = 0;
+		for (i=0; i<im; i++)
+			if (fabs(Q[c][i]) > scale[c])
+				scale[c] = fabs(Q[c][i]);
+
+		scale[c] = scale[c] > 0 ? 1/scale[c] : 1;
+	}
+
+	for (j=0; j<n; j++)
+		for (c=0; c<3; c++)
+		{
+			E->U[j][c][0]    = 0;
+			E->U[j][c][im-1] = 0;
+
+			for (i=1; i<im-1; i++)
+				E->U[j][c][i] = scale[c]*(E->X[j+1][c][i] - E->X[j][c][i]);
+		}
+
+	/* Modified Gram-Schmidt; a dependent difference ends it */
+	k = n;
+	for (j=0; j<n && k==n; j++)
+	{
+		norm = sqrt(Dot(im, E->U[j], E->U[j]));
+
+		for (l=0; l<j; l++)
+		{
+			R[l][j] = Dot(im, E->U[l], E->U[j]);
+
+			for (c=0; c<3; c++)
+				for (i=1; i<im-1; i++)
+					E->U[j][c][i] -= R[l][j]*E->U[l][c][i];
+		}
+
+		R[j][j] = sqrt(Dot(im, E->U[j], E->U[j]));
+
+		if (R[j][j] <= EXTRAPOLATE_DROP*norm || R[j][j] == 0)
+			k = j;
+		else
+			for (c=0; c<3; c++)
+				for (i=1; i<im-1; i++)
+					E->U[j][c][i] /= R[j][j];
+	}
+
+	m = Coefficients(Data->extrapolation, n, k, R, gamma);
+	if (m == 0)
+		return 0;
+
+	/* The extrapolated field; rho and p must stay positive */
+	valid = 1;
+	for (i=1; i<im-1; i++)
+	{
+		for (c=0; c<3; c++)
+		{
+			Q[c][i] = 0;
+			for (j=0; j<m; j++)
+				Q[c][i] += gamma[j]*E->X[j+1][c][i];
+		}
+
+		if (Q[0][i] <= 0 || Q[2][i] - 0.5*Q[1][i]*Q[1][i]/Q[0][i] <= 0)
+			valid = 0;
+	}
+
+	/* The step from the extrapolated field must lower the residual */
+	trial = *residual;
+
+	if (valid)
+	{
+		Result->timeStep = 0;
+
+		memcpy(norms, Result->norms, sizeof(norms));
+
+		ret = Boundary(Data, Result);
+
+		if (ret != -1)
+			ret = Step(Data, Result, &trial);
+
+		if (ret == -1 || !isfinite(trial))
+		{
+			ret   = 0;
+			trial = *residual;
+		}
+	}
+
+	if (trial < EXTRAPOLATE_ACCEPT*(*residual))
+	{
+		*residual = trial;
+		Result->accepted++;
+	}
+	else
+	{
+		/* Back to the last iterate */
+		for (c=0; c<3; c++)
+			for (i=0; i<im; i++)
+				Q[c][i] = E->X[n][c][i];
+
+		Result->timeStep = 0;
+		Result->rejected++;
+
+		if (valid)
+			memcpy(Result->norms, norms, sizeof(norms));
+
+		ret = Boundary(Data, Result);
+	}
+
+	return ret;
+}
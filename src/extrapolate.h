@@ -0,0 +1,21 @@
+/*
+** Header-file for Extrapolate
+*/
+
+#ifndef EXTRAPOLATE_H
+#define EXTRAPOLATE_H
+
+/* Largest number of differences of one extrapolation */
+#define EXTRAPOLATE_MAX 16
+
+/* Differences this much smaller than their part orthogonal to the others are dropped */
+#define EXTRAPOLATE_DROP 1e-10
+
+/* An extrapolation is kept if its step has a residual below this fraction of the last one */
+#define EXTRAPOLATE_ACCEPT 0.3
+
+int StartExtrapolation(FILE*, tData*, tResult*);
+int StopExtrapolation(tResult*);
+int Extrapolate(tData*, tResult*, double*);
+
+#endif
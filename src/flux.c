@@ -0,0 +1,51 @@
+/*
+** Function FluxName
+**    Returns the keyword of an interface flux, as in the
+**    data-file, for reports.
+**
+** In:       int flux = FLUX_ value
+** Out:      -
+** Return:   name of the flux
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "main.h"
+#include "roe.h"
+#include "flux.h"
+
+char *FluxName(int flux)
+{
+	switch (flux)
+	{
+		case FLUX_HLL:     return "hll";
+		case FLUX_HLLC:    return "hllc";
+		case FLUX_AUSM:    return "ausm";
+		case FLUX_RUSANOV: return "rusanov";
+		default:           return "roe";
+	}
+}
+
+/*
+** Function FluxFlops
+**    Floating point operations of one interface flux, counted
+**    in the source on the subsonic path: every add, multiply,
+**    divide and square root as one, common subexpressions once,
+**    the tests and fabs not. Roe's flux without the entropy fix,
+**    which only acts near a sonic point.
+*/
+
+int FluxFlops(int flux)
+{
+	switch (flux)
+	{
+		case FLUX_HLL:     return 74;
+		case FLUX_HLLC:    return 86;
+		case FLUX_AUSM:    return 66;
+		case FLUX_RUSANOV: return 44;
+		default:           return 80;
+	}
+}
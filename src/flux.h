@@ -0,0 +1,297 @@
+/*
+** Header-file for Flux
+**
+**   The interface fluxes next to Roe's. Like RoeFlux they are
+**   inline, so the sweeps call them without a function call;
+**   InterfaceFlux selects one by the FLUX_ value of the
+**   data-file. The states are those of Reconstruct: rho*A,
+**   rho*u*A and Et*A, so p below is p*A.
+*/
+
+#ifndef FLUX_H
+#define FLUX_H
+
+char *FluxName(int);
+int  FluxFlops(int);
+
+/*
+** Function StateFlux
+**   Decodes a state into u, p and the sound speed and computes
+**   its flux vector.
+*/
+
+static inline void StateFlux(double gamma, const tConservative *s, double *u, double *p, double *a, double *F)
+{
+	*u   = s->Q2/s->Q1;
+	*p   = (s->Q3 - 0.5*s->Q2*(*u))*(gamma-1);
+	*a   = sqrt(gamma*(*p)/s->Q1);
+
+	F[0] = s->Q2;
+	F[1] = s->Q2*(*u) + *p;
+	F[2] = (s->Q3 + *p)*(*u);
+}
+
+/*
+** Function WaveSpeeds
+**   Smallest and largest signal speed of an interface by
+**   Einfeldt: those of both states and of the Roe average.
+*/
+
+static inline void WaveSpeeds(double gamma, const tConservative *left, const tConservative *right,
+                              double u_l, double p_l, double a_l, double u_r, double p_r, double a_r,
+                              double *S_l, double *S_r)
+{
+	double R, u_tilde, H_tilde, a_tilde;
+
+	R       = sqrt(right->Q1/left->Q1);
+	u_tilde = (u_l + R*u_r)/(1+R);
+	H_tilde = ((left->Q3 + p_l)/left->Q1 + R*(right->Q3 + p_r)/right->Q1)/(1+R);
+	a_tilde = sqrt((gamma-1)*(H_tilde - 0.5*u_tilde*u_tilde));
+
+	*S_l = fmin(u_l - a_l, u_tilde - a_tilde);
+	*S_r = fmax(u_r + a_r, u_tilde + a_tilde);
+}
+
+/*
+** Function HLLFlux
+**    Calculates the flux through one interface with the HLL
+**    solver of Harten, Lax and Van Leer: one averaged state
+**    between the slowest and the fastest wave.
+**
+** In:       double        gamma   = constant
+**           tConservative left    = left conservative variables
+**           tConservative right   = right conservative variables
+** Out:      double        F       = flux through interface
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline void HLLFlux(double gamma, const tConservative *left, const tConservative *right, double *F)
+{
+	double u_l, p_l, a_l, u_r, p_r, a_r;
+	double S_l, S_r, S_lr, invS;
+	double F_l[3], F_r[3];
+
+	StateFlux(gamma, left,  &u_l, &p_l, &a_l, F_l);
+	StateFlux(gamma, right, &u_r, &p_r, &a_r, F_r);
+	WaveSpeeds(gamma, left, right, u_l, p_l, a_l, u_r, p_r, a_r, &S_l, &S_r);
+
+	if (S_l >= 0)
+	{
+		F[0] = F_l[0]; F[1] = F_l[1]; F[2] = F_l[2];
+		return;
+	}
+
+	if (S_r <= 0)
+	{
+		F[0] = F_r[0]; F[1] = F_r[1]; F[2] = F_r[2];
+		return;
+	}
+
+	S_lr = S_l*S_r;
+	invS = 1/(S_r - S_l);
+
+	F[0] = (S_r*F_l[0] - S_l*F_r[0] + S_lr*(right->Q1 - left->Q1))*invS;
+	F[1] = (S_r*F_l[1] - S_l*F_r[1] + S_lr*(right->Q2 - left->Q2))*invS;
+	F[2] = (S_r*F_l[2] - S_l*F_r[2] + S_lr*(right->Q3 - left->Q3))*invS;
+}
+
+/*
+** Function HLLCFlux
+**    Calculates the flux through one interface with the HLLC
+**    solver of Toro, Spruce and Speares: HLL with the contact
+**    wave restored, so a contact is resolved as by Roe.
+**
+** In:       double        gamma   = constant
+**           tConservative left    = left conservative variables
+**           tConservative right   = right conservative variables
+** Out:      double        F       = flux through interface
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline void HLLCFlux(double gamma, const tConservative *left, const tConservative *right, double *F)
+{
+	double u_l, p_l, a_l, u_r, p_r, a_r;
+	double S_l, S_r, S_m, S, u, p, factor;
+	double F_l[3], F_r[3];
+	const tConservative *s;
+	const double *F_s;
+
+	StateFlux(gamma, left,  &u_l, &p_l, &a_l, F_l);
+	StateFlux(gamma, right, &u_r, &p_r, &a_r, F_r);
+	WaveSpeeds(gamma, left, right, u_l, p_l, a_l, u_r, p_r, a_r, &S_l, &S_r);
+
+	if (S_l >= 0)
+	{
+		F[0] = F_l[0]; F[1] = F_l[1]; F[2] = F_l[2];
+		return;
+	}
+
+	if (S_r <= 0)
+	{
+		F[0] = F_r[0]; F[1] = F_r[1]; F[2] = F_r[2];
+		return;
+	}
+
+	/* Speed of the contact */
+	S_m = (p_r - p_l + left->Q2*(S_l - u_l) - right->Q2*(S_r - u_r))/
+	      (left->Q1*(S_l - u_l) - right->Q1*(S_r - u_r));
+
+	/* The star state on the side of the contact the interface is on */
+	if (S_m >= 0)
+	{
+		s = left;  F_s = F_l; S = S_l; u = u_l; p = p_l;
+	}
+	else
+	{
+		s = right; F_s = F_r; S = S_r; u = u_r; p = p_r;
+	}
+
+	factor = s->Q1*(S - u)/(S - S_m);
+
+	F[0] = F_s[0] + S*(factor - s->Q1);
+	F[1] = F_s[1] + S*(factor*S_m - s->Q2);
+	F[2] = F_s[2] + S*(factor*(s->Q3/s->Q1 + (S_m - u)*(S_m + p/(s->Q1*(S - u)))) - s->Q3);
+}
+
+/*
+** Function AUSMFlux
+**    Calculates the flux through one interface with the AUSM+
+**    splitting of Liou: the mass flux and the pressure are
+**    split by the Mach numbers of both sides, with the sound
+**    speed averaged over the interface.
+**
+** In:       double        gamma   = constant
+**           tConservative left    = left conservative variables
+**           tConservative right   = right conservative variables
+** Out:      double        F       = flux through interface
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline void AUSMFlux(double gamma, const tConservative *left, const tConservative *right, double *F)
+{
+	const double alpha = 3.0/16;
+	const double beta  = 1.0/8;
+
+	double u_l, p_l, a_l, u_r, p_r, a_r;
+	double a, M_l, M_r, m, p, M_plus, M_minus, P_plus, P_minus;
+	double F_l[3], F_r[3];
+
+	StateFlux(gamma, left,  &u_l, &p_l, &a_l, F_l);
+	StateFlux(gamma, right, &u_r, &p_r, &a_r, F_r);
+
+	a   = 0.5*(a_l + a_r);
+	M_l = u_l/a;
+	M_r = u_r/a;
+
+	/* Split Mach numbers and pressures of degree 4 and 5 */
+	if (fabs(M_l) >= 1)
+	{
+		M_plus = 0.5*(M_l + fabs(M_l));
+		P_plus = (M_l > 0) ? 1 : 0;
+	}
+	else
+	{
+		M_plus = 0.25*(M_l+1)*(M_l+1) + beta*(M_l*M_l-1)*(M_l*M_l-1);
+		P_plus = 0.25*(M_l+1)*(M_l+1)*(2-M_l) + alpha*M_l*(M_l*M_l-1)*(M_l*M_l-1);
+	}
+
+	if (fabs(M_r) >= 1)
+	{
+		M_minus = 0.5*(M_r - fabs(M_r));
+		P_minus = (M_r < 0) ? 1 : 0;
+	}
+	else
+	{
+		M_minus = -0.25*(M_r-1)*(M_r-1) - beta*(M_r*M_r-1)*(M_r*M_r-1);
+		P_minus = 0.25*(M_r-1)*(M_r-1)*(2+M_r) - alpha*M_r*(M_r*M_r-1)*(M_r*M_r-1);
+	}
+
+	m = M_plus + M_minus;
+	p = P_plus*p_l + P_minus*p_r;
+
+	/* Upwind the convected rho, rho*u and rho*H by the interface Mach number */
+	if (m >= 0)
+	{
+		F[0] = a*m*left->Q1;
+		F[1] = a*m*left->Q2 + p;
+		F[2] = a*m*(left->Q3 + p_l);
+	}
+	else
+	{
+		F[0] = a*m*right->Q1;
+		F[1] = a*m*right->Q2 + p;
+		F[2] = a*m*(right->Q3 + p_r);
+	}
+}
+
+/*
+** Function RusanovFlux
+**    Calculates the flux through one interface with the local
+**    Lax-Friedrichs flux of Rusanov: the central flux with a
+**    dissipation of the largest signal speed.
+**
+** In:       double        gamma   = constant
+**           tConservative left    = left conservative variables
+**           tConservative right   = right conservative variables
+** Out:      double        F       = flux through interface
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline void RusanovFlux(double gamma, const tConservative *left, const tConservative *right, double *F)
+{
+	double u_l, p_l, a_l, u_r, p_r, a_r;
+	double S;
+	double F_l[3], F_r[3];
+
+	StateFlux(gamma, left,  &u_l, &p_l, &a_l, F_l);
+	StateFlux(gamma, right, &u_r, &p_r, &a_r, F_r);
+
+	S = fmax(fabs(u_l) + a_l, fabs(u_r) + a_r);
+
+	F[0] = 0.5*(F_l[0] + F_r[0]) - 0.5*S*(right->Q1 - left->Q1);
+	F[1] = 0.5*(F_l[1] + F_r[1]) - 0.5*S*(right->Q2 - left->Q2);
+	F[2] = 0.5*(F_l[2] + F_r[2]) - 0.5*S*(right->Q3 - left->Q3);
+}
+
+/*
+** Function InterfaceFlux
+**    Calculates the flux through one interface with the flux
+**    of the data-file. Roe's flux takes the flux vectors of the
+**    nodes, the others those of the interface states.
+**
+** In:       int           flux    = FLUX_ value
+**           double        gamma   = constant
+**           double        epsilon = threshold of Roe's entropy fix
+**           tConservative left    = left conservative variables
+**           tConservative right   = right conservative variables
+**           double        E_l     = flux vector in node left of interface
+**           double        E_r     = flux vector in node right of interface
+** Out:      double        F       = flux through interface
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline void InterfaceFlux(const int flux, double gamma, double epsilon,
+                                 const tConservative *left, const tConservative *right,
+                                 const double *E_l, const double *E_r, double *F)
+{
+	switch (flux)
+	{
+		case FLUX_HLL:     HLLFlux(gamma, left, right, F);     break;
+		case FLUX_HLLC:    HLLCFlux(gamma, left, right, F);    break;
+		case FLUX_AUSM:    AUSMFlux(gamma, left, right, F);    break;
+		case FLUX_RUSANOV: RusanovFlux(gamma, left, right, F); break;
+		default:           RoeFlux(gamma, epsilon, left, right, E_l, E_r, F); break;
+	}
+}
+
+#endif
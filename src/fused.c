@@ -0,0 +1,380 @@
+/*
+** Fused kernels
+**    Advance the inner field in a single sweep over the grid.
+**    The vectors E and H are computed on the fly from Q instead
+**    of being stored by CalcEH, and the CFL-limited timestep of
+**    the next iteration is reduced while the field is updated,
+**    so TimeStep is not needed either. Per iteration only the
+**    conservative variables (and the geometry) are streamed
+**    through memory.
+**
+**    The results are identical to the separate passes of
+**    CalcEH, TimeStep and MacCormack or Roe.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "main.h"
+#include "av.h"
+#include "eh.h"
+#include "fused.h"
+#include "norms.h"
+#include "roe.h"
+#include "schemes.h"
+#include "timestep.h"
+#include "trace.h"
+
+/*
+** Function FusedRoe
+**    Roe's approximate Riemann solver (first order or MUSCL)
+**    in a single sweep; compiled once per reconstruction as
+**    FusedRoeConstant, FusedRoeVanLeer, FusedRoeVanAlbada and
+**    FusedRoeKappa.
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results;
+**                              Result->timeStep (and Result->dt)
+**                              is set to the timestep of the
+**                              next iteration
+**           double  residual = residual for convergence testing
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+__attribute__((always_inline))
+static inline int FusedRoe(tData *Data, tResult *Result, double *residual, const int recon)
+{
+	int ret;
+	int i, im;
+
+	double gamma, epsilon, kappa, CFL;
+	double timeStep, nextTimeStep, localTimeStep;
+	double tau;
+	double rhoBefore, rhoAfter, Q2Before, Q3Before;
+	double *norms;
+	double p;
+
+	double E_l[3], E_r[3];
+	double H2_l, H2_r;
+	double E_tilde_right[3], E_tilde_left[3];
+
+	double *Q1, *Q2, *Q3;
+
+	tConservative left, right;
+
+	ret = 0;
+
+	im        = Data->im;
+	gamma     = Data->gamma;
+	epsilon   = Data->epsilon;
+	kappa     = Data->kappa;
+	CFL       = Data->CFL;
+	timeStep  = Result->timeStep;
+
+	Q1 = Result->Q1;
+	Q2 = Result->Q2;
+	Q3 = Result->Q3;
+
+	nextTimeStep = timeStep;
+
+	/* E and H in the first node */
+	NodeEH(gamma, Q1[0], Q2[0], Q3[0], Result->A[0], Result->invA[0], Result->dA_dx[0], E_l, &H2_l, &p);
+
+	*residual = 0;
+	ClearNorms(Result->norms);
+	norms     = Result->monitor ? Result->norms : NULL;
+	for (i=0; i<im-1 && ret!=-1; i++)
+	{
+		/* E and H in the node right of the interface; Q[i+1] is not updated yet */
+		NodeEH(gamma, Q1[i+1], Q2[i+1], Q3[i+1], Result->A[i+1], Result->invA[i+1], Result->dA_dx[i+1],
+		       E_r, &H2_r, &p);
+
+		/* Left and right states of the interface */
+		Reconstruct(recon, gamma, kappa, im, Q1, Q2, Q3, i, &left, &right);
+
+		/* Calculate averaged flux through interface right of current node */
+		RoeFlux(gamma, epsilon, &left, &right, E_l, E_r, E_tilde_right);
+
+		TRACE(TRACE_SCHEME, TRACE_CELL, TRACE_EV_LEFT,  i, left.Q1,  left.Q2,  left.Q3,  0);
+		TRACE(TRACE_SCHEME, TRACE_CELL, TRACE_EV_RIGHT, i, right.Q1, right.Q2, right.Q3, 0);
+		TRACE(TRACE_SCHEME, TRACE_CELL, TRACE_EV_FLUX,  i, E_tilde_right[0], E_tilde_right[1], E_tilde_right[2], 0);
+
+		/* Calculate new Q-vector; only in inner field */
+		if (i>0)
+		{
+			/* Use density for residual calculation */
+			rhoBefore = Q1[i]*Result->invA[i];
+			Q2Before  = Q2[i];
+			Q3Before  = Q3[i];
+
+			/* Local time stepping: the timestep of the node */
+			if (Result->dt)
+				timeStep = Result->dt[i];
+
+			tau = timeStep/Result->dx[i];
+			Q1[i] += -tau*(E_tilde_right[0] - E_tilde_left[0]);
+			Q2[i] += -tau*(E_tilde_right[1] - E_tilde_left[1]) + timeStep*H2_l;
+			Q3[i] += -tau*(E_tilde_right[2] - E_tilde_left[2]);
+
+			/* Calculate the residual and the norms */
+			rhoAfter    = Q1[i]*Result->invA[i];
+			*residual  += AddNorms(norms, (rhoAfter-rhoBefore)/timeStep,
+			                       Q2[i]-Q2Before, Q3[i]-Q3Before, Result->invA[i]/timeStep);
+
+			/* Timestep of the next iteration */
+			if (CellTimeStep(gamma, CFL, Result->dx[i], Result->invA[i],
+			                 Q1[i], Q2[i], Q3[i], &localTimeStep) == -1)
+				ret = -1;
+			else
+			{
+				if (Result->dt)
+					Result->dt[i] = localTimeStep;
+
+				if ((i==1) || (localTimeStep < nextTimeStep))
+					nextTimeStep = localTimeStep;
+			}
+		}
+
+		/* Shift right to left for next node */
+		E_tilde_left[0] = E_tilde_right[0];
+		E_tilde_left[1] = E_tilde_right[1];
+		E_tilde_left[2] = E_tilde_right[2];
+
+		E_l[0] = E_r[0];
+		E_l[1] = E_r[1];
+		E_l[2] = E_r[2];
+		H2_l   = H2_r;
+	}
+
+	Result->timeStep = nextTimeStep;
+	if (Result->dt)
+		Result->dt[0] = Result->dt[1];
+
+	/* Trace the new field */
+	if (TRACE_ON(TRACE_SOLVER, TRACE_CELL))
+		for (i=0; i<im; i++)
+			TRACE(TRACE_SOLVER, TRACE_CELL, TRACE_EV_FIELD, i, Q1[i], Q2[i], Q3[i], 0);
+
+	return ret;
+}
+
+int FusedRoeConstant(tData *Data, tResult *Result, double *residual)
+{
+	return FusedRoe(Data, Result, residual, RECON_CONSTANT);
+}
+
+int FusedRoeVanLeer(tData *Data, tResult *Result, double *residual)
+{
+	return FusedRoe(Data, Result, residual, RECON_VANLEER);
+}
+
+int FusedRoeVanAlbada(tData *Data, tResult *Result, double *residual)
+{
+	return FusedRoe(Data, Result, residual, RECON_VANALBADA);
+}
+
+int FusedRoeKappa(tData *Data, tResult *Result, double *residual)
+{
+	return FusedRoe(Data, Result, residual, RECON_KAPPA);
+}
+
+
+/*
+** Function FusedMacCormack
+**    MacCormack's predictor-corrector scheme in a single sweep.
+**    The corrector runs one node behind the predictor: the
+**    corrector in node i-1 needs Q-bar in node i, and the
+**    predictor in node i still needs the old Q in node i-1.
+**    Only Q-bar is stored (for the artificial viscosity); E-bar
+**    and H-bar of the last nodes are kept in registers.
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results;
+**                              Result->timeStep (and Result->dt)
+**                              is set to the timestep of the
+**                              next iteration
+**           double  residual = residual for convergence testing
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int FusedMacCormack(tData *Data, tResult *Result, double *residual)
+{
+	int ret;
+	int i, j, im;
+
+	double A, invA, rho, e, p, u;
+	double gamma, epsilon, CFL;
+	double timeStep, nextTimeStep, localTimeStep;
+	double tau;
+	double rhoBefore, rhoAfter, Q2Before, Q3Before;
+	double *norms;
+	double Q1_bb, Q2_bb, Q3_bb;
+
+	double E_i[3], E_n[3];
+	double H2_i, H2_n;
+	double Eb_cur[3], Eb_prev[3], Eb_prev2[3];
+	double H2b_cur, H2b_prev;
+
+	double *Q1, *Q2, *Q3;
+	double *Q1_b, *Q2_b, *Q3_b;
+
+	tAV    AV;
+
+	ret = 0;
+
+	if (Result->nScratch < FUSED_MACCORMACK_SCRATCH)
+	{
+		fprintf(stderr, "ERROR in function FusedMacCormack: No workspace allocated.\n");
+		return -1;
+	}
+
+	im        = Data->im;
+	gamma     = Data->gamma;
+	epsilon   = Data->epsilon;
+	CFL       = Data->CFL;
+	timeStep  = Result->timeStep;
+
+	Q1   = Result->Q1;
+	Q2   = Result->Q2;
+	Q3   = Result->Q3;
+
+	Q1_b = Result->scratch[0];
+	Q2_b = Result->scratch[1];
+	Q3_b = Result->scratch[2];
+
+	AV.D1 = AV.D2 = AV.D3 = 0;
+
+	nextTimeStep = timeStep;
+	H2_n         = H2b_cur     = H2b_prev    = 0;
+	E_n[0]       = E_n[1]      = E_n[2]      = 0;
+	Eb_cur[0]    = Eb_cur[1]   = Eb_cur[2]   = 0;
+	Eb_prev[0]   = Eb_prev[1]  = Eb_prev[2]  = 0;
+	Eb_prev2[0]  = Eb_prev2[1] = Eb_prev2[2] = 0;
+
+	/* E and H in the first node */
+	NodeEH(gamma, Q1[0], Q2[0], Q3[0], Result->A[0], Result->invA[0], Result->dA_dx[0], E_i, &H2_i, &p);
+
+	*residual = 0;
+	ClearNorms(Result->norms);
+	norms     = Result->monitor ? Result->norms : NULL;
+	for (i=0; i<=im-1 && ret!=-1; i++)
+	{
+		/*
+		** Predictor in node i; forward differencing, nodes [0, im-2]
+		*/
+		if (i < im-1)
+		{
+			NodeEH(gamma, Q1[i+1], Q2[i+1], Q3[i+1], Result->A[i+1], Result->invA[i+1], Result->dA_dx[i+1],
+			       E_n, &H2_n, &p);
+
+			/* Local time stepping: the timestep of the node; the corrector has not renewed it yet */
+			if (Result->dt)
+				timeStep = Result->dt[i];
+
+			tau = timeStep/(Result->x[i+1] - Result->x[i]);
+
+			/* Calculate artificial viscosity */
+			ret = CalcAV(gamma, epsilon, i, im, Result->A[i], Q1, Q2, Q3, &AV);
+
+			/* Calculate Q-bar */
+			Q1_b[i] = Q1[i] - tau*(E_n[0]-E_i[0]) + tau*AV.D1;
+			Q2_b[i] = Q2[i] - tau*(E_n[1]-E_i[1]) + tau*AV.D2 + timeStep*H2_i;
+			Q3_b[i] = Q3[i] - tau*(E_n[2]-E_i[2]) + tau*AV.D3;
+
+			/* Get primitives */
+			A    = Result->A[i];
+			invA = Result->invA[i];
+			rho  = Q1_b[i]*invA;
+			u    = Q2_b[i]/Q1_b[i];
+			e    = Q3_b[i]*invA;
+			p    = (e-0.5*rho*u*u)*(gamma-1);
+
+			/* Calculate E-bar and H-bar */
+			Eb_cur[0] = rho*u*A;
+			Eb_cur[1] = (rho*u*u+p)*A;
+			Eb_cur[2] = u*(e+p)*A;
+			H2b_cur   = p*Result->dA_dx[i]*invA;
+		}
+
+		/*
+		** Corrector in node j = i-1; backward differencing, nodes [1, im-2]
+		**   E-bar[j] = Eb_prev, E-bar[j-1] = Eb_prev2
+		*/
+		j = i-1;
+		if (j >= 1 && ret != -1)
+		{
+			if (Result->dt)
+				timeStep = Result->dt[j];
+
+			tau = timeStep/(Result->x[j] - Result->x[j-1]);
+
+			/* Calculate artificial viscosity */
+			ret = CalcAV(gamma, epsilon, j, im-1, Result->A[j], Q1_b, Q2_b, Q3_b, &AV);
+
+			/* Calculate Q-double-bar */
+			Q1_bb = Q1[j] - tau*(Eb_prev[0]-Eb_prev2[0]) + tau*AV.D1;
+			Q2_bb = Q2[j] - tau*(Eb_prev[1]-Eb_prev2[1]) + tau*AV.D2 + timeStep*H2b_prev;
+			Q3_bb = Q3[j] - tau*(Eb_prev[2]-Eb_prev2[2]) + tau*AV.D3;
+
+			/* Use density for residual calculation */
+			rhoBefore = Q1[j]*Result->invA[j];
+			Q2Before  = Q2[j];
+			Q3Before  = Q3[j];
+
+			/* Calculate Q at the new timestep */
+			Q1[j] = 0.5*(Q1_b[j] + Q1_bb);
+			Q2[j] = 0.5*(Q2_b[j] + Q2_bb);
+			Q3[j] = 0.5*(Q3_b[j] + Q3_bb);
+
+			/* Calculate the residual and the norms */
+			rhoAfter    = Q1[j]*Result->invA[j];
+			*residual  += AddNorms(norms, (rhoAfter-rhoBefore)/timeStep,
+			                       Q2[j]-Q2Before, Q3[j]-Q3Before, Result->invA[j]/timeStep);
+
+			/* Timestep of the next iteration */
+			if (CellTimeStep(gamma, CFL, Result->x[j+1]-Result->x[j], Result->invA[j],
+			                 Q1[j], Q2[j], Q3[j], &localTimeStep) == -1)
+				ret = -1;
+			else
+			{
+				if (Result->dt)
+					Result->dt[j] = localTimeStep;
+
+				if ((j==1) || (localTimeStep < nextTimeStep))
+					nextTimeStep = localTimeStep;
+			}
+		}
+
+		/* Shift for next node */
+		Eb_prev2[0] = Eb_prev[0];
+		Eb_prev2[1] = Eb_prev[1];
+		Eb_prev2[2] = Eb_prev[2];
+
+		Eb_prev[0]  = Eb_cur[0];
+		Eb_prev[1]  = Eb_cur[1];
+		Eb_prev[2]  = Eb_cur[2];
+		H2b_prev    = H2b_cur;
+
+		E_i[0] = E_n[0];
+		E_i[1] = E_n[1];
+		E_i[2] = E_n[2];
+		H2_i   = H2_n;
+	}
+
+	Result->timeStep = nextTimeStep;
+	if (Result->dt)
+		Result->dt[0] = Result->dt[1];
+
+	/* Trace the new field */
+	if (TRACE_ON(TRACE_SOLVER, TRACE_CELL))
+		for (i=0; i<im; i++)
+			TRACE(TRACE_SOLVER, TRACE_CELL, TRACE_EV_FIELD, i, Q1[i], Q2[i], Q3[i], 0);
+
+	return ret;
+}
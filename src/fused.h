@@ -0,0 +1,19 @@
+/*
+** Header-file for Fused
+*/
+
+#ifndef FUSED_H
+#define FUSED_H
+
+/* Number of scratch arrays used by FusedMacCormack */
+#define FUSED_MACCORMACK_SCRATCH 3
+
+/* Fused Roe, one variant per reconstruction */
+int FusedRoeConstant(tData*, tResult*, double*);
+int FusedRoeVanLeer(tData*, tResult*, double*);
+int FusedRoeVanAlbada(tData*, tResult*, double*);
+int FusedRoeKappa(tData*, tResult*, double*);
+
+int FusedMacCormack(tData*, tResult*, double*);
+
+#endif
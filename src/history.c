@@ -0,0 +1,177 @@
+/*
+** Residual history
+**    The normalised residual of every iteration is collected in
+**    a buffer of HISTORY_BLOCK values, which is written to the
+**    history file in one fwrite when it is full. The file holds
+**    the magic HISTORY_MAGIC and the number of the first
+**    iteration (32 bits), followed by the residuals as raw
+**    doubles; the iteration number follows from the position in
+**    the file, so after a restart it goes on from the checkpoint.
+**    ConvertHistory (program nozzleconv) writes the GNUPlot text;
+**    it also reads the files of HISTORY_MAGIC_1, which have no
+**    first iteration and start at 1.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "history.h"
+
+#define HISTORY_MAGIC   "NZRESID2"
+#define HISTORY_MAGIC_1 "NZRESID1"
+
+/*
+** Function FlushHistory
+**    Writes the buffered residuals to the history file.
+*/
+
+static int FlushHistory(tHistory *History)
+{
+	int ret;
+
+	ret = 0;
+
+	if (History->file && History->n > 0)
+	{
+		if (fwrite(History->buffer, sizeof(double), History->n, History->file) != (size_t)History->n)
+		{
+			fprintf(stderr, "ERROR in function FlushHistory: Could not write residual history.\n");
+			ret = -1;
+		}
+	}
+
+	History->n = 0;
+
+	return ret;
+}
+
+/*
+** Function OpenHistory
+**    Creates the history file.
+**
+** In:       char     fileName = name of the history file
+**           int      first    = number of the first iteration
+** Out:      tHistory History  = empty history
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int OpenHistory(tHistory *History, char *fileName, int first)
+{
+	int     ret;
+	int32_t first32 = first;
+
+	ret = 0;
+
+	History->n     = 0;
+	History->total = 0;
+	History->file  = fopen(fileName, "wb");
+
+	if (History->file == NULL || fwrite(HISTORY_MAGIC, 1, 8, History->file) != 8 ||
+	    fwrite(&first32, sizeof(first32), 1, History->file) != 1)
+	{
+		fprintf(stderr, "ERROR in function OpenHistory: Could not open '%s'.\n", fileName);
+		ret = -1;
+	}
+
+	return ret;
+}
+
+/*
+** Function AddHistory
+**    Appends the residual of one iteration.
+**
+** In:       double   residual = normalised residual
+** Out:      tHistory History  = history
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int AddHistory(tHistory *History, double residual)
+{
+	int ret;
+
+	ret = 0;
+
+	History->buffer[History->n++] = residual;
+	History->total++;
+
+	if (History->n == HISTORY_BLOCK)
+		ret = FlushHistory(History);
+
+	return ret;
+}
+
+/*
+** Function CloseHistory
+**    Writes the remaining residuals and closes the history file.
+**
+** In:       tHistory History = history
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int CloseHistory(tHistory *History)
+{
+	int ret;
+
+	ret = FlushHistory(History);
+
+	if (History->file)
+	{
+		if (fclose(History->file) != 0)
+			ret = -1;
+		History->file = NULL;
+	}
+
+	return ret;
+}
+
+/*
+** Function ConvertHistory
+**    Converts a history file into the GNUPlot text format.
+**
+** In:       FILE in  = opened history file
+**           FILE out = output stream
+** Out:      -
+** Return:   number of iterations, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int ConvertHistory(FILE *in, FILE *out)
+{
+	int     i, j, n, total;
+	char    magic[8];
+	int32_t first;
+	double  buffer[HISTORY_BLOCK];
+
+	first = 1;
+	if (fread(magic, 1, 8, in) != 8 ||
+	    (memcmp(magic, HISTORY_MAGIC_1, 8) != 0 &&
+	     (memcmp(magic, HISTORY_MAGIC, 8) != 0 || fread(&first, sizeof(first), 1, in) != 1)))
+	{
+		fprintf(stderr, "ERROR in function ConvertHistory: Not a residual history file.\n");
+		return -1;
+	}
+
+	fprintf(out, "#   I   Residual\n");
+
+	i     = first;
+	total = 0;
+	while ((n = (int)fread(buffer, sizeof(double), HISTORY_BLOCK, in)) > 0)
+	{
+		for (j=0; j<n; j++)
+			fprintf(out, "%5d %10.7f\n", i++, buffer[j]);
+		total += n;
+	}
+
+	return total;
+}
@@ -0,0 +1,24 @@
+/*
+** Header-file for History
+*/
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/* Residuals buffered in memory before a bulk write */
+#define HISTORY_BLOCK 4096
+
+typedef struct
+{
+	FILE   *file;
+	int    n;
+	int    total;
+	double buffer[HISTORY_BLOCK];
+} tHistory;
+
+int OpenHistory(tHistory*, char*, int);
+int AddHistory(tHistory*, double);
+int CloseHistory(tHistory*);
+int ConvertHistory(FILE*, FILE*);
+
+#endif
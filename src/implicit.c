@@ -0,0 +1,523 @@
+/*
+** Function Implicit
+**    Backward Euler with the first order Roe scheme. The flux
+**    through interface i+1/2 is linearised as
+**
+**      dF = 0.5*(A_i + |A~|) dQ_i + 0.5*(A_i+1 - |A~|) dQ_i+1
+**
+**    with A the Jacobian of E(Q) in the node and |A~| the Roe
+**    matrix of the interface, with the entropy fix of RoeFlux;
+**    the source term H2 is linearised in the node itself. Per
+**    step the block-tridiagonal system
+**
+**      (I + dt dR/dQ) dQ = -dt R(Q)
+**
+**    of the inner nodes is solved directly with the block
+**    Thomas algorithm (3x3 blocks, O(im)). The boundary nodes
+**    are not part of the system: the inlet is fixed and the
+**    exit follows from Boundary after the step. Coupling the
+**    exit implicitly lets a shock run to the exit, to the
+**    other steady state of this exit condition.
+**
+**    A step that would change rho or p in a node by more than
+**    IMPLICIT_MAXCHANGE is scaled down as a whole.
+**
+**    Any CFL is allowed; it is ramped geometrically from
+**    IMPLICIT_CFL_START to the CFL of the data-file over the
+**    first cfl_ramp steps (see RampCFL).
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results
+**           double  residual = residual for convergence testing
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "main.h"
+#include "implicit.h"
+#include "norms.h"
+#include "roe.h"
+#include "trace.h"
+
+/*
+** Function EulerJacobian
+**    Jacobian dE/dQ in a node; E(Q) is the one-dimensional
+**    Euler flux of Q, also with the area in Q and E.
+*/
+
+static void EulerJacobian(double gamma, double Q1, double Q2, double Q3, double J[3][3])
+{
+	double u, H;
+
+	u = Q2/Q1;
+	H = (gamma*Q3 - 0.5*(gamma-1)*Q1*u*u)/Q1;
+
+	J[0][0] = 0;
+	J[0][1] = 1;
+	J[0][2] = 0;
+
+	J[1][0] = 0.5*(gamma-3)*u*u;
+	J[1][1] = (3-gamma)*u;
+	J[1][2] = gamma-1;
+
+	J[2][0] = u*(0.5*(gamma-1)*u*u - H);
+	J[2][1] = H - (gamma-1)*u*u;
+	J[2][2] = gamma*u;
+}
+
+/*
+** Function RoeMatrix
+**    Matrix |A~| = R |Lambda| R^-1 of an interface; the same
+**    Roe averages and entropy fix as RoeFlux.
+*/
+
+static void RoeMatrix(double gamma, double epsilon, const tConservative *left, const tConservative *right,
+                      double M[3][3])
+{
+	int    k, r, c;
+	double u_l, u_r, p_l, p_r, H_l, H_r;
+	double R, u, H, a, b1, b2;
+	double lambda[3];
+	double Rv[3][3], Lv[3][3];
+
+	u_l = left->Q2/left->Q1;
+	u_r = right->Q2/right->Q1;
+
+	p_l = (left->Q3  - 0.5*left->Q1*u_l*u_l)*(gamma-1);
+	p_r = (right->Q3 - 0.5*right->Q1*u_r*u_r)*(gamma-1);
+
+	H_l = (left->Q3  + p_l)/left->Q1;
+	H_r = (right->Q3 + p_r)/right->Q1;
+
+	R   = sqrt(right->Q1/left->Q1);
+	u   = (u_l + R*u_r)/(1+R);
+	H   = (H_l + R*H_r)/(1+R);
+	a   = sqrt((gamma-1)*(H - 0.5*u*u));
+
+	lambda[0] = fabs(u - a);
+	lambda[1] = fabs(u);
+	lambda[2] = fabs(u + a);
+
+	for (k=0; k<3; k++)
+		if (lambda[k] < epsilon)
+			lambda[k] = 0.5*(lambda[k]/epsilon + epsilon);
+
+	/* Right eigenvectors as columns */
+	Rv[0][0] = 1;       Rv[0][1] = 1;       Rv[0][2] = 1;
+	Rv[1][0] = u - a;   Rv[1][1] = u;       Rv[1][2] = u + a;
+	Rv[2][0] = H - u*a; Rv[2][1] = 0.5*u*u; Rv[2][2] = H + u*a;
+
+	/* Left eigenvectors as rows */
+	b1 = (gamma-1)/(a*a);
+	b2 = 0.5*u*u*b1;
+
+	Lv[0][0] = 0.5*(b2 + u/a); Lv[0][1] = -0.5*(b1*u + 1/a); Lv[0][2] = 0.5*b1;
+	Lv[1][0] = 1 - b2;         Lv[1][1] = b1*u;              Lv[1][2] = -b1;
+	Lv[2][0] = 0.5*(b2 - u/a); Lv[2][1] = -0.5*(b1*u - 1/a); Lv[2][2] = 0.5*b1;
+
+	for (r=0; r<3; r++)
+		for (c=0; c<3; c++)
+			M[r][c] = Rv[r][0]*lambda[0]*Lv[0][c] + Rv[r][1]*lambda[1]*Lv[1][c] + Rv[r][2]*lambda[2]*Lv[2][c];
+}
+
+/*
+** Function Invert
+**    Inverse of a 3x3 matrix; -1 when it is singular.
+*/
+
+static int Invert(double M[3][3], double I[3][3])
+{
+	int    r, c;
+	double det;
+
+	I[0][0] =   M[1][1]*M[2][2] - M[1][2]*M[2][1];
+	I[0][1] = -(M[0][1]*M[2][2] - M[0][2]*M[2][1]);
+	I[0][2] =   M[0][1]*M[1][2] - M[0][2]*M[1][1];
+	I[1][0] = -(M[1][0]*M[2][2] - M[1][2]*M[2][0]);
+	I[1][1] =   M[0][0]*M[2][2] - M[0][2]*M[2][0];
+	I[1][2] = -(M[0][0]*M[1][2] - M[0][2]*M[1][0]);
+	I[2][0] =   M[1][0]*M[2][1] - M[1][1]*M[2][0];
+	I[2][1] = -(M[0][0]*M[2][1] - M[0][1]*M[2][0]);
+	I[2][2] =   M[0][0]*M[1][1] - M[0][1]*M[1][0];
+
+	det = M[0][0]*I[0][0] + M[0][1]*I[1][0] + M[0][2]*I[2][0];
+	if (det == 0 || !isfinite(det))
+		return -1;
+
+	for (r=0; r<3; r++)
+		for (c=0; c<3; c++)
+			I[r][c] /= det;
+
+	return 0;
+}
+
+/*
+** Function Interface
+**    Matrix |A~| of interface i+1/2 of the current field.
+*/
+
+static void Interface(tData *Data, tResult *Result, int i, double M[3][3])
+{
+	tConservative left, right;
+
+	left.Q1  = Result->Q1[i];   left.Q2  = Result->Q2[i];   left.Q3  = Result->Q3[i];
+	right.Q1 = Result->Q1[i+1]; right.Q2 = Result->Q2[i+1]; right.Q3 = Result->Q3[i+1];
+
+	RoeMatrix(Data->gamma, Data->epsilon, &left, &right, M);
+}
+
+/*
+** Function NodeBlocks
+**    Blocks of row i of I + dt dR/dQ: Lo left of the diagonal
+**    (i > 1), the diagonal D and Up right of it (i < im-2).
+**    absLeft and absRight are |A~| of interfaces i-1/2 and
+**    i+1/2.
+*/
+
+static void NodeBlocks(tData *Data, tResult *Result, int i, double dt,
+                       double absLeft[3][3], double absRight[3][3],
+                       double Lo[3][3], double D[3][3], double Up[3][3])
+{
+	int    r, c;
+	double gamma, tau, u;
+	double dH[3];
+	double J[3][3];
+
+	gamma = Data->gamma;
+	tau   = dt/Result->dx[i];
+
+	/* Source term: dH2/dQ = (gamma-1) dA/dx / A * (u^2/2, -u, 1) */
+	u     = Result->Q2[i]/Result->Q1[i];
+	dH[0] = (gamma-1)*Result->dA_dx[i]*Result->invA[i]*0.5*u*u;
+	dH[1] = -(gamma-1)*Result->dA_dx[i]*Result->invA[i]*u;
+	dH[2] = (gamma-1)*Result->dA_dx[i]*Result->invA[i];
+
+	for (r=0; r<3; r++)
+		for (c=0; c<3; c++)
+			D[r][c] = (r == c) + 0.5*tau*(absLeft[r][c] + absRight[r][c]) - (r == 1 ? dt*dH[c] : 0);
+
+	/* The exit node is not in the system */
+	if (i < Data->im-2)
+	{
+		EulerJacobian(gamma, Result->Q1[i+1], Result->Q2[i+1], Result->Q3[i+1], J);
+
+		for (r=0; r<3; r++)
+			for (c=0; c<3; c++)
+				Up[r][c] = 0.5*tau*(J[r][c] - absRight[r][c]);
+	}
+
+	/* The inlet node is not in the system */
+	if (i > 1)
+	{
+		EulerJacobian(gamma, Result->Q1[i-1], Result->Q2[i-1], Result->Q3[i-1], J);
+
+		for (r=0; r<3; r++)
+			for (c=0; c<3; c++)
+				Lo[r][c] = -0.5*tau*(J[r][c] + absLeft[r][c]);
+	}
+}
+
+/*
+** Function ImplicitFactor
+**    Block LU factorisation of I + dt dR/dQ of the first order
+**    Roe scheme for the inner nodes of the current field, with
+**    a timestep per node; used as preconditioner. The blocks
+**    of inner node i (from 1) start at 9*(i-1): Lo, the
+**    inverse of the eliminated diagonal D' and C = D'^-1 Up.
+**
+** In:       tData   Data   = structure containing all data
+**           tResult Result = structure containing results
+**           double  dt     = timestep per node
+** Out:      double  Lo, Dinv, C = factors, 9*(im-2) each
+** Return:   0 on success, -1 for a singular block
+**
+** Author:   J.L. Klaufus
+*/
+
+int ImplicitFactor(tData *Data, tResult *Result, double *dt, double *Lo, double *Dinv, double *C)
+{
+	int    i, r, c, k, n;
+	double absLeft[3][3], absRight[3][3];
+	double L[3][3], D[3][3], U[3][3], I[3][3];
+
+	Interface(Data, Result, 0, absRight);
+
+	for (i=1; i<Data->im-1; i++)
+	{
+		n = 9*(i-1);
+
+		for (r=0; r<3; r++)
+			for (c=0; c<3; c++)
+				absLeft[r][c] = absRight[r][c];
+
+		Interface(Data, Result, i, absRight);
+		NodeBlocks(Data, Result, i, dt[i], absLeft, absRight, L, D, U);
+
+		if (i > 1)
+			for (r=0; r<3; r++)
+				for (c=0; c<3; c++)
+				{
+					Lo[n+3*r+c] = L[r][c];
+
+					for (k=0; k<3; k++)
+						D[r][c] -= L[r][k]*C[n-9+3*k+c];
+				}
+
+		if (Invert(D, I) == -1)
+		{
+			fprintf(stderr, "ERROR in function ImplicitFactor: singular block in node %d.\n", i);
+			return -1;
+		}
+
+		for (r=0; r<3; r++)
+			for (c=0; c<3; c++)
+			{
+				Dinv[n+3*r+c] = I[r][c];
+				C[n+3*r+c]    = (i < Data->im-2) ? I[r][0]*U[0][c] + I[r][1]*U[1][c] + I[r][2]*U[2][c] : 0;
+			}
+	}
+
+	return 0;
+}
+
+/*
+** Function ImplicitSolve
+**    Solves the factorised system of ImplicitFactor in place;
+**    the values of inner node i start at x[3*(i-1)].
+**
+** In:       int    im           = number of nodes
+**           double Lo, Dinv, C  = factors of ImplicitFactor
+**           double x            = right hand side
+** Out:      double x            = solution
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void ImplicitSolve(int im, double *Lo, double *Dinv, double *C, double *x)
+{
+	int    i, r, n;
+	double b[3];
+
+	for (i=1; i<im-1; i++)
+	{
+		n = 3*(i-1);
+
+		for (r=0; r<3; r++)
+		{
+			b[r] = x[n+r];
+
+			if (i > 1)
+				b[r] -= Lo[3*n+3*r]*x[n-3] + Lo[3*n+3*r+1]*x[n-2] + Lo[3*n+3*r+2]*x[n-1];
+		}
+
+		for (r=0; r<3; r++)
+			x[n+r] = Dinv[3*n+3*r]*b[0] + Dinv[3*n+3*r+1]*b[1] + Dinv[3*n+3*r+2]*b[2];
+	}
+
+	for (i=im-3; i>=1; i--)
+	{
+		n = 3*(i-1);
+
+		for (r=0; r<3; r++)
+			x[n+r] -= C[3*n+3*r]*x[n+3] + C[3*n+3*r+1]*x[n+4] + C[3*n+3*r+2]*x[n+5];
+	}
+}
+
+/*
+** Function RampCFL
+**    CFL of step n (counting from 0): geometric from
+**    IMPLICIT_CFL_START to the CFL of the data-file over the
+**    first cfl_ramp steps, the CFL of the data-file after.
+**
+** In:       tData Data = structure containing all data
+**           long  n    = number of steps done
+** Out:      -
+** Return:   CFL of the step
+**
+** Author:   J.L. Klaufus
+*/
+
+double RampCFL(tData *Data, long n)
+{
+	if (n >= Data->cflRamp || Data->CFL <= IMPLICIT_CFL_START)
+		return Data->CFL;
+
+	return IMPLICIT_CFL_START*pow(Data->CFL/IMPLICIT_CFL_START, (double)n/Data->cflRamp);
+}
+
+int Implicit(tData *Data, tResult *Result, double *residual)
+{
+	int    ret;
+	int    i, im, r, c, k;
+	double gamma, epsilon;
+	double ramp, dt, tau, u;
+	double pA, dpA, change, omega, rhoDot;
+	double *norms;
+	double rhs[3], s[3];
+	double E_l[3], E_r[3], E_tilde[3];
+	double absLeft[3][3], absRight[3][3];
+	double Lo[3][3], D[3][3], Up[3][3], Dinv[3][3];
+	double *C[9], *g[3], *F[3];
+	double *Q[3], *E[3];
+
+	tConservative left, right;
+
+	ret = 0;
+
+	if (Result->nScratch < IMPLICIT_SCRATCH)
+	{
+		fprintf(stderr, "ERROR in function Implicit: No workspace allocated.\n");
+		return -1;
+	}
+
+	im      = Data->im;
+	gamma   = Data->gamma;
+	epsilon = Data->epsilon;
+
+	for (k=0; k<9; k++)
+		C[k] = Result->scratch[k];
+
+	for (c=0; c<3; c++)
+	{
+		g[c] = Result->scratch[9+c];
+		F[c] = Result->scratch[12+c];
+	}
+
+	Q[0] = Result->Q1; Q[1] = Result->Q2; Q[2] = Result->Q3;
+	E[0] = Result->E1; E[1] = Result->E2; E[2] = Result->E3;
+
+	/* TimeStep used the CFL of the data-file; scale to the CFL of this step */
+	ramp = RampCFL(Data, Result->sweeps)/Data->CFL;
+	if (ramp != 1)
+	{
+		Result->timeStep *= ramp;
+
+		if (Result->dt)
+			for (i=0; i<im; i++)
+				Result->dt[i] *= ramp;
+	}
+
+	/* Fluxes through all interfaces of the old field */
+	for (i=0; i<im-1; i++)
+	{
+		left.Q1  = Q[0][i];   left.Q2  = Q[1][i];   left.Q3  = Q[2][i];
+		right.Q1 = Q[0][i+1]; right.Q2 = Q[1][i+1]; right.Q3 = Q[2][i+1];
+
+		for (c=0; c<3; c++)
+		{
+			E_l[c] = E[c][i];
+			E_r[c] = E[c][i+1];
+		}
+
+		RoeFlux(gamma, epsilon, &left, &right, E_l, E_r, E_tilde);
+
+		for (c=0; c<3; c++)
+			F[c][i] = E_tilde[c];
+	}
+
+	/* Roe matrix of the interface left of node 1 */
+	Interface(Data, Result, 0, absRight);
+
+	/*
+	** Forward elimination; node i holds C_i = D'^-1 U_i and
+	** g_i = D'^-1 rhs'_i, with D' and rhs' after elimination
+	** of the block left of the diagonal
+	*/
+	for (i=1; i<im-1 && ret!=-1; i++)
+	{
+		dt  = Result->dt ? Result->dt[i] : Result->timeStep;
+		tau = dt/Result->dx[i];
+
+		for (r=0; r<3; r++)
+			for (c=0; c<3; c++)
+				absLeft[r][c] = absRight[r][c];
+
+		Interface(Data, Result, i, absRight);
+		NodeBlocks(Data, Result, i, dt, absLeft, absRight, Lo, D, Up);
+
+		for (r=0; r<3; r++)
+			rhs[r] = -tau*(F[r][i] - F[r][i-1]) + (r == 1 ? dt*Result->H2[i] : 0);
+
+		/* Eliminate the block left of the diagonal */
+		if (i > 1)
+		{
+			for (r=0; r<3; r++)
+			{
+				for (c=0; c<3; c++)
+					for (k=0; k<3; k++)
+						D[r][c] -= Lo[r][k]*C[3*k+c][i-1];
+
+				for (k=0; k<3; k++)
+					rhs[r] -= Lo[r][k]*g[k][i-1];
+			}
+		}
+
+		if (Invert(D, Dinv) == -1)
+		{
+			fprintf(stderr, "ERROR in function Implicit: singular block in node %d.\n", i);
+			TRACE(TRACE_SOLVER, TRACE_ERROR, TRACE_EV_ERROR, i, Q[0][i], Q[1][i], Q[2][i], 0);
+			ret = -1;
+		}
+		else
+		{
+			for (r=0; r<3; r++)
+			{
+				g[r][i] = Dinv[r][0]*rhs[0] + Dinv[r][1]*rhs[1] + Dinv[r][2]*rhs[2];
+
+				if (i < im-2)
+					for (c=0; c<3; c++)
+						C[3*r+c][i] = Dinv[r][0]*Up[0][c] + Dinv[r][1]*Up[1][c] + Dinv[r][2]*Up[2][c];
+			}
+		}
+	}
+
+	/* Back substitution: g becomes dQ */
+	for (i=im-3; i>=1 && ret!=-1; i--)
+	{
+		for (r=0; r<3; r++)
+			s[r] = C[3*r][i]*g[0][i+1] + C[3*r+1][i]*g[1][i+1] + C[3*r+2][i]*g[2][i+1];
+
+		for (r=0; r<3; r++)
+			g[r][i] -= s[r];
+	}
+
+	/* Relaxation: no node may change rho or p (linearised) by more than IMPLICIT_MAXCHANGE */
+	change = 0;
+	for (i=1; i<im-1 && ret!=-1; i++)
+	{
+		u      = Q[1][i]/Q[0][i];
+		pA     = (Q[2][i] - 0.5*Q[1][i]*u)*(gamma-1);
+		dpA    = (g[2][i] - u*g[1][i] + 0.5*u*u*g[0][i])*(gamma-1);
+
+		change = fmax(change, fabs(g[0][i]/Q[0][i]));
+		change = fmax(change, fabs(dpA/pA));
+	}
+
+	omega = (change > IMPLICIT_MAXCHANGE) ? IMPLICIT_MAXCHANGE/change : 1;
+
+	/* Update of the inner field; the residual and the norms are those of the old field, as for the explicit schemes */
+	*residual = 0;
+	ClearNorms(Result->norms);
+	norms     = Result->monitor ? Result->norms : NULL;
+	for (i=1; i<im-1 && ret!=-1; i++)
+	{
+		rhoDot     = -(F[0][i] - F[0][i-1])/Result->dx[i]*Result->invA[i];
+		*residual += AddNorms(norms, rhoDot, -(F[1][i] - F[1][i-1])/Result->dx[i] + Result->H2[i],
+		                      -(F[2][i] - F[2][i-1])/Result->dx[i], Result->invA[i]);
+
+		for (c=0; c<3; c++)
+			Q[c][i] += omega*g[c][i];
+	}
+
+	/* Trace the new field */
+	if (TRACE_ON(TRACE_SOLVER, TRACE_CELL))
+		for (i=0; i<im; i++)
+			TRACE(TRACE_SOLVER, TRACE_CELL, TRACE_EV_FIELD, i, Q[0][i], Q[1][i], Q[2][i], 0);
+
+	return ret;
+}
@@ -0,0 +1,22 @@
+/*
+** Header-file for Implicit
+*/
+
+#ifndef IMPLICIT_H
+#define IMPLICIT_H
+
+/* Number of scratch arrays used by Implicit: C (3x3), g and the fluxes */
+#define IMPLICIT_SCRATCH 15
+
+/* Largest relative change of rho and p in one step; larger steps are scaled down */
+#define IMPLICIT_MAXCHANGE 0.5
+
+/* CFL at the start of the ramp to the CFL of the data-file */
+#define IMPLICIT_CFL_START 1.0
+
+int    Implicit(tData*, tResult*, double*);
+double RampCFL(tData*, long);
+int    ImplicitFactor(tData*, tResult*, double*, double*, double*, double*);
+void   ImplicitSolve(int, double*, double*, double*, double*);
+
+#endif
@@ -14,6 +14,7 @@
 #include <math.h>
 
 #include "main.h"
+#include "derivative.h"
 #include "initialise.h"
 
 int Init(FILE *log, tData *Data, tResult *Result)
@@ -38,8 +39,6 @@ int Init(FILE *log, tData *Data, tResult *Result)
 
 	double rho, u, p;
 
-	printf("Initialising...\n");
-
 	ret = 0;
 
 	/* Get handy variables */
@@ -61,6 +60,9 @@ int Init(FILE *log, tData *Data, tResult *Result)
 	Data->T_start = T_start;
 	Data->a_start = a_start;
 	Data->u_start = u_start;
+
+	/* Timestep is calculated in the first iteration */
+	Result->timeStep = 0;
 	
 	/* Initialise field */
 	for (i=0; i<im; i++)
@@ -70,7 +72,8 @@ int Init(FILE *log, tData *Data, tResult *Result)
 		Result->x[i] = i*deltaX;
 
 		/* Calculate areas */
-		Result->A[i] = AREA(Result->x[i]);
+		Result->A[i]    = AREA(Result->x[i]);
+		Result->invA[i] = 1/Result->A[i];
 
 		/* Quess starting conditions */
 		rho = rho_start;
@@ -87,6 +90,16 @@ int Init(FILE *log, tData *Data, tResult *Result)
 		Result->Q3[i] = (rho*u*u/2 + p/(gamma-1))*Result->A[i];
 	}
 
+	/*
+	** The geometry does not change during the solve; tabulate
+	** the area derivative once so the solvers do not need to
+	** refine it for every node on every iteration.
+	*/
+	for (i=0; i<im; i++)
+		Result->dA_dx[i] = Derivative(i, Result);
+
+	CellWidths(Result, Data->adapt <= 0);
+
 	/* Write report */
 	if (log)
 	{
@@ -106,3 +119,37 @@ int Init(FILE *log, tData *Data, tResult *Result)
 	return ret;
 }
 
+
+/*
+** Function CellWidths
+**   Tabulates the width of the cell of every node, which the
+**   finite volume updates divide the flux difference by. On a
+**   uniform grid this is x[i+1] - x[i]; on a non-uniform grid it
+**   is the distance between the midpoints of the neighbouring
+**   intervals, (x[i+1] - x[i-1])/2, or the update would not be
+**   conservative.
+**
+** In:       tResult Result  = grid
+**           int     uniform = 1 for a uniform grid
+** Out:      tResult Result  = dx is set
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void CellWidths(tResult *Result, int uniform)
+{
+	int i, im;
+
+	im = Result->im;
+
+	for (i=0; i<im-1; i++)
+	{
+		if (uniform || i == 0)
+			Result->dx[i] = Result->x[i+1] - Result->x[i];
+		else
+			Result->dx[i] = 0.5*(Result->x[i+1] - Result->x[i-1]);
+	}
+
+	Result->dx[im-1] = Result->x[im-1] - Result->x[im-2];
+}
@@ -5,6 +5,7 @@
 #ifndef INIT_H
 #define INIT_H
 
-int Init(FILE*, tData*, tResult*);
+int  Init(FILE*, tData*, tResult*);
+void CellWidths(tResult*, int);
 
 #endif
@@ -0,0 +1,242 @@
+/*
+** Integrator
+**    Multistage time integration of Roe's scheme. Every stage
+**    evaluates the spatial residual
+**
+**      R(Q)[i] = -(E~[i+1/2] - E~[i-1/2])/dx + H[i]
+**
+**    of the field of the previous stage and sets, in the
+**    Shu-Osher form,
+**
+**      Q(k) = a[k] Q(0) + (1-a[k]) Q(k-1) + b[k] dt R(Q(k-1))
+**
+**    The SSP schemes keep the total variation of the forward
+**    Euler step at the same CFL (time-accurate runs); the low
+**    storage schemes Q(k) = Q(0) + alpha[k] dt R(Q(k-1)) have
+**    the coefficients of Van Leer, Tai and Powell, which damp
+**    the high frequencies of the first order upwind scheme best,
+**    for CFL 2 (4 stages) and 2.5 (5 stages).
+**
+**    The timestep is that of the field at the start of the step.
+**    The stages only need Q(0) and R besides the field itself;
+**    with residual smoothing, R of every stage is smoothed.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "main.h"
+#include "boundary.h"
+#include "eh.h"
+#include "integrator.h"
+#include "norms.h"
+#include "roe.h"
+#include "flux.h"
+#include "schemes.h"
+#include "smoothing.h"
+#include "trace.h"
+
+typedef struct
+{
+	int    stages;
+	double a[INTEGRATOR_STAGES];   /* weight of Q(0) */
+	double b[INTEGRATOR_STAGES];   /* weight of dt R(Q(k-1)) */
+} tIntegrator;
+
+/* Indexed by integrator; forward Euler uses the in-place solvers */
+static const tIntegrator integrators[] =
+{
+	{1, {0},                              {1}},
+	{2, {0, 0.5},                         {1, 0.5}},
+	{3, {0, 0.75, 1.0/3},                 {1, 0.25, 2.0/3}},
+	{4, {1, 1, 1, 1},                     {0.0833, 0.2069, 0.4265, 1}},
+	{5, {1, 1, 1, 1, 1},                  {0.0533, 0.1263, 0.2375, 0.4414, 1}}
+};
+
+/*
+** Function IntegratorName
+**    Returns the keyword of an integrator for reports.
+*/
+
+char *IntegratorName(int integrator)
+{
+	switch (integrator)
+	{
+		case INTEGRATOR_SSPRK2: return "ssprk2";
+		case INTEGRATOR_SSPRK3: return "ssprk3";
+		case INTEGRATOR_LSRK4:  return "lsrk4";
+		case INTEGRATOR_LSRK5:  return "lsrk5";
+		default:                return "euler";
+	}
+}
+
+/*
+** Function Residual
+**    Spatial residual of Roe's scheme, or of the interface flux
+**    of the data-file, in the inner nodes; E and H must belong
+**    to the field.
+*/
+
+__attribute__((always_inline))
+static inline void Residual(tData *Data, tResult *Result, double **R, const int recon)
+{
+	int    i, c, im;
+	double dx;
+
+	tConservative left, right;
+
+	double E_l[3], E_r[3];
+	double E_tilde_right[3], E_tilde_left[3];
+
+	im = Data->im;
+
+	for (i=0; i<im-1; i++)
+	{
+		Reconstruct(recon, Data->gamma, Data->kappa, im, Result->Q1, Result->Q2, Result->Q3, i, &left, &right);
+
+		E_l[0] = Result->E1[i];
+		E_l[1] = Result->E2[i];
+		E_l[2] = Result->E3[i];
+
+		E_r[0] = Result->E1[i+1];
+		E_r[1] = Result->E2[i+1];
+		E_r[2] = Result->E3[i+1];
+
+		InterfaceFlux(Data->flux, Data->gamma, Data->epsilon, &left, &right, E_l, E_r, E_tilde_right);
+
+		if (i>0)
+		{
+			dx = Result->dx[i];
+
+			for (c=0; c<3; c++)
+				R[c][i] = -(E_tilde_right[c] - E_tilde_left[c])/dx;
+
+			R[1][i] += Result->H2[i];
+		}
+
+		for (c=0; c<3; c++)
+			E_tilde_left[c] = E_tilde_right[c];
+	}
+}
+
+/*
+** Function RungeKutta
+**    One step of the selected integrator. E, H and the timestep
+**    of the field are computed by the caller (see Step); the
+**    exit is updated by Boundary between the stages and by the
+**    caller after the last one.
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results
+**           double  residual = residual for convergence testing
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+__attribute__((always_inline))
+static inline int RungeKutta(tData *Data, tResult *Result, double *residual, const int recon)
+{
+	int    ret;
+	int    i, c, k, im;
+	double a, b, dt, rhoAfter;
+	double *Q[3], *Q0[3], *R[3], *norms;
+
+	const tIntegrator *I;
+
+	ret = 0;
+	im  = Data->im;
+	I   = &integrators[Data->integrator];
+
+	if (Result->nScratch < INTEGRATOR_SCRATCH)
+	{
+		fprintf(stderr, "ERROR in function RungeKutta: No workspace allocated.\n");
+		return -1;
+	}
+
+	Q[0] = Result->Q1;
+	Q[1] = Result->Q2;
+	Q[2] = Result->Q3;
+
+	for (c=0; c<3; c++)
+	{
+		Q0[c] = Result->scratch[c];
+		R[c]  = Result->scratch[3+c];
+
+		for (i=0; i<im; i++)
+			Q0[c][i] = Q[c][i];
+	}
+
+	for (k=0; k<I->stages && ret!=-1; k++)
+	{
+		if (k > 0)
+		{
+			ret = Boundary(Data, Result);
+
+			if (ret != -1)
+				ret = CalcEH(Data, Result);
+		}
+
+		if (ret == -1)
+			break;
+
+		Residual(Data, Result, R, recon);
+
+		if (Result->irs[0])
+			SmoothArrays(Data->irs, im, Result->irs[3], R);
+
+		a = I->a[k];
+		b = I->b[k];
+
+		for (i=1; i<im-1; i++)
+		{
+			/* Local time stepping: the timestep of the node */
+			dt = Result->dt ? Result->dt[i] : Result->timeStep;
+
+			for (c=0; c<3; c++)
+				Q[c][i] = a*Q0[c][i] + (1-a)*Q[c][i] + b*dt*R[c][i];
+		}
+	}
+
+	/* Residual and norms of the whole step, as with the other schemes */
+	*residual = 0;
+	ClearNorms(Result->norms);
+	norms     = Result->monitor ? Result->norms : NULL;
+	for (i=1; i<im-1 && ret!=-1; i++)
+	{
+		dt        = Result->dt ? Result->dt[i] : Result->timeStep;
+		rhoAfter  = Q[0][i]*Result->invA[i];
+		*residual += AddNorms(norms, (rhoAfter - Q0[0][i]*Result->invA[i])/dt,
+		                      Q[1][i] - Q0[1][i], Q[2][i] - Q0[2][i], Result->invA[i]/dt);
+	}
+
+	/* Trace the new field */
+	if (TRACE_ON(TRACE_SOLVER, TRACE_CELL))
+		for (i=0; i<im; i++)
+			TRACE(TRACE_SOLVER, TRACE_CELL, TRACE_EV_FIELD, i, Result->Q1[i], Result->Q2[i], Result->Q3[i], 0);
+
+	return ret;
+}
+
+
+int RungeKuttaConstant(tData *Data, tResult *Result, double *residual)
+{
+	return RungeKutta(Data, Result, residual, RECON_CONSTANT);
+}
+
+int RungeKuttaVanLeer(tData *Data, tResult *Result, double *residual)
+{
+	return RungeKutta(Data, Result, residual, RECON_VANLEER);
+}
+
+int RungeKuttaVanAlbada(tData *Data, tResult *Result, double *residual)
+{
+	return RungeKutta(Data, Result, residual, RECON_VANALBADA);
+}
+
+int RungeKuttaKappa(tData *Data, tResult *Result, double *residual)
+{
+	return RungeKutta(Data, Result, residual, RECON_KAPPA);
+}
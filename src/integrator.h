@@ -0,0 +1,22 @@
+/*
+** Header-file for Integrator
+*/
+
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+/* Largest number of stages of an integrator */
+#define INTEGRATOR_STAGES 5
+
+/* Number of scratch arrays used by the integrators: Q(0) and R */
+#define INTEGRATOR_SCRATCH 6
+
+char *IntegratorName(int);
+
+/* Multistage Roe's scheme, one variant per reconstruction */
+int RungeKuttaConstant(tData*, tResult*, double*);
+int RungeKuttaVanLeer(tData*, tResult*, double*);
+int RungeKuttaVanAlbada(tData*, tResult*, double*);
+int RungeKuttaKappa(tData*, tResult*, double*);
+
+#endif
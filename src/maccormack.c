@@ -14,26 +14,27 @@
 */
 
 #include <stdio.h>
-#include <stdlib.h>
 #include <math.h>
 
 #include "main.h"
 #include "av.h"
-#include "derivative.h"
 #include "maccormack.h"
+#include "norms.h"
+#include "trace.h"
 
-int MacCormack(FILE *log, tData *Data, tResult *Result, double *residual)
+int MacCormack(tData *Data, tResult *Result, double *residual)
 {
 	int ret;
 
 	int i, im;
 
-	double A, rho, e, p, u;
+	double A, invA, rho, e, p, u;
 	double gamma;
 	double timeStep;
 	double deltaX;
 	double tau;
-	double rhoBefore, rhoAfter;
+	double rhoBefore, rhoAfter, Q2Before, Q3Before;
+	double *norms;
 
 	tAV    AV;
 
@@ -61,30 +62,30 @@ int MacCormack(FILE *log, tData *Data, tResult *Result, double *residual)
 	gamma    = Data->gamma;
 	timeStep = Result->timeStep;
 
-	/* Allocate memory for temporary arrays */
-	Q1_b  = (double*)malloc(Data->im*sizeof(double));
-	Q2_b  = (double*)malloc(Data->im*sizeof(double));
-	Q3_b  = (double*)malloc(Data->im*sizeof(double));
-
-	Q1_bb = (double*)malloc(Data->im*sizeof(double));
-	Q2_bb = (double*)malloc(Data->im*sizeof(double));
-	Q3_bb = (double*)malloc(Data->im*sizeof(double));
-
-	E1_b  = (double*)malloc(Data->im*sizeof(double));
-	E2_b  = (double*)malloc(Data->im*sizeof(double));
-	E3_b  = (double*)malloc(Data->im*sizeof(double));
-
-	H2_b  = (double*)malloc(Data->im*sizeof(double));
-
-	if ((Q1_b == NULL)  || (Q2_b == NULL)  || (Q3_b == NULL) ||
-	    (E1_b == NULL)  || (E2_b == NULL)  || (E3_b == NULL) ||
-	    (H2_b == NULL)  ||
-	    (Q1_bb == NULL) || (Q2_bb == NULL) || (Q3_bb == NULL))
+	/* Temporary arrays live in the solver workspace */
+	if (Result->nScratch < MACCORMACK_SCRATCH)
 	{
-		fprintf(stderr, "ERROR in function MacCormack: Could not allocate memory.\n");
+		fprintf(stderr, "ERROR in function MacCormack: No workspace allocated.\n");
 		ret = -1;
 	}
 	else
+	{
+		Q1_b  = Result->scratch[0];
+		Q2_b  = Result->scratch[1];
+		Q3_b  = Result->scratch[2];
+
+		Q1_bb = Result->scratch[3];
+		Q2_bb = Result->scratch[4];
+		Q3_bb = Result->scratch[5];
+
+		E1_b  = Result->scratch[6];
+		E2_b  = Result->scratch[7];
+		E3_b  = Result->scratch[8];
+
+		H2_b  = Result->scratch[9];
+	}
+
+	if (ret != -1)
 	{
 		/*
 		** Predictor step; using forward differencing
@@ -94,10 +95,15 @@ int MacCormack(FILE *log, tData *Data, tResult *Result, double *residual)
 		for(i=0; i<im-1 && ret!=-1; i++)
 		{
 			deltaX = Result->x[i+1] - Result->x[i];
-			tau    = Result->timeStep/deltaX;
+
+			/* Local time stepping: the timestep of the node */
+			if (Result->dt)
+				timeStep = Result->dt[i];
+
+			tau    = timeStep/deltaX;
 
 			/* Calculate artificial viscosity */
-			ret = CalcAV(&(*log), gamma, Data->epsilon, i, im, Result->A[i], Result->Q1, Result->Q2, Result->Q3, &AV);
+			ret = CalcAV(gamma, Data->epsilon, i, im, Result->A[i], Result->Q1, Result->Q2, Result->Q3, &AV);
 
 			/* Calculate Q-bar; defined for [0, im-2] */
 			Q1_b[i] = Result->Q1[i] - tau*(Result->E1[i+1]-Result->E1[i]) + tau*AV.D1;
@@ -105,17 +111,18 @@ int MacCormack(FILE *log, tData *Data, tResult *Result, double *residual)
 			Q3_b[i] = Result->Q3[i] - tau*(Result->E3[i+1]-Result->E3[i]) + tau*AV.D3;
 
 			/* Get primitives */
-			A   = Result->A[i];
-			rho = Q1_b[i]/A;
-			u   = Q2_b[i]/Q1_b[i];
-			e   = Q3_b[i]/A;
+			A    = Result->A[i];
+			invA = Result->invA[i];
+			rho  = Q1_b[i]*invA;
+			u    = Q2_b[i]/Q1_b[i];
+			e    = Q3_b[i]*invA;
 			p   = (e-0.5*rho*u*u)*(gamma-1);
 
 			/* Calculate E-bar and H-bar; only defined for [0, im-2] */
 			E1_b[i]   = rho*u*A;
 			E2_b[i]   = (rho*u*u+p)*A;
 			E3_b[i]   = u*(e+p)*A;
-			H2_b[i]   = p*Derivative(&(*log), i, &(*Result))/Result->A[i];
+			H2_b[i]   = p*Result->dA_dx[i]*invA;
 		}
 
 		/*
@@ -124,13 +131,19 @@ int MacCormack(FILE *log, tData *Data, tResult *Result, double *residual)
 		**   Necessary for i=1      : E_b[0]
 		*/
 		*residual = 0;
+		ClearNorms(Result->norms);
+		norms     = Result->monitor ? Result->norms : NULL;
 		for(i=1; i<im-1 && ret!=-1; i++)
 		{
 			deltaX = Result->x[i] - Result->x[i-1];
-			tau    = Result->timeStep/deltaX;
+
+			if (Result->dt)
+				timeStep = Result->dt[i];
+
+			tau    = timeStep/deltaX;
 
 			/* Calculate artificial viscosity */
-			ret = CalcAV(&(*log), gamma, Data->epsilon, i, im-1, Result->A[i], Q1_b, Q2_b, Q3_b, &AV);
+			ret = CalcAV(gamma, Data->epsilon, i, im-1, Result->A[i], Q1_b, Q2_b, Q3_b, &AV);
 
 			/* Calculate Q-double-bar
 			**    i=1   : E1_b[0]    needed
@@ -141,69 +154,26 @@ int MacCormack(FILE *log, tData *Data, tResult *Result, double *residual)
 			Q3_bb[i] = Result->Q3[i] - tau*(E3_b[i]-E3_b[i-1]) + tau*AV.D3;
 
 			/* Use density for residual calculation */
-			rhoBefore = Result->Q1[i]/Result->A[i];
+			rhoBefore = Result->Q1[i]*Result->invA[i];
+			Q2Before  = Result->Q2[i];
+			Q3Before  = Result->Q3[i];
 			
 			/* Calculate Q at the new timestep */
 			Result->Q1[i] = 0.5*(Q1_b[i] + Q1_bb[i]);
 			Result->Q2[i] = 0.5*(Q2_b[i] + Q2_bb[i]);
 			Result->Q3[i] = 0.5*(Q3_b[i] + Q3_bb[i]);
 
-			/* Calculate the residual */
-			rhoAfter    = Result->Q1[i]/Result->A[i];
-			*residual  += pow((rhoAfter-rhoBefore)/timeStep, 2);
+			/* Calculate the residual and the norms */
+			rhoAfter    = Result->Q1[i]*Result->invA[i];
+			*residual  += AddNorms(norms, (rhoAfter-rhoBefore)/timeStep,
+			                       Result->Q2[i]-Q2Before, Result->Q3[i]-Q3Before, Result->invA[i]/timeStep);
 		}
 	}
 
-	/* Deallocate memory */
-	if (Q1_b)
-		free(Q1_b);
-
-	if (Q2_b)
-		free(Q2_b);
-
-	if (Q3_b)
-		free(Q3_b);
-
-	if (Q1_bb)
-		free(Q1_bb);
-
-	if (Q2_bb)
-		free(Q2_bb);
-
-	if (Q3_bb)
-		free(Q3_bb);
-
-	if (E1_b)
-		free(E1_b);
-
-	if (E2_b)
-		free(E2_b);
-
-	if (E3_b)
-		free(E3_b);
-
-	if (H2_b)
-		free(H2_b);
-
-	/* Write report */
-	if (log)
-	{
-		fprintf(log, "\n***** FUNCTION MACCORMACK *****\n\n");
-
-		if (ret != -1)
-		{
-			fprintf(log, "  I         Q1         Q2         Q3\n");
-
-			for(i=1; i<Result->im-1; i++)
-				fprintf(log, "%3d %10.4f %10.4f %10.4f\n", i, Result->Q1[i], Result->Q2[i], Result->Q3[i]);
-		}
-		else
-		{
-			fprintf(log, "  Function MacCormack NOT succesfully ended.\n");
-		}
-
-		fprintf(log, "\n*********************************\n\n");
-	}
+	/* Trace the new field */
+	if (TRACE_ON(TRACE_SOLVER, TRACE_CELL))
+		for (i=0; i<im; i++)
+			TRACE(TRACE_SOLVER, TRACE_CELL, TRACE_EV_FIELD, i, Result->Q1[i], Result->Q2[i], Result->Q3[i], 0);
 
 	return ret;
 }
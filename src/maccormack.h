@@ -5,6 +5,9 @@
 #ifndef MACCORMACK_H
 #define MACCORMACK_H
 
-int MacCormack(FILE*, tData*, tResult*, double*);
+/* Number of scratch arrays used by MacCormack */
+#define MACCORMACK_SCRATCH 10
+
+int MacCormack(tData*, tResult*, double*);
 
 #endif
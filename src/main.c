@@ -6,33 +6,54 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #include "main.h"
-#include "boundary.h"
+#include "adjoint.h"
+#include "checkpoint.h"
 #include "data.h"
-#include "eh.h"
+#include "history.h"
 #include "initialise.h"
-#include "maccormack.h"
 #include "memory.h"
-#include "roe.h"
-#include "timestep.h"
+#include "monitor.h"
+#include "result.h"
+#include "sequence.h"
+#include "solve.h"
+#include "sweep.h"
+#include "timer.h"
+#include "trace.h"
+
+/* Seconds between two progress lines on the console */
+#define PROGRESS_INTERVAL 0.5
 
 int main(int argc, char *argv[])
 {
 	int    ret;
-	int    i;
+	int    i, start;
+	int    converged;
 	int    debug;
 	int    down;
+	int    quiet;
+	int    maxIter;
+	int    nThreads;
+	int    combined;
+	long   sweeps;
+	long   work;
 
 	double residual, normResidual, oldResidual;
+	double value, *dJdA, *dJdS;
 
-	time_t t1, t2;
+	double t1, t2, tProgress;
 
 	FILE   *logFile      = NULL;
-	FILE   *residualFile = NULL;
 	char   dataFileName[50];
+	char   *tableFileName = NULL;
+	char   *restartFileName = NULL;
+	char   *prefix        = "sweep";
+	char   *resultFileName = RESULT_FILE;
+
+	tHistory History;
 
 	tData   Data;
 	tResult Result;
@@ -41,6 +62,10 @@ int main(int argc, char *argv[])
 
 	ret        = 0;
 	debug      = 0;
+	quiet      = 0;
+	maxIter    = 0;
+	nThreads   = 0;
+	combined   = 0;
 	strcpy(dataFileName, "nozzle.in");
 
 	/* get  commandline arguments */
@@ -57,10 +82,52 @@ int main(int argc, char *argv[])
 			/* Use different datafile */
 			strcpy(dataFileName, argv[++i]);
 		}
+		else if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+		{
+			/* Run a fixed number of iterations */
+			maxIter = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+		{
+			/* Trace subsystems[:level] into nozzle.trace */
+			if (TraceOpen("nozzle.trace", argv[++i], TRACE_RECORDS) == -1)
+				ret = -1;
+		}
+		else if (strcmp(argv[i], "-r") == 0 && i+1 < argc)
+		{
+			/* Start from a checkpoint */
+			restartFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+		{
+			/* Sweep over the cases of a table */
+			tableFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-j") == 0 && i+1 < argc)
+		{
+			/* Number of threads of the sweep */
+			nThreads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+		{
+			/* Result file of a run, prefix of the sweep output */
+			resultFileName = prefix = argv[++i];
+		}
+		else if (strcmp(argv[i], "-c") == 0)
+		{
+			/* Combined sweep output */
+			combined = 1;
+		}
+		else if (strcmp(argv[i], "-q") == 0)
+		{
+			/* No progress output and no residual file */
+			quiet = 1;
+		}
 		else
 		{
 			printf("\nUnknown commandline option: '%s'\n", argv[i]);
-			printf("Use : nozzle [-l] [-p G|V|B] [-f FILENAME]\n");
+			printf("Use : nozzle [-l] [-q] [-t SUBSYSTEMS[:LEVEL]] [-n ITERATIONS] [-f FILENAME] [-r CHECKPOINT] [-o RESULT]\n");
+			printf("      nozzle [-l] [-t SUBSYSTEMS[:LEVEL]] [-n MAXITER] -s TABLE [-j THREADS] [-o PREFIX] [-c]\n");
 			ret = -1;
 		}
 	}
@@ -72,109 +139,163 @@ int main(int argc, char *argv[])
 		ret = -1;
 	}
 	
-	/* Open file for residual and check for success */
-	residualFile = fopen("residual.gnu", "w");
-	if (residualFile == NULL)
+	/* Sweep mode: all cases of the table, then done */
+	if (tableFileName)
 	{
-		fprintf(stderr, "ERROR in function Main: Could not open residualFile: residual.log.\n");
-		ret = -1;
+		quiet = 1;
+		if (ret != -1)
+			ret = Sweep(logFile, tableFileName, prefix, nThreads, maxIter, combined);
 	}
-	else
-		fprintf(residualFile, "#   I   Residual\n");
 
-	if (ret != -1)
+	History.file = NULL;
+
+	if (ret != -1 && tableFileName == NULL)
 	{
 		/* Read data from file */
 		if (ret != -1)
 			ret = ReadData(logFile, dataFileName,  &Data);
 
 		/* Allocate memory */
+		printf("Allocating memory...\n");
 		if (ret != -1)
 			ret = InitMem(logFile, &Data, &Result);
 
 		/* Set start time */
-		t1 = time(&t1);
+		t1 = WallTime();
 
 		/* Initialise */
+		printf("Initialising...\n");
 		if (ret != -1)
 			ret = Init(logFile, &Data, &Result);
 
 		i            = 0;
 		down         = 0;
+		tProgress    = t1;
 		oldResidual  = 0;
 		normResidual = 0;
+		work         = 0;
 		residual     = SMALL+1;
-		while ((residual > SMALL) && (ret != -1))
-		{
-			i++;
+		converged    = 0;
 
-			/* Calculate E and H vectors */
-			if (ret != -1)
-				ret = CalcEH(logFile, &Data, &Result);
+		/* Continue from a checkpoint, or start from the solution on coarser grids */
+		if (ret != -1 && restartFileName)
+			ret = ReadCheckpoint(logFile, restartFileName, &Data, &Result, &i, &normResidual);
+		else if (ret != -1 && Data.sequence > 0)
+			ret = Sequence(logFile, &Data, &Result, maxIter, &normResidual, &work);
 
-			/* Calculate timestep */
-			if (ret != -1)
-				ret = TimeStep(logFile, &Data, &Result);
+		start  = i;
+		sweeps = Result.sweeps;
 
-			/* Solve */
-			if (ret != -1)
-			{
-				oldResidual = residual;
-
-				if (Data.scheme == 'C')
-					ret = MacCormack(logFile, &Data, &Result, &residual);
-				else if (Data.scheme == 'R')
-					ret = Roe(logFile, &Data, &Result, &residual);
-				else if (Data.scheme == 'M')
-					ret = Roe(logFile, &Data, &Result, &residual);
-				else
-				{
-					fprintf(stderr, "ERROR in function Main: UNKNOWN scheme type...\n");
-					fprintf(logFile,"ERROR in function Main: UNKNOWN scheme type...\n");
-					ret = -1;
-				}
-			}
+		/* Open file for the residual history, numbered on from a checkpoint */
+		if (!quiet && ret != -1)
+			ret = OpenHistory(&History, "residual.bin", start+1);
 
-			/* Update boundaries */
-			if (ret != -1)
-				ret = Boundary(logFile, &Data, &Result);
+		while ((maxIter > 0 ? i-start < maxIter : !converged) && (ret != -1))
+		{
+			i++;
 
-			/* Normalise residual */
-			if (i==1)
+			/* Perform one iteration */
+			oldResidual = residual;
+			ret = Iterate(&Data, &Result, &residual);
+
+			/*
+			** Normalise residual; the solvers divide the change of
+			** every node by its own timestep, so it measures the
+			** time derivative with local time stepping as well
+			*/
+			if (normResidual == 0)
 				normResidual = residual;
 
 			residual /= normResidual;
+			if (ret != -1 && (converged = Converged(&Data, &Result, residual)) == -1)
+			{
+				converged = 0;
+				ret       = -1;
+			}
 
 			/* Write the residual */
-			if ((residual < oldResidual) && (i>1))
+			if ((residual < oldResidual) && (i>start+1))
 				down++;
 
-			fprintf(stderr,       "I = %d Residual = %10.7f [DECREASING = %d%%]\n", i, residual, (int)((float)(100*down)/i));
+			/* Periodic checkpoint */
+			if (Data.checkpoint > 0 && i % Data.checkpoint == 0 && ret != -1)
+				ret = WriteCheckpoint(CHECKPOINT_FILE, &Data, &Result, i, normResidual, residual);
 
-			/*
-			if ((residual > oldResidual) && (i>1))
+			if (!quiet)
 			{
-				fprintf(stderr,       "I = %d Residual = %10.7f INCREASING\n", i, residual);
+				if (AddHistory(&History, residual) == -1)
+					ret = -1;
+
+				/* Progress at most every PROGRESS_INTERVAL seconds */
+				t2 = WallTime();
+				if (t2 - tProgress >= PROGRESS_INTERVAL)
+				{
+					fprintf(stderr, "I = %d Residual = %10.7f [DECREASING = %d%%]\n", i, residual, (int)((float)(100*down)/(i-start)));
+					tProgress = t2;
+				}
 			}
-			else
+		}
+
+		/* Set end time */
+		t2 = WallTime();
+
+		if (!quiet && i > start)
+			fprintf(stderr, "I = %d Residual = %10.7f [DECREASING = %d%%]\n", i, residual, (int)((float)(100*down)/(i-start)));
+		printf("Iterations  : %d\n", i);
+		if (start > 0)
+			printf("Iterations after the restart : %d\n", i-start);
+
+		/* Final checkpoint, also for warm starts of other cases */
+		if (Data.checkpoint > 0 && ret != -1 && i > start && i % Data.checkpoint != 0)
+			ret = WriteCheckpoint(CHECKPOINT_FILE, &Data, &Result, i, normResidual, residual);
+		if (Result.multigrid)
+			printf("Fine-grid sweeps : %ld\n", Result.sweeps);
+		if (Result.accepted + Result.rejected > 0)
+			printf("Extrapolations : %ld accepted, %ld rejected, %ld sweeps in all\n",
+			       Result.accepted, Result.rejected, Result.sweeps-sweeps);
+		if (Result.monitor)
+			ReportMonitor(stdout, &Data, &Result);
+		if (work > 0)
+			printf("Coarse grid work : %.1f fine-grid sweeps\n", (double)work/Data.im);
+		if (Result.newton && i > start)
+			printf("Start-up steps : %ld, Newton steps : %ld, GMRES iterations : %ld (%.1f per Newton step), residual evaluations : %ld\n",
+			       Result.startup, i-start-Result.startup, Result.linear,
+			       (i-start > Result.startup) ? (double)Result.linear/(i-start-Result.startup) : 0.0, Result.sweeps-sweeps);
+
+		printf("Calculation time = %.3f sec.\n", t2-t1);
+		if (Result.sweeps > sweeps)
+			printf("Time per cell update = %.2f ns.\n", 1e9*(t2-t1)/((double)(Result.sweeps-sweeps)*Data.im + work));
+
+		/* Gradient of the output to the area, from the converged field */
+		if (Data.adjoint != ADJOINT_NONE && ret != -1)
+		{
+			dJdA = malloc(2*(size_t)Result.im*sizeof(double));
+			dJdS = dJdA ? dJdA + Result.im : NULL;
+
+			t1 = WallTime();
+			if (dJdA == NULL)
 			{
-				fprintf(stderr,       "I = %d Residual = %10.7f DECREASING\n", i, residual);
+				fprintf(stderr, "ERROR in function Main: could not allocate memory...\n");
+				ret = -1;
 			}
-			*/
+			else
+				ret = Adjoint(&Data, &Result, Data.adjoint, &value, dJdA, dJdS);
+			t2 = WallTime();
 
-			fprintf(residualFile, "%5d %10.7f\n", i, residual);
-		}
-		printf("Iterations  : %d\n", i);
+			if (ret != -1)
+				ret = WriteAdjoint(logFile, ADJOINT_FILE, &Result, Data.adjoint, value, dJdA, dJdS);
+			if (ret != -1)
+				printf("Adjoint : %s = %.6e, gradient in %s (%.3f sec.)\n", AdjointName(Data.adjoint), value, ADJOINT_FILE, t2-t1);
 
-		/* Set end time */
-		t2 = time(&t2);
-		printf("Calculation time = %d sec.\n", (int) (t2-t1));
+			free(dJdA);
+		}
 
-		/* Write the data to outputfile */
-		//if (ret != -1)
-			ret = WriteData(logFile, &Data, &Result);
+		/* Write the data to outputfile, also of a failed run for inspection */
+		if (WriteData(logFile, resultFileName, &Data, &Result, i, residual) == -1)
+			ret = -1;
 
 		/* Free allocated memory */
+		printf("Deallocating memory...\n");
 		if (ret != -1)
 			ret = FreeMem(&Result);
 
@@ -191,8 +312,12 @@ int main(int argc, char *argv[])
 		printf("Log can be found in nozzle.log\n");
 	}
 
-	if (residualFile)
-		fclose(residualFile);
+	if (History.file && CloseHistory(&History) == -1)
+		ret = -1;
+
+	/* Write the trace, if any */
+	if (TraceClose() == -1)
+		ret = -1;
 
 
 	printf("Done.\n\n");
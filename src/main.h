@@ -5,9 +5,70 @@
 #ifndef MAIN_H
 #define MAIN_H
 
-#define SMALL    1e-7
+#define SMALL      1e-7
+#define ALIGNMENT  64
+#define MAXSCRATCH 16
+#define NORMS      9
 #define AREA(x)  (1.398 + 0.347*tanh(0.8*x - 4))
 
+/* Kernel variants */
+#define KERNEL_SCALAR 0
+#define KERNEL_FUSED  1
+#define KERNEL_SIMD   2
+
+/* Instruction sets for the SIMD kernel */
+#define ISA_AUTO      0
+#define ISA_SCALAR    1
+#define ISA_AVX2      2
+#define ISA_AVX512    3
+
+/* Multigrid cycles; the value is the number of coarse grid visits */
+#define MGCYCLE_V 1
+#define MGCYCLE_W 2
+
+/* Time stepping: one timestep for all nodes, or one per node */
+#define TIMESTEP_GLOBAL 0
+#define TIMESTEP_LOCAL  1
+
+/* Steady solvers: marching with the scheme, or Newton-Krylov */
+#define SOLVER_MARCH  0
+#define SOLVER_NEWTON 1
+
+/* Vector extrapolation of the iterates */
+#define EXTRAPOLATION_RRE 0
+#define EXTRAPOLATION_MPE 1
+
+/* Stopping rules: the residual, the outputs, either or both */
+#define STOP_RESIDUAL 0
+#define STOP_OUTPUTS  1
+#define STOP_ANY      2
+#define STOP_ALL      3
+
+/* Outputs of the adjoint gradient */
+#define ADJOINT_NONE   0
+#define ADJOINT_THRUST 1
+#define ADJOINT_MACH   2
+
+/* Time integrators of Roe's scheme */
+#define INTEGRATOR_EULER  0
+#define INTEGRATOR_SSPRK2 1
+#define INTEGRATOR_SSPRK3 2
+#define INTEGRATOR_LSRK4  3
+#define INTEGRATOR_LSRK5  4
+
+/* Interface fluxes of schemes R and M */
+#define FLUX_ROE     0
+#define FLUX_HLL     1
+#define FLUX_HLLC    2
+#define FLUX_AUSM    3
+#define FLUX_RUSANOV 4
+#define NFLUX        5
+
+/* Limiters of the MUSCL-scheme */
+#define LIMITER_VANLEER   0
+#define LIMITER_VANALBADA 1
+#define LIMITER_KAPPA     2
+
 typedef struct
 {
 	double length;
@@ -18,6 +79,38 @@ typedef struct
 	double epsilon;
 	double kappa;
 
+	int    limiter;
+	int    flux;
+	int    kernel;
+	int    isa;
+	int    threads;
+	int    timeStepping;
+	int    cflRamp;
+	int    solver;
+	double newtonCFL;
+	double irs;
+	int    integrator;
+	int    checkpoint;
+	int    sequence;
+	double sequenceTol;
+	int    adapt;
+	double adaptStrength;
+	int    extrapolate;
+	int    extrapolation;
+	int    extrapolateEvery;
+	int    stopRule;
+	int    stopNorm;
+	int    stopEquations;
+	double stopTol;
+	double stopOutputs;
+	int    stopWindow;
+	int    adjoint;
+
+	int    mgLevels;
+	int    mgCycle;
+	int    mgPre;
+	int    mgPost;
+
 	double gamma;
 	double R;
 
@@ -36,18 +129,51 @@ typedef struct
 	double rho_0;
 } tData;
 
-typedef struct
+typedef struct sResult tResult;
+
+/* Solver of one iteration, specialised for scheme and limiter */
+typedef int (*tSolver)(tData*, tResult*, double*);
+
+struct sResult
 {
 	int      im;
 
 	double   timeStep;
+	double   *dt;        /* timestep per node (local time stepping), else NULL */
+	long     sweeps;
+	long     linear;     /* GMRES iterations of the Newton-Krylov solver */
+	long     startup;    /* start-up steps of the Newton-Krylov solver */
+	long     accepted;   /* extrapolations accepted */
+	long     rejected;   /* extrapolations rejected */
+	double   *irs[4];    /* old field and pivots (residual smoothing), else NULL */
+	double   *adapt[6];  /* new grid, monitor and field (mesh adaptation), NULL once frozen */
+	double   norms[NORMS]; /* L1, L2 (sum of squares) and Linf of the equations in the last step (with a monitor) */
 
 	double   *Q1, *Q2, *Q3;
 	double   *E1, *E2, *E3;
 	double   *H2;
 
 	double   *x;
+	double   *dx;        /* width of the cell of every node */
 	double   *A;
-} tResult;
+	double   *dA_dx;
+	double   *invA;
+
+	double   *scratch[MAXSCRATCH];
+	int      nScratch;
+
+	int      isa;
+	int      recon;
+	tSolver  solver;
+
+	void     *blocks;
+	void     *multigrid;
+	void     *newton;
+	void     *extrapolation;
+	void     *monitor;
+
+	void     *arena;
+	size_t   arenaSize;
+};
 
 #endif
@@ -2,6 +2,13 @@
 ** Function InitMem
 ** Initialises all arrays in structure Result
 **
+**   All fields and the scratch arrays of the selected scheme
+**   are carved out of a single workspace (arena) that is
+**   allocated once per solve. Every array starts on an
+**   ALIGNMENT byte boundary, so the solvers can use aligned
+**   vector loads. The arena is touched once here, so page
+**   faults do not occur during the iterations.
+**
 ** In:       tData Data = structure containing all data
 ** Out:      -
 ** Return:   0 on success, -1 on failure
@@ -9,52 +16,201 @@
 ** Author:   J.L. Klaufus
 */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "main.h"
+#include "block.h"
+#include "extrapolate.h"
+#include "fused.h"
+#include "implicit.h"
+#include "integrator.h"
+#include "maccormack.h"
 #include "memory.h"
+#include "monitor.h"
+#include "multigrid.h"
+#include "newton.h"
+#include "roebatch.h"
+#include "solve.h"
+
+/* Number of field arrays: x, dx, A, dA_dx, invA, Q1..Q3 and E1..E3, H2 */
+#define NFIELDS 8
+#define NEH     4
 
 int InitMem(FILE *log, tData *Data, tResult *Result)
 {
-	int ret;
-
-	printf("Allocating memory...\n");
+	int    ret;
+	int    i;
+	int    nArrays, nEH, nDt, nIrs, nAdapt;
+	size_t stride;
+	double *next;
 
 	ret = 0;
 
-	Result->im = Data->im;
+	Result->im        = Data->im;
+	Result->arena     = NULL;
+	Result->blocks    = NULL;
+	Result->multigrid = NULL;
+	Result->newton    = NULL;
+	Result->extrapolation = NULL;
+	Result->monitor   = NULL;
+	Result->sweeps    = 0;
+	Result->linear    = 0;
+	Result->startup   = 0;
+	Result->accepted  = 0;
+	Result->rejected  = 0;
+	Result->nScratch  = 0;
+
+	for (i=0; i<NORMS; i++)
+		Result->norms[i] = 0;
+
+	for (i=0; i<MAXSCRATCH; i++)
+		Result->scratch[i] = NULL;
+
+	for (i=0; i<4; i++)
+		Result->irs[i] = NULL;
+
+	for (i=0; i<6; i++)
+		Result->adapt[i] = NULL;
+
+	/* Scratch arrays needed by the selected scheme; the blocks use the unfused layout */
+	if (Data->scheme == 'I')
+		Result->nScratch = IMPLICIT_SCRATCH;
+	else if (Data->scheme == 'C')
+		Result->nScratch = (Data->kernel == KERNEL_FUSED && Data->threads <= 0) ? FUSED_MACCORMACK_SCRATCH : MACCORMACK_SCRATCH;
+	else if (Data->integrator != INTEGRATOR_EULER)
+		Result->nScratch = INTEGRATOR_SCRATCH;
+	else if (Data->kernel == KERNEL_SIMD || Data->threads > 0)
+		Result->nScratch = ROEBATCH_SCRATCH;
+
+	/* Instruction set of the SIMD kernel and the specialised solver */
+	Result->isa = ResolveISA(Data->isa);
+	ret = SelectSolver(log, Data, Result);
 
-	Result->x   = (double*)malloc(Result->im*sizeof(double));
-	Result->A   = (double*)malloc(Result->im*sizeof(double));
+	/* The fused kernels do not store E and H */
+	nEH = (Data->kernel == KERNEL_FUSED && Data->threads <= 0) ? 0 : NEH;
 
-	Result->Q1  = (double*)malloc(Result->im*sizeof(double));
-	Result->Q2  = (double*)malloc(Result->im*sizeof(double));
-	Result->Q3  = (double*)malloc(Result->im*sizeof(double));
+	/* Local time stepping stores the timestep of every node */
+	nDt = (Data->timeStepping == TIMESTEP_LOCAL) ? 1 : 0;
 
-	Result->E1  = (double*)malloc(Result->im*sizeof(double));
-	Result->E2  = (double*)malloc(Result->im*sizeof(double));
-	Result->E3  = (double*)malloc(Result->im*sizeof(double));
+	/* Residual smoothing stores the old field and the pivots */
+	nIrs = (Data->irs > 0) ? 4 : 0;
 
-	Result->H2  = (double*)malloc(Result->im*sizeof(double));
+	/* Mesh adaptation stores the new grid, the monitor and the new field */
+	nAdapt = (Data->adapt > 0) ? 6 : 0;
 
-	if((Result->x == NULL)  || (Result->A == NULL)  ||
-	   (Result->Q1 == NULL) || (Result->Q2 == NULL) || (Result->Q3 == NULL) ||
-	   (Result->E1 == NULL) || (Result->E2 == NULL) || (Result->E3 == NULL) ||
-	   (Result->H2 == NULL))
+	/* Doubles per array, rounded up to the alignment */
+	stride  = ((size_t)Result->im*sizeof(double) + ALIGNMENT-1)/ALIGNMENT*ALIGNMENT/sizeof(double);
+	nArrays = NFIELDS + nEH + nDt + nIrs + nAdapt + Result->nScratch;
+
+	Result->arenaSize = nArrays*stride*sizeof(double);
+	if (posix_memalign(&Result->arena, ALIGNMENT, Result->arenaSize) != 0)
+		Result->arena = NULL;
+
+	if (Result->arena == NULL)
 	{
+		fprintf(stderr, "ERROR in function InitMem: could not allocate memory...\n");
 		if (log)
 			fprintf(log, "ERROR in function InitMem: could not allocate memory...\n");
 
+		Result->x  = Result->dx = Result->A = Result->dA_dx = Result->invA = NULL;
+		Result->Q1 = Result->Q2 = Result->Q3 = NULL;
+		Result->E1 = Result->E2 = Result->E3 = NULL;
+		Result->H2 = NULL;
+		Result->dt = NULL;
+		Result->nScratch = 0;
+
 		ret = -1;
 	}
+	else
+	{
+		/* Touch all pages now instead of in the first iteration */
+		memset(Result->arena, 0, Result->arenaSize);
+
+		next = (double*)Result->arena;
+
+		Result->x     = next; next += stride;
+		Result->dx    = next; next += stride;
+		Result->A     = next; next += stride;
+		Result->dA_dx = next; next += stride;
+		Result->invA  = next; next += stride;
+
+		Result->Q1    = next; next += stride;
+		Result->Q2    = next; next += stride;
+		Result->Q3    = next; next += stride;
+
+		if (nEH)
+		{
+			Result->E1 = next; next += stride;
+			Result->E2 = next; next += stride;
+			Result->E3 = next; next += stride;
+
+			Result->H2 = next; next += stride;
+		}
+		else
+		{
+			Result->E1 = Result->E2 = Result->E3 = NULL;
+			Result->H2 = NULL;
+		}
+
+		if (nDt)
+		{
+			Result->dt = next; next += stride;
+		}
+		else
+			Result->dt = NULL;
+
+		for (i=0; i<nIrs; i++)
+		{
+			Result->irs[i] = next;
+			next += stride;
+		}
+
+		for (i=0; i<nAdapt; i++)
+		{
+			Result->adapt[i] = next;
+			next += stride;
+		}
+
+		for (i=0; i<Result->nScratch; i++)
+		{
+			Result->scratch[i] = next;
+			next += stride;
+		}
+
+		/* Threads of the domain decomposition, if any */
+		if (ret != -1)
+			ret = StartBlocks(log, Data, Result);
+
+		/* Coarse levels of the multigrid cycle, if any */
+		if (ret != -1)
+			ret = StartMultigrid(log, Data, Result);
+
+		/* Workspace of the Newton-Krylov solver, if any */
+		if (ret != -1)
+			ret = StartNewton(log, Data, Result);
+
+		/* Window of iterates of the extrapolation, if any */
+		if (ret != -1)
+			ret = StartExtrapolation(log, Data, Result);
+
+		/* Monitor of the stopping rules, if any */
+		if (ret != -1)
+			ret = StartMonitor(log, Data, Result);
+	}
 
 	if (log)
 	{
 		fprintf(log, "\n***** FUNCTION INITMEM *****\n\n");
 
 		if (ret == 0)
+		{
+			fprintf(log, "Arena of %lu bytes, %d arrays.\n", (unsigned long)Result->arenaSize, nArrays);
 			fprintf(log, "Function InitMem succesfully ended.\n");
+		}
 		else
 			fprintf(log, "Function InitMem NOT succesfully ended.\n");
 
@@ -81,36 +237,44 @@ int InitMem(FILE *log, tData *Data, tResult *Result)
 int FreeMem(tResult *Result)
 {
 	int ret = 0;
+	int i;
 
-	printf("Deallocating memory...\n");
+	if (StopMonitor(Result) == -1)
+		ret = -1;
 
-	if (Result->x)
-		free(Result->x);
+	if (StopExtrapolation(Result) == -1)
+		ret = -1;
 
-	if (Result->A)
-		free(Result->A);
+	if (StopNewton(Result) == -1)
+		ret = -1;
 
-	if (Result->Q1)
-		free(Result->Q1);
+	if (StopMultigrid(Result) == -1)
+		ret = -1;
 
-	if (Result->Q2)
-		free(Result->Q2);
+	if (StopBlocks(Result) == -1)
+		ret = -1;
+
+	if (Result->arena)
+		free(Result->arena);
 
-	if (Result->Q3)
-		free(Result->Q3);
+	Result->arena = NULL;
 
-	if (Result->E1)
-		free(Result->E1);
+	Result->x  = Result->dx = Result->A = Result->dA_dx = Result->invA = NULL;
+	Result->Q1 = Result->Q2 = Result->Q3 = NULL;
+	Result->E1 = Result->E2 = Result->E3 = NULL;
+	Result->H2 = NULL;
+	Result->dt = NULL;
 
-	if (Result->E2)
-		free(Result->E2);
+	for (i=0; i<4; i++)
+		Result->irs[i] = NULL;
 
-	if (Result->E3)
-		free(Result->E3);
+	for (i=0; i<6; i++)
+		Result->adapt[i] = NULL;
 
-	if (Result->H2)
-		free(Result->H2);
+	for (i=0; i<MAXSCRATCH; i++)
+		Result->scratch[i] = NULL;
+
+	Result->nScratch = 0;
 
 	return ret;
 }
-
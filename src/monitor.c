@@ -0,0 +1,319 @@
+/*
+** Monitor
+**    Stopping rules on the norms of the equations and on the
+**    integrated outputs of the flow field. The schemes gather
+**    the L1 norm, the sum of squares (L2) and the largest value
+**    (Linf) of the time derivatives of rho, rho*u and rho*E in
+**    their update loop (AddNorms). The residual of a rule is the
+**    largest of the selected norms of the selected equations,
+**    each normalised with its value in the first iteration of
+**    the run; density and L2 is the residual of the schemes.
+**
+**    The outputs are the deviation of the mass flow along the
+**    nozzle, (max - min)/mean of rho*u*A, the thrust at the exit,
+**    (rho*u*u + p)*A, and the location of the shock, the largest
+**    pressure rise between two nodes, located within the cell by
+**    a parabola through its neighbours. They are evaluated every
+**    iteration; they have settled when their range over a window
+**    of stop_window iterations is below stop_outputs, relative to
+**    the thrust and to the length of the nozzle (the deviation
+**    is relative already).
+**
+**    Without a monitor (rule residual on the density in L2) the
+**    run stops as it always did, on the residual of the schemes.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "main.h"
+#include "monitor.h"
+#include "norms.h"
+
+typedef struct
+{
+	double norm0[NORMS];      /* norms of the first iteration */
+	double residual;          /* normalised residual of the rule */
+	double outputs[OUTPUTS];  /* of the last iteration */
+	double lo[OUTPUTS];       /* range in the current window */
+	double hi[OUTPUTS];
+	int    count;             /* iterations in the current window */
+	int    settled;           /* the outputs of the last full window settled */
+} tMonitor;
+
+static const char *ruleNames[] = { "residual", "outputs", "any", "all" };
+static const char *normNames[] = { "l1", "l2", "linf" };
+
+/*
+** Function Pressure
+**    Static pressure in node i.
+*/
+
+static inline double Pressure(double gamma, tResult *Result, int i)
+{
+	return (gamma-1)*(Result->Q3[i] - 0.5*Result->Q2[i]*Result->Q2[i]/Result->Q1[i])*Result->invA[i];
+}
+
+/*
+** Function StartMonitor
+**    Sets up the monitor of the stopping rules, unless the run
+**    stops on the residual of the schemes alone.
+**
+** In:       FILE    log    = pointer to log file
+**           tData   Data   = structure containing all data
+** Out:      tResult Result = monitor is set
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StartMonitor(FILE *log, tData *Data, tResult *Result)
+{
+	tMonitor *M;
+
+	Result->monitor = NULL;
+
+	if (Data->stopRule == STOP_RESIDUAL && Data->stopEquations == 1 && Data->stopNorm == NORM_L2)
+		return 0;
+
+	M = calloc(1, sizeof(tMonitor));
+	if (M == NULL)
+	{
+		fprintf(stderr, "ERROR in function StartMonitor: could not allocate memory...\n");
+		return -1;
+	}
+
+	Result->monitor = M;
+
+	if (log)
+		fprintf(log, "\n   Monitor: rule %s, norm %s of %s, outputs over %d iterations\n\n",
+		        ruleNames[Data->stopRule], normNames[Data->stopNorm],
+		        Data->stopEquations == 1 ? "the density" : "all equations", Data->stopWindow);
+
+	return 0;
+}
+
+/*
+** Function StopMonitor
+**    Frees the monitor of the stopping rules.
+**
+** In:       tResult Result = structure containing results
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StopMonitor(tResult *Result)
+{
+	free(Result->monitor);
+	Result->monitor = NULL;
+
+	return 0;
+}
+
+/*
+** Function Outputs
+**   Evaluates the integrated outputs of the current field in
+**   one pass over the nodes.
+**
+** In:       tData   Data    = structure containing all data
+**           tResult Result  = structure containing results
+** Out:      double  outputs = mass-flow deviation, thrust and
+**                             location of the shock
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void Outputs(tData *Data, tResult *Result, double *outputs)
+{
+	int    i, j, im;
+	double gamma, lo, hi, sum, p, pNext, rise, top, left, right, curve, shift;
+
+	im    = Result->im;
+	gamma = Data->gamma;
+
+	lo  = Result->Q2[0];
+	hi  = Result->Q2[0];
+	sum = 0;
+
+	j   = -1;
+	top = 0;
+	p   = Pressure(gamma, Result, 0);
+
+	for (i=0; i<im; i++)
+	{
+		sum += Result->Q2[i];
+		lo   = Result->Q2[i] < lo ? Result->Q2[i] : lo;
+		hi   = Result->Q2[i] > hi ? Result->Q2[i] : hi;
+
+		if (i < im-1)
+		{
+			pNext = Pressure(gamma, Result, i+1);
+			rise  = pNext - p;
+
+			if (rise > top)
+			{
+				top = rise;
+				j   = i;
+			}
+
+			p = pNext;
+		}
+	}
+
+	outputs[OUTPUT_MASSFLOW] = (sum != 0) ? (hi - lo)*im/fabs(sum) : 0;
+
+	i = im-1;
+	outputs[OUTPUT_THRUST] = Result->Q2[i]*Result->Q2[i]/Result->Q1[i] + Pressure(gamma, Result, i)*Result->A[i];
+
+	/* No compression: no shock in the nozzle */
+	if (j < 0)
+		outputs[OUTPUT_SHOCK] = Result->x[im-1];
+	else
+	{
+		outputs[OUTPUT_SHOCK] = 0.5*(Result->x[j] + Result->x[j+1]);
+
+		/* Vertex of the parabola through the rises of the intervals j-1, j and j+1 */
+		if (j > 0 && j < im-2)
+		{
+			left  = Pressure(gamma, Result, j)   - Pressure(gamma, Result, j-1);
+			right = Pressure(gamma, Result, j+2) - Pressure(gamma, Result, j+1);
+			curve = left - 2*top + right;
+
+			if (curve < 0)
+			{
+				shift = 0.5*(left - right)/curve;
+				outputs[OUTPUT_SHOCK] += shift*0.5*(Result->x[j+2] - Result->x[j]);
+			}
+		}
+	}
+}
+
+/*
+** Function Converged
+**   Applies the stopping rule of the data-file after an
+**   iteration.
+**
+** In:       tData   Data     = structure containing all data
+**           tResult Result   = structure containing results
+**           double  residual = normalised residual of the schemes
+** Out:      -
+** Return:   1 when the run may stop, 0 otherwise, -1 when the
+**           residual is not finite
+**
+** Author:   J.L. Klaufus
+*/
+
+int Converged(tData *Data, tResult *Result, double residual)
+{
+	int      c, e, k, done, settled;
+	double   r, scale[OUTPUTS];
+	tMonitor *M = Result->monitor;
+
+	/* A NaN would pass every test below as converged */
+	if (!isfinite(residual))
+	{
+		fprintf(stderr, "ERROR in function Converged: The residual is not finite; the solve diverged.\n");
+		return -1;
+	}
+
+	if (M == NULL)
+		return !(residual > Data->stopTol);
+
+	/* Residual of the rule */
+	if (Data->stopEquations == 1 && Data->stopNorm == NORM_L2)
+		M->residual = residual;
+	else
+	{
+		M->residual = 0;
+		for (e=0; e<Data->stopEquations; e++)
+		{
+			k = 3*e + Data->stopNorm;
+
+			if (M->norm0[k] == 0)
+				M->norm0[k] = Result->norms[k];
+
+			r = (M->norm0[k] > 0) ? Result->norms[k]/M->norm0[k] : 0;
+			if (!(r <= M->residual))
+				M->residual = r;
+		}
+	}
+
+	done = !(M->residual > Data->stopTol);
+
+	if (Data->stopRule == STOP_RESIDUAL)
+		return done;
+
+	/* Range of the outputs in the window */
+	Outputs(Data, Result, M->outputs);
+
+	for (c=0; c<OUTPUTS; c++)
+	{
+		if (M->count == 0 || M->outputs[c] < M->lo[c])
+			M->lo[c] = M->outputs[c];
+		if (M->count == 0 || M->outputs[c] > M->hi[c])
+			M->hi[c] = M->outputs[c];
+	}
+
+	if (++M->count >= Data->stopWindow)
+	{
+		scale[OUTPUT_MASSFLOW] = 1;
+		scale[OUTPUT_THRUST]   = fabs(M->outputs[OUTPUT_THRUST]);
+		scale[OUTPUT_SHOCK]    = Result->x[Result->im-1] - Result->x[0];
+
+		settled = 1;
+		for (c=0; c<OUTPUTS; c++)
+			if (!(M->hi[c] - M->lo[c] <= Data->stopOutputs*scale[c]))
+				settled = 0;
+
+		M->settled = settled;
+		M->count   = 0;
+	}
+
+	switch (Data->stopRule)
+	{
+		case STOP_OUTPUTS:
+			return M->settled;
+		case STOP_ANY:
+			return M->settled || done;
+		default:
+			return M->settled && done;
+	}
+}
+
+/*
+** Function ReportMonitor
+**   Prints the outputs and the norms of the last iteration.
+**
+** In:       FILE    stream = stream to print on
+**           tData   Data   = structure containing all data
+**           tResult Result = structure containing results
+** Out:      -
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void ReportMonitor(FILE *stream, tData *Data, tResult *Result)
+{
+	int      e;
+	double   outputs[OUTPUTS];
+	tMonitor *M = Result->monitor;
+
+	Outputs(Data, Result, outputs);
+
+	fprintf(stream, "Mass-flow deviation : %.3e, thrust : %.6e, shock at x = %.4f\n",
+	        outputs[OUTPUT_MASSFLOW], outputs[OUTPUT_THRUST], outputs[OUTPUT_SHOCK]);
+
+	for (e=0; e<3; e++)
+		fprintf(stream, "Norms of equation %d : L1 %.3e, L2 %.3e, Linf %.3e\n", e+1,
+		        Result->norms[3*e+NORM_L1], sqrt(Result->norms[3*e+NORM_L2]), Result->norms[3*e+NORM_LINF]);
+
+	if (M)
+		fprintf(stream, "Residual of the rule : %.3e\n", M->residual);
+}
@@ -0,0 +1,20 @@
+/*
+** Header-file for Monitor
+*/
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+/* Integrated outputs of the flow field */
+#define OUTPUT_MASSFLOW 0
+#define OUTPUT_THRUST   1
+#define OUTPUT_SHOCK    2
+#define OUTPUTS         3
+
+int  StartMonitor(FILE*, tData*, tResult*);
+int  StopMonitor(tResult*);
+void Outputs(tData*, tResult*, double*);
+int  Converged(tData*, tResult*, double);
+void ReportMonitor(FILE*, tData*, tResult*);
+
+#endif
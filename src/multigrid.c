@@ -0,0 +1,589 @@
+/*
+** Multigrid
+**    Full Approximation Scheme (FAS) around the solvers of the
+**    explicit schemes, which act as smoothers. Level 0 is the
+**    grid of the data-file; every coarser level keeps every
+**    other node of the level above it, and always the exit
+**    node, so that im is halved.
+**
+**    The residual of a level is the change of one smoothing
+**    step divided by its timestep, R(Q) = (S(Q)-Q)/dt. It
+**    vanishes exactly where the smoother has converged, for
+**    every scheme. A coarse level solves
+**
+**      R_c(Q_c) + P = 0,    P = I R_f(Q_f) - R_c(I Q_f)
+**
+**    by adding dt*P after every smoothing step. R_f(Q_f) is
+**    evaluated with an extra step whose update is discarded: a
+**    correction computed for another state than the one it is
+**    added to overshoots, the more so the more levels there
+**    are. The state is restricted by injection and the
+**    residual by full weighting. The correction Q_c - I Q_f of the inner
+**    nodes is interpolated linearly to the inner nodes of the
+**    fine level; the boundary nodes get no correction, and
+**    neither do nodes where it would make rho or p negative.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "main.h"
+#include "boundary.h"
+#include "initialise.h"
+#include "memory.h"
+#include "multigrid.h"
+#include "solve.h"
+#include "timestep.h"
+
+typedef struct
+{
+	tData   *Data;
+	tResult *Result;
+
+	/* Own data and workspace of the coarse levels */
+	tData   LevelData;
+	tResult LevelResult;
+
+	double  *Q0[3];   /* state at the start of the last smoothing step */
+	double  *R[3];    /* residual of the last smoothing step */
+	double  *Qr[3];   /* restricted state (coarse levels) */
+	double  *P[3];    /* forcing (coarse levels) */
+	double  *dt;      /* timestep per node of the last smoothing step */
+	double  *memory;
+} tLevel;
+
+typedef struct
+{
+	int    nLevels;
+	int    geometry;
+	tLevel *levels;
+	double norms[NORMS];   /* norms of the step that gave the residual of the cycle */
+	double first;          /* residual of the first cycle */
+	double best;           /* lowest residual of a cycle so far */
+	int    stalled;        /* cycles since the residual dropped below MULTIGRID_DROP*best */
+} tMultigrid;
+
+/*
+** Function Fields
+**    The conservative variables of a level as an array.
+*/
+
+static void Fields(tResult *Result, double **Q)
+{
+	Q[0] = Result->Q1;
+	Q[1] = Result->Q2;
+	Q[2] = Result->Q3;
+}
+
+/*
+** Function FineNode
+**    Node of the fine level at node I of the coarse level.
+*/
+
+static int FineNode(int I, int imFine)
+{
+	return (2*I < imFine-1) ? 2*I : imFine-1;
+}
+
+/*
+** Function Geometry
+**    Injects x, A, 1/A and dA/dx into the coarse levels; done
+**    at the first cycle, after Init has built level 0.
+*/
+
+static void Geometry(tMultigrid *MG)
+{
+	int     k, I, f;
+	tResult *Fine, *Coarse;
+
+	for (k=1; k<MG->nLevels; k++)
+	{
+		Fine   = MG->levels[k-1].Result;
+		Coarse = MG->levels[k].Result;
+
+		for (I=0; I<Coarse->im; I++)
+		{
+			f = FineNode(I, Fine->im);
+
+			Coarse->x[I]     = Fine->x[f];
+			Coarse->A[I]     = Fine->A[f];
+			Coarse->invA[I]  = Fine->invA[f];
+			Coarse->dA_dx[I] = Fine->dA_dx[f];
+		}
+
+		CellWidths(Coarse, 1);
+
+		Coarse->timeStep = 0;
+	}
+
+	MG->geometry = 1;
+}
+
+/*
+** Function StepTimeSteps
+**    Stores the timestep of every node of the step about to be
+**    taken, or just taken; the global one, or Result->dt with
+**    local time stepping.
+*/
+
+static void StepTimeSteps(tLevel *Level)
+{
+	int     i;
+	tResult *Result = Level->Result;
+
+	if (Result->dt)
+		memcpy(Level->dt, Result->dt, Result->im*sizeof(double));
+	else
+		for (i=0; i<Result->im; i++)
+			Level->dt[i] = Result->timeStep;
+}
+
+/*
+** Function Smooth
+**    One smoothing step on level k; stores its residual. On a
+**    coarse level the forcing is added; the first step after a
+**    restriction turns the restricted residual into the forcing.
+*/
+
+static int Smooth(tMultigrid *MG, int k, int first, double *residual)
+{
+	int     ret;
+	int     i, c, im;
+	double  *dt;
+	double  *Q[3];
+	tLevel  *Level  = &MG->levels[k];
+	tData   *Data   = Level->Data;
+	tResult *Result = Level->Result;
+
+	ret = 0;
+	im  = Result->im;
+	dt  = Level->dt;
+	Fields(Result, Q);
+
+	for (c=0; c<3; c++)
+		memcpy(Level->Q0[c], Q[c], im*sizeof(double));
+
+	/* The fused kernels keep the timestep of the next step; it must belong to this field */
+	if (Data->kernel == KERNEL_FUSED && Result->blocks == NULL)
+	{
+		ret = TimeStep(Data, Result);
+		StepTimeSteps(Level);
+
+		if (ret != -1)
+			ret = Step(Data, Result, residual);
+	}
+	else
+	{
+		ret = Step(Data, Result, residual);
+		StepTimeSteps(Level);
+	}
+
+	if (ret != -1)
+	{
+		for (c=0; c<3; c++)
+		{
+			Level->R[c][0]    = 0;
+			Level->R[c][im-1] = 0;
+
+			for (i=1; i<im-1; i++)
+				Level->R[c][i] = (Q[c][i] - Level->Q0[c][i])/dt[i];
+		}
+
+		if (k > 0)
+		{
+			for (c=0; c<3; c++)
+				for (i=1; i<im-1; i++)
+				{
+					/* P held I R_f; now R_c(I Q_f) is known */
+					if (first)
+						Level->P[c][i] -= Level->R[c][i];
+
+					Q[c][i]        += dt[i]*Level->P[c][i];
+					Level->R[c][i] += Level->P[c][i];
+				}
+
+			ret = Boundary(Data, Result);
+		}
+	}
+
+	return ret;
+}
+
+/*
+** Function Residual
+**    Evaluates the residual of the current field of level k
+**    with a smoothing step whose update is discarded, so that
+**    the restricted state and residual belong together.
+*/
+
+static int Residual(tMultigrid *MG, int k, double *residual)
+{
+	int     ret;
+	int     c;
+	double  *Q[3];
+	tLevel  *Level = &MG->levels[k];
+
+	ret = Smooth(MG, k, 0, residual);
+
+	Fields(Level->Result, Q);
+	for (c=0; c<3; c++)
+		memcpy(Q[c], Level->Q0[c], Level->Result->im*sizeof(double));
+
+	return ret;
+}
+
+/*
+** Function Restrict
+**    Restricts the state and the residual of level k-1 to
+**    level k.
+*/
+
+static void Restrict(tMultigrid *MG, int k)
+{
+	int    I, c, f;
+	int    imFine, imCoarse;
+	double *Q[3];
+	tLevel *Fine   = &MG->levels[k-1];
+	tLevel *Coarse = &MG->levels[k];
+
+	imFine   = Fine->Result->im;
+	imCoarse = Coarse->Result->im;
+	Fields(Coarse->Result, Q);
+
+	for (I=0; I<imCoarse; I++)
+	{
+		f = FineNode(I, imFine);
+
+		for (c=0; c<3; c++)
+		{
+			Q[c][I] = Coarse->Qr[c][I] = Fine->Q0[c][f];
+
+			if (I == 0 || I == imCoarse-1)
+				Coarse->P[c][I] = 0;
+			else if (f+1 < imFine-1)
+				Coarse->P[c][I] = 0.25*Fine->R[c][f-1] + 0.5*Fine->R[c][f] + 0.25*Fine->R[c][f+1];
+			else
+				Coarse->P[c][I] = Fine->R[c][f];
+		}
+	}
+}
+
+/*
+** Function Prolong
+**    Adds the correction of level k to the inner nodes of level
+**    k-1 and updates the exit boundary of level k-1.
+*/
+
+static int Prolong(tMultigrid *MG, int k)
+{
+	int    I, i, c;
+	int    f0, f1;
+	int    imFine, imCoarse;
+	double w, e0, e1;
+	double Q[3];
+	double *x;
+	double *Qf[3], *Qc[3];
+	tLevel *Fine   = &MG->levels[k-1];
+	tLevel *Coarse = &MG->levels[k];
+
+	imFine   = Fine->Result->im;
+	imCoarse = Coarse->Result->im;
+	x        = Fine->Result->x;
+	Fields(Fine->Result, Qf);
+	Fields(Coarse->Result, Qc);
+
+	for (I=0; I<imCoarse-1; I++)
+	{
+		f0 = FineNode(I, imFine);
+		f1 = FineNode(I+1, imFine);
+
+		for (i=(f0 > 0 ? f0 : 1); i<f1 && i<imFine-1; i++)
+		{
+			w = (x[i] - x[f0])/(x[f1] - x[f0]);
+
+			for (c=0; c<3; c++)
+			{
+				/* The boundary nodes follow the boundary conditions of each level */
+				e0 = (I == 0)            ? 0 : Qc[c][I]   - Coarse->Qr[c][I];
+				e1 = (I+1 == imCoarse-1) ? 0 : Qc[c][I+1] - Coarse->Qr[c][I+1];
+
+				Q[c] = Qf[c][i] + e0 + w*(e1 - e0);
+			}
+
+			/* A correction that would make rho or p negative is not applied */
+			if (Q[0] > 0 && Q[2] - 0.5*Q[1]*Q[1]/Q[0] > 0)
+				for (c=0; c<3; c++)
+					Qf[c][i] = Q[c];
+		}
+	}
+
+	return Boundary(Fine->Data, Fine->Result);
+}
+
+/*
+** Function CycleLevel
+**    Smooths level k, corrects it with the next coarser level
+**    (visited once for a V-cycle, twice for a W-cycle) and
+**    smooths it again. The coarsest level is only smoothed,
+**    with at least one step.
+*/
+
+static int CycleLevel(tMultigrid *MG, int k, double *residual)
+{
+	int    ret;
+	int    s, g, n;
+	int    coarsest;
+	double coarseResidual, stepResidual;
+
+	ret      = 0;
+	coarsest = (k == MG->nLevels-1);
+	n        = coarsest ? MG->levels[0].Data->mgPre + MG->levels[0].Data->mgPost : MG->levels[0].Data->mgPre;
+
+	if (coarsest && n == 0)
+		n = 1;
+
+	/* The residual of the field the cycle starts from */
+	for (s=0; s<n && ret != -1; s++)
+	{
+		ret = Smooth(MG, k, 0, (s == 0) ? residual : &stepResidual);
+
+		if (k == 0 && s == 0)
+			memcpy(MG->norms, MG->levels[0].Result->norms, sizeof(MG->norms));
+	}
+
+	if (!coarsest && ret != -1)
+	{
+		ret = Residual(MG, k, (n == 0) ? residual : &stepResidual);
+
+		if (k == 0 && n == 0)
+			memcpy(MG->norms, MG->levels[0].Result->norms, sizeof(MG->norms));
+
+		if (ret != -1)
+		{
+			Restrict(MG, k+1);
+			ret = Smooth(MG, k+1, 1, &coarseResidual);
+		}
+
+		for (g=0; g<MG->levels[0].Data->mgCycle && ret != -1; g++)
+			ret = CycleLevel(MG, k+1, &coarseResidual);
+
+		if (ret != -1)
+			ret = Prolong(MG, k+1);
+
+		for (s=0; s<MG->levels[0].Data->mgPost && ret != -1; s++)
+			ret = Smooth(MG, k, 0, &stepResidual);
+	}
+
+	return ret;
+}
+
+/*
+** Function MultigridCycle
+**    Performs one multigrid cycle. Fails when the residual is
+**    not finite, or has not dropped over MULTIGRID_STALL cycles.
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results
+**           double  residual = residual of the first smoothing
+**                              step on level 0 (not normalised)
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int MultigridCycle(tData *Data, tResult *Result, double *residual)
+{
+	int        ret;
+	tMultigrid *MG = Result->multigrid;
+
+	if (MG->geometry == 0)
+		Geometry(MG);
+
+	MG->levels[0].Data = Data;
+
+	ret = CycleLevel(MG, 0, residual);
+
+	/* The later smoothing steps overwrote the norms */
+	memcpy(Result->norms, MG->norms, sizeof(MG->norms));
+
+	/* A diverged cycle would otherwise end the iterations as converged */
+	if (ret != -1 && !isfinite(*residual))
+	{
+		fprintf(stderr, "ERROR in function MultigridCycle: the residual is not finite; use fewer levels.\n");
+		ret = -1;
+	}
+
+	/* Nor would a cycle that no longer reduces the residual end them; a converged one may */
+	if (ret != -1)
+	{
+		if (MG->first == 0)
+			MG->first = *residual;
+
+		if (MG->best == 0 || *residual < MULTIGRID_DROP*MG->best)
+		{
+			MG->best    = *residual;
+			MG->stalled = 0;
+		}
+		else if (!(*residual > Data->stopTol*MG->first))
+			MG->stalled = 0;
+		else if (++MG->stalled >= MULTIGRID_STALL)
+		{
+			fprintf(stderr, "ERROR in function MultigridCycle: the residual stalled at %g for %d cycles; use fewer levels.\n",
+			        *residual, MULTIGRID_STALL);
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+/*
+** Function StartMultigrid
+**    Sets up the coarse levels and their workspaces. Coarsening
+**    stops at MULTIGRID_MINIM nodes.
+**
+** In:       FILE    log    = pointer to log file
+**           tData   Data   = structure containing all data
+** Out:      tResult Result = multigrid is set
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StartMultigrid(FILE *log, tData *Data, tResult *Result)
+{
+	int        ret;
+	int        k, c, im, nLevels;
+	tLevel     *Level;
+	tMultigrid *MG;
+
+	ret = 0;
+	Result->multigrid = NULL;
+
+	if (Data->mgLevels <= 1)
+		return ret;
+
+	/* Number of levels the grid allows */
+	nLevels = 1;
+	for (im=Data->im; nLevels < Data->mgLevels && (im+2)/2 >= MULTIGRID_MINIM; im=(im+2)/2)
+		nLevels++;
+
+	if (nLevels < Data->mgLevels)
+		fprintf(stderr, "WARNING: im = %d allows only %d multigrid levels.\n", Data->im, nLevels);
+
+	if (nLevels == 1)
+		return ret;
+
+	MG = calloc(1, sizeof(tMultigrid));
+	if (MG)
+		MG->levels = calloc(nLevels, sizeof(tLevel));
+
+	if (MG == NULL || MG->levels == NULL)
+	{
+		fprintf(stderr, "ERROR in function StartMultigrid: could not allocate memory...\n");
+		free(MG);
+		return -1;
+	}
+
+	MG->nLevels = nLevels;
+	Result->multigrid = MG;
+
+	for (k=0; k<nLevels && ret != -1; k++)
+	{
+		Level = &MG->levels[k];
+
+		if (k == 0)
+		{
+			Level->Data   = Data;
+			Level->Result = Result;
+		}
+		else
+		{
+			Level->LevelData          = *Data;
+			Level->LevelData.im       = (MG->levels[k-1].Result->im+2)/2;
+			Level->LevelData.mgLevels = 1;
+
+			Level->Data   = &Level->LevelData;
+			Level->Result = &Level->LevelResult;
+
+			ret = InitMem(NULL, Level->Data, Level->Result);
+		}
+
+		im = Level->Data->im;
+		Level->memory = malloc(13*(size_t)im*sizeof(double));
+
+		if (Level->memory == NULL)
+		{
+			fprintf(stderr, "ERROR in function StartMultigrid: could not allocate memory...\n");
+			ret = -1;
+		}
+		else
+		{
+			for (c=0; c<3; c++)
+			{
+				Level->Q0[c] = Level->memory + c*im;
+				Level->R[c]  = Level->memory + (3+c)*im;
+				Level->Qr[c] = Level->memory + (6+c)*im;
+				Level->P[c]  = Level->memory + (9+c)*im;
+			}
+
+			Level->dt = Level->memory + 12*im;
+		}
+	}
+
+	if (log && ret != -1)
+	{
+		fprintf(log, "\n   Multigrid: %d levels, %c-cycle, %d+%d smoothing steps, im =", nLevels,
+		        Data->mgCycle == MGCYCLE_W ? 'W' : 'V', Data->mgPre, Data->mgPost);
+		for (k=0; k<nLevels; k++)
+			fprintf(log, " %d", MG->levels[k].Data->im);
+		fprintf(log, "\n\n");
+	}
+
+	if (ret == -1)
+		StopMultigrid(Result);
+
+	return ret;
+}
+
+/*
+** Function StopMultigrid
+**    Frees the coarse levels.
+**
+** In:       tResult Result = structure containing results
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StopMultigrid(tResult *Result)
+{
+	int        ret;
+	int        k;
+	tMultigrid *MG = Result->multigrid;
+
+	ret = 0;
+
+	if (MG == NULL)
+		return ret;
+
+	for (k=0; k<MG->nLevels; k++)
+	{
+		if (k > 0 && MG->levels[k].LevelResult.arena && FreeMem(&MG->levels[k].LevelResult) == -1)
+			ret = -1;
+
+		free(MG->levels[k].memory);
+	}
+
+	free(MG->levels);
+	free(MG);
+
+	Result->multigrid = NULL;
+
+	return ret;
+}
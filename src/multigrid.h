@@ -0,0 +1,26 @@
+/*
+** Header-file for Multigrid
+*/
+
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+/* Smallest number of nodes of a coarse level */
+#define MULTIGRID_MINIM 5
+
+/* Most levels of MacCormack and MUSCL-Roe, whose smoothing falls off on
+   the coarse levels, and of a flow with a shock, which on more levels
+   may settle with the shock at the exit */
+#define MULTIGRID_LEVELS_CM    2
+#define MULTIGRID_LEVELS_SHOCK 4
+
+/* A run stalls when MULTIGRID_STALL cycles do not bring the residual
+   below MULTIGRID_DROP times the lowest residual so far */
+#define MULTIGRID_STALL 500
+#define MULTIGRID_DROP  0.9
+
+int StartMultigrid(FILE*, tData*, tResult*);
+int StopMultigrid(tResult*);
+int MultigridCycle(tData*, tResult*, double*);
+
+#endif
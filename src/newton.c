@@ -0,0 +1,618 @@
+/*
+** Newton
+**    Jacobian-free Newton-Krylov solver for the steady state of
+**    the selected scheme. The residual of the inner nodes is the
+**    change of one step of the scheme divided by its timestep,
+**    R(Q) = (S(Q)-Q)/dt, as for the multigrid cycle; it vanishes
+**    exactly where the scheme has converged. Every Newton step
+**    solves
+**
+**      (I/dtau - dR/dQ) dQ = R(Q)
+**
+**    with restarted GMRES. The products dR/dQ v are finite
+**    differences of R in the direction v, so the Jacobian is
+**    never formed. GMRES is preconditioned from the right with
+**    the block-tridiagonal Jacobian of the first order Roe
+**    scheme (ImplicitFactor), whatever the scheme.
+**
+**    The start-up is a pseudo-transient continuation with the
+**    preconditioner alone, dQ = M^-1 R(Q): the implicit Roe
+**    scheme applied to the residual of the selected scheme. Its
+**    CFL grows geometrically from 1 to newton_cfl over the
+**    first cfl_ramp steps. The exact Jacobian this early lets
+**    the shock run to the exit, to the other steady state of
+**    this exit condition; the start-up moves the shock to its
+**    place, about a node per step. Once the residual dropped by
+**    NEWTON_SWITCH from its largest value the steps are
+**    Newton-Krylov steps, with a CFL that grows with the drop
+**    of the residual after the switch (switched evolution
+**    relaxation) to NEWTON_CFL_MAX. A residual above stop_tol
+**    that does not drop by NEWTON_DROP in NEWTON_STALL steps per
+**    node fails the run.
+**
+**    The pseudo timestep dtau of a node is the timestep of the
+**    node at the CFL of the data-file, scaled to the CFL of the
+**    step; the residual itself is that of a step at the CFL of
+**    the data-file, which matters for MacCormack. The unknowns
+**    and the residual are scaled per component with the
+**    largest value of the field, so that rho*A and Et*A weigh
+**    alike.
+**
+**    The inlet is fixed and the exit node follows from
+**    Boundary; neither is an unknown, but the products dR/dQ v
+**    include the dependence of the exit node on the inner
+**    nodes.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include "main.h"
+#include "boundary.h"
+#include "implicit.h"
+#include "newton.h"
+#include "solve.h"
+#include "timestep.h"
+
+typedef struct
+{
+	int    n;         /* number of unknowns, 3*(im-2) */
+
+	long   steps;     /* steps done */
+	int    newton;    /* 0 during the start-up, 1 after */
+	double cfl;       /* pseudo-transient CFL of the last step */
+	double norm0;     /* largest residual norm of the start-up; at the switch after */
+	double first;     /* residual of the first step */
+	double best;      /* residual norm of the last drop by NEWTON_DROP */
+	long   stalled;   /* steps since that drop */
+	double qnorm;     /* scaled norm of the field of this step */
+	double scale[3];  /* scale of the components */
+
+	double *Q0[3];    /* field at the start of the Newton step */
+	double *Qs[3];    /* field before the step of an evaluation */
+	double *dt;       /* timestep per node of the last evaluation */
+	double *dtau;     /* pseudo timestep per node */
+
+	double *R0;       /* residual of the field of this step */
+	double *Rp;       /* residual of a perturbed field */
+	double *b;        /* scaled right hand side */
+	double *x;        /* scaled solution */
+	double *z;
+	double *w;
+
+	double *Lo, *Dinv, *C;   /* factors of the preconditioner */
+
+	double *V;        /* Krylov vectors, NEWTON_KRYLOV+1 of n */
+	double H[NEWTON_KRYLOV+1][NEWTON_KRYLOV];
+	double cs[NEWTON_KRYLOV], sn[NEWTON_KRYLOV];
+	double g[NEWTON_KRYLOV+1], y[NEWTON_KRYLOV];
+
+	double *memory;
+} tNewton;
+
+/*
+** Function Fields
+**    The conservative variables as an array.
+*/
+
+static void Fields(tResult *Result, double **Q)
+{
+	Q[0] = Result->Q1;
+	Q[1] = Result->Q2;
+	Q[2] = Result->Q3;
+}
+
+/*
+** Function Dot
+**    Inner product of two vectors of length n.
+*/
+
+static double Dot(int n, double *a, double *b)
+{
+	int    k;
+	double s = 0;
+
+	for (k=0; k<n; k++)
+		s += a[k]*b[k];
+
+	return s;
+}
+
+/*
+** Function Evaluate
+**    Residual R of the current field, from one step of the
+**    scheme whose update is discarded. The timesteps of the
+**    step are kept in dt.
+*/
+
+static int Evaluate(tNewton *N, tData *Data, tResult *Result, double *R, double *residual)
+{
+	int    ret;
+	int    i, c, im;
+	double *Q[3];
+
+	im = Result->im;
+	Fields(Result, Q);
+
+	for (c=0; c<3; c++)
+		memcpy(N->Qs[c], Q[c], im*sizeof(double));
+
+	/* The fused kernels keep the timestep of the next step; it must belong to this field */
+	if (Data->kernel == KERNEL_FUSED && Result->blocks == NULL)
+	{
+		ret = TimeStep(Data, Result);
+
+		for (i=0; i<im; i++)
+			N->dt[i] = Result->dt ? Result->dt[i] : Result->timeStep;
+
+		if (ret != -1)
+			ret = Step(Data, Result, residual);
+	}
+	else
+	{
+		ret = Step(Data, Result, residual);
+
+		for (i=0; i<im; i++)
+			N->dt[i] = Result->dt ? Result->dt[i] : Result->timeStep;
+	}
+
+	for (i=1; i<im-1; i++)
+		for (c=0; c<3; c++)
+			R[3*(i-1)+c] = (Q[c][i] - N->Qs[c][i])/N->dt[i];
+
+	for (c=0; c<3; c++)
+		memcpy(Q[c], N->Qs[c], im*sizeof(double));
+
+	return ret;
+}
+
+/*
+** Function Product
+**    Av = v/dtau - dR/dQ v for a scaled vector v; dR/dQ v is
+**    the finite difference of R in the direction v.
+*/
+
+static int Product(tNewton *N, tData *Data, tResult *Result, double *v, double *Av)
+{
+	int    ret;
+	int    i, c, k, im;
+	double norm, eps, dummy;
+	double *Q[3];
+
+	im = Result->im;
+	Fields(Result, Q);
+
+	norm = sqrt(Dot(N->n, v, v));
+	if (norm == 0)
+	{
+		memset(Av, 0, N->n*sizeof(double));
+		return 0;
+	}
+
+	eps = sqrt(DBL_EPSILON)*(1 + N->qnorm)/norm;
+
+	for (i=1; i<im-1; i++)
+		for (c=0; c<3; c++)
+			Q[c][i] = N->Q0[c][i] + eps*N->scale[c]*v[3*(i-1)+c];
+
+	ret = Boundary(Data, Result);
+
+	if (ret != -1)
+		ret = Evaluate(N, Data, Result, N->Rp, &dummy);
+
+	for (c=0; c<3; c++)
+		memcpy(Q[c], N->Q0[c], im*sizeof(double));
+
+	for (i=1; i<im-1; i++)
+		for (c=0; c<3; c++)
+		{
+			k     = 3*(i-1)+c;
+			Av[k] = v[k]/N->dtau[i] - (N->Rp[k] - N->R0[k])/(eps*N->scale[c]);
+		}
+
+	return ret;
+}
+
+/*
+** Function Precondition
+**    z = M^-1 w for scaled vectors, with M = I/dtau + dR/dQ of
+**    the first order Roe scheme.
+*/
+
+static void Precondition(tNewton *N, int im, double *w, double *z)
+{
+	int i, c, k;
+
+	for (i=1; i<im-1; i++)
+		for (c=0; c<3; c++)
+		{
+			k    = 3*(i-1)+c;
+			z[k] = N->dtau[i]*N->scale[c]*w[k];
+		}
+
+	ImplicitSolve(im, N->Lo, N->Dinv, N->C, z);
+
+	for (i=1; i<im-1; i++)
+		for (c=0; c<3; c++)
+			z[3*(i-1)+c] /= N->scale[c];
+}
+
+/*
+** Function Gmres
+**    Restarted GMRES with right preconditioning for A x = b;
+**    stops when the linear residual dropped by NEWTON_ETA or
+**    after NEWTON_RESTARTS restarts.
+*/
+
+static int Gmres(tNewton *N, tData *Data, tResult *Result)
+{
+	int    ret;
+	int    n, m, im, j, k, l, restart, done;
+	double bnorm, beta, target, d, t;
+	double *V, *Vj;
+
+	ret  = 0;
+	n    = N->n;
+	m    = NEWTON_KRYLOV;
+	im   = Result->im;
+	V    = N->V;
+	done = 0;
+
+	memset(N->x, 0, n*sizeof(double));
+
+	bnorm  = sqrt(Dot(n, N->b, N->b));
+	target = NEWTON_ETA*bnorm;
+
+	if (bnorm == 0)
+		return ret;
+
+	for (restart=0; restart<=NEWTON_RESTARTS && !done && ret!=-1; restart++)
+	{
+		/* Residual of the linear system */
+		if (restart == 0)
+			memcpy(V, N->b, n*sizeof(double));
+		else
+		{
+			ret = Product(N, Data, Result, N->x, N->w);
+
+			for (k=0; k<n; k++)
+				V[k] = N->b[k] - N->w[k];
+		}
+
+		beta = sqrt(Dot(n, V, V));
+		if (beta <= target || ret == -1)
+			break;
+
+		for (k=0; k<n; k++)
+			V[k] /= beta;
+
+		N->g[0] = beta;
+
+		/* Arnoldi with modified Gram-Schmidt; Givens rotations keep H upper triangular */
+		for (j=0; j<m && !done && ret!=-1; j++)
+		{
+			Vj = V + (size_t)(j+1)*n;
+
+			Precondition(N, im, V + (size_t)j*n, N->z);
+			ret = Product(N, Data, Result, N->z, Vj);
+
+			for (k=0; k<=j; k++)
+			{
+				N->H[k][j] = Dot(n, Vj, V + (size_t)k*n);
+
+				for (l=0; l<n; l++)
+					Vj[l] -= N->H[k][j]*V[(size_t)k*n+l];
+			}
+
+			N->H[j+1][j] = sqrt(Dot(n, Vj, Vj));
+			if (N->H[j+1][j] > 0)
+				for (l=0; l<n; l++)
+					Vj[l] /= N->H[j+1][j];
+
+			for (k=0; k<j; k++)
+			{
+				t            =  N->cs[k]*N->H[k][j] + N->sn[k]*N->H[k+1][j];
+				N->H[k+1][j] = -N->sn[k]*N->H[k][j] + N->cs[k]*N->H[k+1][j];
+				N->H[k][j]   = t;
+			}
+
+			d = hypot(N->H[j][j], N->H[j+1][j]);
+			if (d == 0)
+			{
+				fprintf(stderr, "ERROR in function Gmres: singular Hessenberg matrix.\n");
+				ret = -1;
+				break;
+			}
+
+			N->cs[j]     = N->H[j][j]/d;
+			N->sn[j]     = N->H[j+1][j]/d;
+			N->H[j][j]   = d;
+			N->H[j+1][j] = 0;
+			N->g[j+1]    = -N->sn[j]*N->g[j];
+			N->g[j]      =  N->cs[j]*N->g[j];
+
+			Result->linear++;
+
+			if (fabs(N->g[j+1]) <= target || N->sn[j] == 0)
+				done = 1;
+		}
+
+		/* x += M^-1 V y, with H y = g over the j columns built */
+		for (k=j-1; k>=0 && ret!=-1; k--)
+		{
+			N->y[k] = N->g[k];
+			for (l=k+1; l<j; l++)
+				N->y[k] -= N->H[k][l]*N->y[l];
+			N->y[k] /= N->H[k][k];
+		}
+
+		if (ret != -1)
+		{
+			memset(N->w, 0, n*sizeof(double));
+			for (k=0; k<j; k++)
+				for (l=0; l<n; l++)
+					N->w[l] += N->y[k]*V[(size_t)k*n+l];
+
+			Precondition(N, im, N->w, N->z);
+
+			for (l=0; l<n; l++)
+				N->x[l] += N->z[l];
+		}
+	}
+
+	return ret;
+}
+
+/*
+** Function NewtonStep
+**    One step of the Newton-Krylov solver: residual, pseudo
+**    timestep, preconditioner, GMRES and the update of the
+**    inner field and the exit boundary.
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results
+**           double  residual = residual of the field before the step
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int NewtonStep(tData *Data, tResult *Result, double *residual)
+{
+	int     ret;
+	int     i, c, k, im;
+	double  norm, u, pA, dpA, change, omega;
+	double  dQ[3], norms[NORMS];
+	double  *Q[3];
+	tNewton *N = Result->newton;
+
+	if (N == NULL)
+	{
+		fprintf(stderr, "ERROR in function NewtonStep: No workspace allocated.\n");
+		return -1;
+	}
+
+	im = Result->im;
+	Fields(Result, Q);
+
+	for (c=0; c<3; c++)
+		memcpy(N->Q0[c], Q[c], im*sizeof(double));
+
+	ret = Evaluate(N, Data, Result, N->R0, residual);
+
+	/* The evaluations of GMRES overwrite the norms of the residual */
+	memcpy(norms, Result->norms, sizeof(norms));
+
+	if (ret != -1)
+	{
+		/* Scale of the components */
+		for (c=0; c<3; c++)
+		{
+			N->scale[c] = 0;
+			for (i=0; i<im; i++)
+				N->scale[c] = fmax(N->scale[c], fabs(Q[c][i]));
+
+			if (N->scale[c] == 0)
+				N->scale[c] = 1;
+		}
+
+		N->qnorm = 0;
+		for (i=1; i<im-1; i++)
+			for (c=0; c<3; c++)
+			{
+				k        = 3*(i-1)+c;
+				N->b[k]  = N->R0[k]/N->scale[c];
+				N->qnorm += pow(Q[c][i]/N->scale[c], 2);
+			}
+
+		norm     = sqrt(Dot(N->n, N->b, N->b));
+		N->qnorm = sqrt(N->qnorm);
+
+		/* A residual that does not settle, as MacCormack's at a large newton_cfl; a converged one may */
+		if (N->first == 0)
+			N->first = *residual;
+
+		if (N->best == 0 || norm < NEWTON_DROP*N->best)
+		{
+			N->best    = norm;
+			N->stalled = 0;
+		}
+		else if (!(*residual > Data->stopTol*N->first))
+			N->stalled = 0;
+		else if (++N->stalled >= (long)NEWTON_STALL*im)
+		{
+			fprintf(stderr, "ERROR in function NewtonStep: the residual stalled at %g for %ld steps; lower newton_cfl.\n",
+			        norm, N->stalled);
+			ret = -1;
+		}
+
+		/* Start-up until the residual dropped by NEWTON_SWITCH from its largest value */
+		if (!N->newton)
+		{
+			N->norm0 = fmax(N->norm0, norm);
+
+			if (norm < NEWTON_SWITCH*N->norm0)
+			{
+				N->newton = 1;
+				N->norm0  = norm;
+			}
+		}
+
+		/* Start-up: CFL ramp to newton_cfl; after: switched evolution relaxation */
+		if (!N->newton)
+			N->cfl = (N->steps < Data->cflRamp) ? pow(Data->newtonCFL, (double)N->steps/Data->cflRamp) : Data->newtonCFL;
+		else
+			N->cfl = fmin(NEWTON_CFL_MAX, Data->newtonCFL*N->norm0/norm);
+
+		N->steps++;
+		if (!N->newton)
+			Result->startup++;
+
+		for (i=0; i<im; i++)
+			N->dtau[i] = N->dt[i]*N->cfl/Data->CFL;
+
+		if (ret != -1)
+			ret = ImplicitFactor(Data, Result, N->dtau, N->Lo, N->Dinv, N->C);
+	}
+
+	if (ret != -1)
+	{
+		if (N->newton)
+			ret = Gmres(N, Data, Result);
+		else
+			Precondition(N, im, N->b, N->x);
+	}
+
+	if (ret != -1)
+	{
+		/* Relaxation: no node may change rho or p (linearised) by more than NEWTON_MAXCHANGE */
+		change = 0;
+		for (i=1; i<im-1; i++)
+		{
+			for (c=0; c<3; c++)
+				dQ[c] = N->scale[c]*N->x[3*(i-1)+c];
+
+			u      = Q[1][i]/Q[0][i];
+			pA     = (Q[2][i] - 0.5*Q[1][i]*u)*(Data->gamma-1);
+			dpA    = (dQ[2] - u*dQ[1] + 0.5*u*u*dQ[0])*(Data->gamma-1);
+
+			change = fmax(change, fabs(dQ[0]/Q[0][i]));
+			change = fmax(change, fabs(dpA/pA));
+		}
+
+		omega = (change > NEWTON_MAXCHANGE) ? NEWTON_MAXCHANGE/change : 1;
+
+		for (i=1; i<im-1; i++)
+			for (c=0; c<3; c++)
+				Q[c][i] += omega*N->scale[c]*N->x[3*(i-1)+c];
+
+		ret = Boundary(Data, Result);
+	}
+
+	memcpy(Result->norms, norms, sizeof(norms));
+
+	return ret;
+}
+
+/*
+** Function StartNewton
+**    Sets up the workspace of the Newton-Krylov solver, if it
+**    is selected.
+**
+** In:       FILE    log    = pointer to log file
+**           tData   Data   = structure containing all data
+** Out:      tResult Result = newton is set
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StartNewton(FILE *log, tData *Data, tResult *Result)
+{
+	int     c, im, n;
+	double  *next;
+	tNewton *N;
+
+	Result->newton = NULL;
+
+	if (Data->solver != SOLVER_NEWTON)
+		return 0;
+
+	im = Data->im;
+	n  = 3*(im-2);
+
+	N = calloc(1, sizeof(tNewton));
+	if (N)
+		N->memory = malloc((8*(size_t)im + (15 + NEWTON_KRYLOV+1)*(size_t)n)*sizeof(double));
+
+	if (N == NULL || N->memory == NULL)
+	{
+		fprintf(stderr, "ERROR in function StartNewton: could not allocate memory...\n");
+		free(N);
+		return -1;
+	}
+
+	N->n = n;
+	next = N->memory;
+
+	for (c=0; c<3; c++)
+	{
+		N->Q0[c] = next; next += im;
+		N->Qs[c] = next; next += im;
+	}
+
+	N->dt   = next; next += im;
+	N->dtau = next; next += im;
+
+	N->R0   = next; next += n;
+	N->Rp   = next; next += n;
+	N->b    = next; next += n;
+	N->x    = next; next += n;
+	N->z    = next; next += n;
+	N->w    = next; next += n;
+
+	N->Lo   = next; next += 3*n;
+	N->Dinv = next; next += 3*n;
+	N->C    = next; next += 3*n;
+
+	N->V    = next;
+
+	Result->newton = N;
+
+	if (log)
+		fprintf(log, "\n   Newton-Krylov: %d unknowns, GMRES(%d), at most %d restarts\n\n",
+		        n, NEWTON_KRYLOV, NEWTON_RESTARTS);
+
+	return 0;
+}
+
+/*
+** Function StopNewton
+**    Frees the workspace of the Newton-Krylov solver.
+**
+** In:       tResult Result = structure containing results
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int StopNewton(tResult *Result)
+{
+	tNewton *N = Result->newton;
+
+	if (N)
+	{
+		free(N->memory);
+		free(N);
+	}
+
+	Result->newton = NULL;
+
+	return 0;
+}
@@ -0,0 +1,37 @@
+/*
+** Header-file for Newton
+*/
+
+#ifndef NEWTON_H
+#define NEWTON_H
+
+/* Krylov vectors of GMRES before a restart */
+#define NEWTON_KRYLOV 30
+
+/* Restarts of GMRES in one Newton step */
+#define NEWTON_RESTARTS 3
+
+/* GMRES stops when the linear residual dropped by this factor */
+#define NEWTON_ETA 1e-3
+
+/* The start-up ends when the residual dropped by this factor */
+#define NEWTON_SWITCH 1e-1
+
+/* Largest pseudo-transient CFL; beyond it the step is a Newton step */
+#define NEWTON_CFL_MAX 1e12
+
+/* Largest relative change of rho and p in one step; larger steps are scaled down */
+#define NEWTON_MAXCHANGE 0.5
+
+/* Largest newton_cfl of scheme C; at 100 the start-up finds a wrong steady state, at 1000 none */
+#define NEWTON_CFL_C 20
+
+/* Steps per node without a drop of the residual by NEWTON_DROP before the run fails */
+#define NEWTON_STALL 5
+#define NEWTON_DROP  0.9
+
+int StartNewton(FILE*, tData*, tResult*);
+int StopNewton(tResult*);
+int NewtonStep(tData*, tResult*, double*);
+
+#endif
@@ -0,0 +1,93 @@
+/*
+** Header-file for Norms
+*/
+
+#ifndef NORMS_H
+#define NORMS_H
+
+#include <math.h>
+#include <string.h>
+
+/* Norm of equation e (0: rho, 1: rho*u, 2: rho*E) is norms[3*e + NORM_...] */
+#define NORM_L1   0
+#define NORM_L2   1
+#define NORM_LINF 2
+
+/*
+** Function ClearNorms
+**   Empties the norms before the update of a step.
+*/
+
+static inline void ClearNorms(double *norms)
+{
+	memset(norms, 0, NORMS*sizeof(double));
+}
+
+/*
+** Function AddNorms
+**   Adds the time derivatives of rho, rho*u and rho*E in one node
+**   to the L1 norm, the sum of squares (L2) and the largest value
+**   (Linf) of each equation. Used by the update loops of all
+**   schemes, so the norms cost no extra pass over the field.
+**   Without norms (NULL: no stopping rule needs them) only the
+**   term of the residual is computed.
+**
+** In:       double drho     = time derivative of rho
+**           double dQ2,dQ3  = change of rho*u*A and rho*E*A
+**           double rate     = 1/(A*timeStep) of the node
+** Out:      double norms    = norms of the step, or NULL
+** Return:   drho*drho, the term of the residual
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline double AddNorms(double *norms, double drho, double dQ2, double dQ3, double rate)
+{
+	double d1, d2, d3, a1, a2, a3;
+
+	if (norms == NULL)
+		return drho*drho;
+
+	d1 = drho;
+	d2 = dQ2*rate;
+	d3 = dQ3*rate;
+
+	a1 = fabs(d1);
+	a2 = fabs(d2);
+	a3 = fabs(d3);
+
+	norms[NORM_L1]   += a1;
+	norms[NORM_L2]   += d1*d1;
+	norms[NORM_LINF]  = a1 > norms[NORM_LINF] ? a1 : norms[NORM_LINF];
+
+	norms[3+NORM_L1]   += a2;
+	norms[3+NORM_L2]   += d2*d2;
+	norms[3+NORM_LINF]  = a2 > norms[3+NORM_LINF] ? a2 : norms[3+NORM_LINF];
+
+	norms[6+NORM_L1]   += a3;
+	norms[6+NORM_L2]   += d3*d3;
+	norms[6+NORM_LINF]  = a3 > norms[6+NORM_LINF] ? a3 : norms[6+NORM_LINF];
+
+	return d1*d1;
+}
+
+/*
+** Function MergeNorms
+**   Adds the norms of a part of the field to those of the whole.
+*/
+
+static inline void MergeNorms(double *norms, const double *part)
+{
+	int e;
+
+	for (e=0; e<3; e++)
+	{
+		norms[3*e+NORM_L1] += part[3*e+NORM_L1];
+		norms[3*e+NORM_L2] += part[3*e+NORM_L2];
+
+		if (part[3*e+NORM_LINF] > norms[3*e+NORM_LINF])
+			norms[3*e+NORM_LINF] = part[3*e+NORM_LINF];
+	}
+}
+
+#endif
@@ -0,0 +1,343 @@
+/*
+** Nozzle
+**    Interface of libnozzle, the solver as a library. A context
+**    holds its own copy of the data, the workspace and the state
+**    of the iteration; the solver keeps no other state, so any
+**    number of contexts may be solved side by side, one per
+**    thread. The library opens no files and writes nothing but
+**    the error messages on stderr: the caller sets up tData with
+**    NozzleDefaults, the fixed settings and NozzleOption, and
+**    reads the field in the workspace with NozzleFields.
+**
+**    A typical solve:
+**
+**      NozzleDefaults(&Data);
+**      Data.gamma = 1.4; ... Data.im = 101;
+**      NozzleOption(&Data, "stop_tol", "1e-8");
+**
+**      N = NozzleCreate(&Data);
+**      NozzleInit(N);
+**      NozzleSolve(N, 0, &iterations, &residual);
+**      NozzleFields(N, &im, &x, &A, &Q1, &Q2, &Q3);
+**      NozzleGradient(N, ADJOINT_THRUST, &thrust, dJdA, dJdS);
+**      NozzleDestroy(N);
+**
+**    Only the trace of a 'make TRACE=1' build is shared by the
+**    whole process (see trace.h).
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "main.h"
+#include "adjoint.h"
+#include "data.h"
+#include "initialise.h"
+#include "memory.h"
+#include "monitor.h"
+#include "nozzle.h"
+#include "sequence.h"
+#include "solve.h"
+
+struct sNozzle
+{
+	tData   Data;
+	tResult Result;
+	int     allocated;     /* the workspace of Result is allocated */
+	int     converged;     /* the stopping rule holds after the last iteration */
+	double  normResidual;  /* normalisation of the residual; 0 until the first iteration */
+};
+
+/*
+** Function Advance
+**    Performs iterations on the context, n of them or, if
+**    converge is set, until the stopping rule holds (n <= 0:
+**    no limit). Returns the number of iterations done, -1 on
+**    failure.
+*/
+
+static int Advance(tNozzle *N, int n, int converge, double *residual)
+{
+	int    ret;
+	int    i;
+	double r;
+
+	ret = 0;
+	r   = 0;
+
+	for (i=0; (n <= 0 || i < n) && !(converge && N->converged) && ret != -1; i++)
+	{
+		ret = Iterate(&N->Data, &N->Result, &r);
+
+		if (N->normResidual == 0)
+			N->normResidual = r;
+
+		r /= N->normResidual;
+
+		if (ret != -1 && (N->converged = Converged(&N->Data, &N->Result, r)) == -1)
+		{
+			N->converged = 0;
+			ret          = -1;
+		}
+	}
+
+	if (residual)
+		*residual = r;
+
+	return (ret == -1) ? -1 : i;
+}
+
+/*
+** Function NozzleDefaults
+**   Sets the optional settings to their defaults; the fixed
+**   settings of the data-file (gamma up to im) are the caller's.
+**
+** In:       -
+** Out:      tData Data = structure containing all data
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void NozzleDefaults(tData *Data)
+{
+	DefaultData(Data);
+}
+
+/*
+** Function NozzleOption
+**   Sets one optional setting, by the keyword and value of the
+**   data-file (see ReadOptions).
+**
+** In:       char  key   = keyword
+**           char  value = value
+** Out:      tData Data  = structure containing all data
+** Return:   0 on success, -1 on an unknown keyword or value
+**
+** Author:   J.L. Klaufus
+*/
+
+int NozzleOption(tData *Data, char *key, char *value)
+{
+	return SetOption(Data, key, value);
+}
+
+/*
+** Function NozzleCreate
+**   Creates a solver context for a copy of the data. The
+**   settings the scheme does not support are dropped, as when
+**   the data-file is read.
+**
+** In:       tData Data = structure containing all data
+** Out:      -
+** Return:   the context, NULL on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+tNozzle *NozzleCreate(tData *Data)
+{
+	tNozzle *N;
+
+	if (Data->im < 3)
+	{
+		fprintf(stderr, "ERROR in function NozzleCreate: im = %d, at least 3 nodes are needed.\n", Data->im);
+		return NULL;
+	}
+
+	N = calloc(1, sizeof(tNozzle));
+	if (N == NULL)
+	{
+		fprintf(stderr, "ERROR in function NozzleCreate: could not allocate memory...\n");
+		return NULL;
+	}
+
+	N->Data = *Data;
+	CheckOptions(&N->Data);
+
+	return N;
+}
+
+/*
+** Function NozzleInit
+**   Allocates the workspace and sets the start field, solved on
+**   the coarse grids first if the data ask for grid sequencing.
+**   Initialising again starts the solve anew in a fresh
+**   workspace.
+**
+** In:       tNozzle N = solver context
+** Out:      tNozzle N = start field
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int NozzleInit(tNozzle *N)
+{
+	int  ret;
+	long work;
+
+	ret = 0;
+
+	if (N->allocated)
+		ret = FreeMem(&N->Result);
+
+	N->allocated    = 0;
+	N->converged    = 0;
+	N->normResidual = 0;
+
+	if (ret != -1)
+	{
+		ret = InitMem(NULL, &N->Data, &N->Result);
+
+		/* FreeMem also cleans up after a failed InitMem */
+		N->allocated = 1;
+	}
+
+	if (ret != -1)
+		ret = Init(NULL, &N->Data, &N->Result);
+
+	if (ret != -1 && N->Data.sequence > 0)
+		ret = Sequence(NULL, &N->Data, &N->Result, 0, &N->normResidual, &work);
+
+	return ret;
+}
+
+/*
+** Function NozzleStep
+**   Performs a fixed number of iterations, whether or not the
+**   stopping rule holds.
+**
+** In:       tNozzle N        = solver context
+**           int     n        = number of iterations
+** Out:      tNozzle N        = field after the iterations
+**           double  residual = normalised residual of the last iteration
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int NozzleStep(tNozzle *N, int n, double *residual)
+{
+	if (n <= 0)
+		return 0;
+
+	return (Advance(N, n, 0, residual) == -1) ? -1 : 0;
+}
+
+/*
+** Function NozzleSolve
+**   Iterates until the stopping rule of the data holds; by
+**   default, until the residual, normalised with the residual of
+**   the first iteration, drops below stop_tol.
+**
+** In:       tNozzle N          = solver context
+**           int     maxIter    = maximum number of iterations (0: no limit)
+** Out:      tNozzle N          = field after the iterations
+**           int     iterations = number of iterations done
+**           double  residual   = normalised residual of the last iteration
+** Return:   1 when the stopping rule holds, 0 when maxIter ran
+**           out, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int NozzleSolve(tNozzle *N, int maxIter, int *iterations, double *residual)
+{
+	int i;
+
+	i = Advance(N, maxIter, 1, residual);
+
+	if (iterations)
+		*iterations = (i == -1) ? 0 : i;
+
+	if (i == -1)
+		return -1;
+
+	return N->converged;
+}
+
+/*
+** Function NozzleFields
+**   Gives the grid and the field of the context in place, without
+**   a copy. The pointers hold until the next iteration (the
+**   adaptation moves the grid) or initialisation of the context.
+**
+** In:       tNozzle N     = solver context
+** Out:      int     im    = number of nodes
+**           double  x, A  = co-ordinates and areas of the nodes
+**           double  Q1..3 = rho*A, rho*u*A and Et*A
+** Return:   0 on success, -1 when the context has no workspace
+**
+** Author:   J.L. Klaufus
+*/
+
+int NozzleFields(tNozzle *N, int *im, const double **x, const double **A,
+                 const double **Q1, const double **Q2, const double **Q3)
+{
+	if (!N->allocated || N->Result.arena == NULL)
+	{
+		fprintf(stderr, "ERROR in function NozzleFields: The context is not initialised.\n");
+		return -1;
+	}
+
+	*im = N->Result.im;
+	*x  = N->Result.x;
+	*A  = N->Result.A;
+	*Q1 = N->Result.Q1;
+	*Q2 = N->Result.Q2;
+	*Q3 = N->Result.Q3;
+
+	return 0;
+}
+
+/*
+** Function NozzleGradient
+**   Gradient of an output of the field to the area and the
+**   area slope of every node, by the discrete adjoint (see
+**   adjoint.c); meant for the converged field.
+**
+** In:       tNozzle N      = solver context
+**           int     output = ADJOINT_THRUST or ADJOINT_MACH
+** Out:      double  value  = the output
+**           double  dJdA   = dJ/dA of every node (im)
+**           double  dJdS   = dJ/d(dA/dx) of every node (im)
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int NozzleGradient(tNozzle *N, int output, double *value, double *dJdA, double *dJdS)
+{
+	if (!N->allocated || N->Result.arena == NULL)
+	{
+		fprintf(stderr, "ERROR in function NozzleGradient: The context is not initialised.\n");
+		return -1;
+	}
+
+	return Adjoint(&N->Data, &N->Result, output, value, dJdA, dJdS);
+}
+
+/*
+** Function NozzleDestroy
+**   Frees the workspace and the context.
+**
+** In:       tNozzle N = solver context
+** Out:      -
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void NozzleDestroy(tNozzle *N)
+{
+	if (N == NULL)
+		return;
+
+	if (N->allocated)
+		FreeMem(&N->Result);
+
+	free(N);
+}
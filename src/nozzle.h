@@ -0,0 +1,24 @@
+/*
+** Header-file for Nozzle, the interface of libnozzle
+*/
+
+#ifndef NOZZLE_H
+#define NOZZLE_H
+
+/* tData and the constants of its settings */
+#include "main.h"
+
+/* Solver context; opaque to the caller */
+typedef struct sNozzle tNozzle;
+
+void    NozzleDefaults(tData*);
+int     NozzleOption(tData*, char*, char*);
+tNozzle *NozzleCreate(tData*);
+int     NozzleInit(tNozzle*);
+int     NozzleStep(tNozzle*, int, double*);
+int     NozzleSolve(tNozzle*, int, int*, double*);
+int     NozzleFields(tNozzle*, int*, const double**, const double**, const double**, const double**, const double**);
+int     NozzleGradient(tNozzle*, int, double*, double*, double*);
+void    NozzleDestroy(tNozzle*);
+
+#endif
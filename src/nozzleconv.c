@@ -0,0 +1,87 @@
+/*
+** Program NozzleConv
+**   Converts the binary output of program Nozzle into the
+**   GNUPlot text format: the residual history (residual.bin,
+**   the default) or the result file (nozzle.res), told apart by
+**   their magic. Default output is standard output, i.e.
+**   'nozzleconv > residual.gnu' or 'nozzleconv nozzle.res
+**   nozzle.gnu'. Option -e writes all digits of the result,
+**   option -l lists its settings instead.
+**
+** Use:      nozzleconv [-e|-l] [INFILE [OUTFILE]]
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "main.h"
+#include "history.h"
+#include "result.h"
+
+int main(int argc, char *argv[])
+{
+	int  ret;
+	int  first;
+	int  exact = 0;
+	int  list  = 0;
+	char magic[8];
+	char *inFileName = "residual.bin";
+	FILE *inFile;
+	FILE *outFile    = stdout;
+
+	first = 1;
+	if (argc > 1 && strcmp(argv[1], "-e") == 0)
+	{
+		exact = 1;
+		first = 2;
+	}
+	else if (argc > 1 && strcmp(argv[1], "-l") == 0)
+	{
+		list  = 1;
+		first = 2;
+	}
+
+	if (argc > first+2)
+	{
+		printf("Use : nozzleconv [-e|-l] [INFILE [OUTFILE]]\n");
+		return -1;
+	}
+
+	if (argc > first)
+		inFileName = argv[first];
+
+	inFile = fopen(inFileName, "rb");
+	if (inFile == NULL)
+	{
+		fprintf(stderr, "ERROR in function NozzleConv: Could not open '%s'.\n", inFileName);
+		return -1;
+	}
+
+	if (argc > first+1)
+	{
+		outFile = fopen(argv[first+1], "w");
+		if (outFile == NULL)
+		{
+			fprintf(stderr, "ERROR in function NozzleConv: Could not open '%s'.\n", argv[first+1]);
+			fclose(inFile);
+			return -1;
+		}
+	}
+
+	/* A result file, or else a residual history */
+	if (fread(magic, 1, 8, inFile) == 8 && memcmp(magic, RESULT_MAGIC, 8) == 0)
+		ret = list ? ListResult(inFile, outFile) : ConvertResult(inFile, outFile, exact);
+	else
+	{
+		rewind(inFile);
+		ret = ConvertHistory(inFile, outFile);
+	}
+
+	fclose(inFile);
+	if (outFile != stdout && fclose(outFile) != 0)
+		ret = -1;
+
+	return ret == -1 ? -1 : 0;
+}
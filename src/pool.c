@@ -0,0 +1,187 @@
+/*
+** Work-stealing pool
+**    Runs nTasks independent tasks on nThreads threads. Every
+**    worker owns a deque with a contiguous range of task
+**    numbers: it takes tasks from the bottom of its own deque,
+**    and when that is empty it steals from the top of the deque
+**    of another worker. Long and short tasks are therefore
+**    balanced without a central queue; the lock of a deque is
+**    only contended while it is being stolen from.
+**
+** Author:   J.L. Klaufus
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+typedef struct
+{
+	pthread_mutex_t lock;
+	int             top;
+	int             bottom;
+} tDeque;
+
+typedef struct
+{
+	int    id;
+	int    nThreads;
+	int    failed;
+	tDeque *deques;
+	tTask  task;
+	void   *context;
+} tWorker;
+
+/*
+** Function PopTask
+**    Takes the next task from the bottom of the own deque, or
+**    steals one from the top of another deque.
+**
+** Return:   task number, -1 when all deques are empty
+*/
+
+static int PopTask(tWorker *Worker)
+{
+	int    k, task;
+	tDeque *deque;
+
+	task  = -1;
+	deque = &Worker->deques[Worker->id];
+
+	pthread_mutex_lock(&deque->lock);
+	if (deque->bottom > deque->top)
+		task = --deque->bottom;
+	pthread_mutex_unlock(&deque->lock);
+
+	for (k=1; k<Worker->nThreads && task == -1; k++)
+	{
+		deque = &Worker->deques[(Worker->id + k) % Worker->nThreads];
+
+		pthread_mutex_lock(&deque->lock);
+		if (deque->bottom > deque->top)
+			task = deque->top++;
+		pthread_mutex_unlock(&deque->lock);
+	}
+
+	return task;
+}
+
+static void *RunWorker(void *arg)
+{
+	int     task;
+	tWorker *Worker = arg;
+
+	while ((task = PopTask(Worker)) != -1)
+	{
+		if (Worker->task(Worker->context, Worker->id, task) == -1)
+			Worker->failed++;
+	}
+
+	return NULL;
+}
+
+/*
+** Function RunPool
+**    Runs all tasks and waits for them. A failing task does not
+**    stop the others.
+**
+** In:       int   nThreads = number of worker threads
+**           int   nTasks   = number of tasks
+**           tTask task     = function called for every task
+**           void  context  = passed to every call of task
+** Out:      -
+** Return:   number of failed tasks, -1 if the pool could not start
+**
+** Author:   J.L. Klaufus
+*/
+
+int RunPool(int nThreads, int nTasks, tTask task, void *context)
+{
+	int       ret;
+	int       w;
+	int       started;
+	tDeque    *deques;
+	tWorker   *workers;
+	pthread_t *threads;
+
+	if (nThreads > nTasks)
+		nThreads = nTasks;
+	if (nThreads < 1)
+		nThreads = 1;
+
+	deques  = malloc(nThreads*sizeof(tDeque));
+	workers = malloc(nThreads*sizeof(tWorker));
+	threads = malloc(nThreads*sizeof(pthread_t));
+
+	if (deques == NULL || workers == NULL || threads == NULL)
+	{
+		fprintf(stderr, "ERROR in function RunPool: could not allocate memory...\n");
+		free(deques);
+		free(workers);
+		free(threads);
+		return -1;
+	}
+
+	/* Contiguous blocks of tasks per worker */
+	for (w=0; w<nThreads; w++)
+	{
+		pthread_mutex_init(&deques[w].lock, NULL);
+		deques[w].top    = (int)((long long)nTasks*w/nThreads);
+		deques[w].bottom = (int)((long long)nTasks*(w+1)/nThreads);
+
+		workers[w].id       = w;
+		workers[w].nThreads = nThreads;
+		workers[w].failed   = 0;
+		workers[w].deques   = deques;
+		workers[w].task     = task;
+		workers[w].context  = context;
+	}
+
+	/* Worker 0 is the calling thread */
+	started = 1;
+	for (w=1; w<nThreads; w++)
+	{
+		if (pthread_create(&threads[w], NULL, RunWorker, &workers[w]) != 0)
+			break;
+		started++;
+	}
+
+	/* Tasks of workers that did not start are stolen by the others */
+	RunWorker(&workers[0]);
+
+	for (w=1; w<started; w++)
+		pthread_join(threads[w], NULL);
+
+	/* Only when all workers are done: they lock each other's deques */
+	ret = 0;
+	for (w=0; w<nThreads; w++)
+	{
+		ret += workers[w].failed;
+		pthread_mutex_destroy(&deques[w].lock);
+	}
+
+	free(deques);
+	free(workers);
+	free(threads);
+
+	return ret;
+}
+
+/*
+** Function NumberOfCores
+**    Number of processors online; the default number of threads.
+*/
+
+int NumberOfCores(void)
+{
+	long n;
+
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return n < 1 ? 1 : (int)n;
+}
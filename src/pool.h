@@ -0,0 +1,14 @@
+/*
+** Header-file for Pool
+*/
+
+#ifndef POOL_H
+#define POOL_H
+
+/* Task of the pool: context, worker number, task number; 0 or -1 */
+typedef int (*tTask)(void*, int, int);
+
+int RunPool(int, int, tTask, void*);
+int NumberOfCores(void);
+
+#endif
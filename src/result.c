@@ -0,0 +1,393 @@
+/*
+** Result
+**    Binary file of the flow field at the end of a run. The file
+**    describes itself: a header of RESULT_HEADER bytes, a table
+**    of named parameters and the names of the columns, followed
+**    by the columns of im doubles each, in the byte order of the
+**    machine that wrote it:
+**
+**      magic        8 bytes  RESULT_MAGIC
+**      version      int32    RESULT_VERSION
+**      im           int32    number of nodes
+**      parameters   int32    entries of the parameter table
+**      columns      int32    number of columns
+**      iteration    int32    iterations done
+**      residual     double   normalised residual of the last iteration
+**
+**      parameter    RESULT_NAME bytes name, double value
+**      column       RESULT_NAME bytes name
+**
+**    The parameters are the settings of the data-file; the
+**    columns are x, A, Q1, Q2 and Q3 and the primitives rho, u, T,
+**    p and M. The arrays of the field are written with one fwrite
+**    each, the primitives RESULT_BLOCK nodes at a time. ConvertResult
+**    (program nozzleconv) writes the GNUPlot text of WriteGNUField
+**    from it.
+**
+** Author:   J.L. Klaufus
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "main.h"
+#include "result.h"
+
+#define RESULT_PARAMETERS 23
+#define RESULT_COLUMNS    10
+
+typedef struct
+{
+	char    magic[8];
+	int32_t version;
+	int32_t im;
+	int32_t parameters;
+	int32_t columns;
+	int32_t iteration;
+	int32_t unused;
+	double  residual;
+} tResultHeader;
+
+typedef struct
+{
+	char   name[RESULT_NAME];
+	double value;
+} tResultParameter;
+
+static const char *columnNames[RESULT_COLUMNS] = {"x", "A", "Q1", "Q2", "Q3", "rho", "u", "T", "p", "M"};
+
+/*
+** Function Primitive
+**    Primitive number c (5: rho, 6: u, 7: T, 8: p, 9: M) of a
+**    node, as WriteGNUField computes it.
+*/
+
+static double Primitive(int c, double gamma, double R, double Q1, double Q2, double Q3, double A)
+{
+	double rho, u, e, p;
+
+	rho = Q1/A;
+	u   = Q2/Q1;
+	e   = Q3/A;
+	p   = (e-0.5*rho*u*u)*(gamma-1);
+
+	switch (c)
+	{
+		case 5:  return rho;
+		case 6:  return u;
+		case 7:  return e*(gamma-1)/R;
+		case 8:  return p;
+		default: return u/sqrt(gamma*p/rho);
+	}
+}
+
+/*
+** Function SetParameter
+**    Fills entry n of the parameter table.
+*/
+
+static void SetParameter(tResultParameter *P, int n, const char *name, double value)
+{
+	memset(P[n].name, 0, RESULT_NAME);
+	strncpy(P[n].name, name, RESULT_NAME-1);
+	P[n].value = value;
+}
+
+/*
+** Function WriteResult
+**   Writes the flow field and the settings of a run.
+**
+** In:       char    fileName  = name of the result file
+**           tData   Data      = structure containing all data
+**           tResult Result    = structure containing results
+**           int     iteration = iterations done
+**           double  residual  = normalised residual
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int WriteResult(char *fileName, tData *Data, tResult *Result, int iteration, double residual)
+{
+	int    ret;
+	int    i, j, c, n;
+	size_t im;
+	char   header[RESULT_HEADER];
+	char   names[RESULT_COLUMNS][RESULT_NAME];
+	double buffer[RESULT_BLOCK];
+	double *arrays[5];
+	FILE   *file;
+
+	tResultHeader    H;
+	tResultParameter P[RESULT_PARAMETERS];
+
+	ret = 0;
+	im  = (size_t)Result->im;
+
+	memset(&H, 0, sizeof(H));
+	memcpy(H.magic, RESULT_MAGIC, 8);
+	H.version    = RESULT_VERSION;
+	H.im         = Result->im;
+	H.parameters = RESULT_PARAMETERS;
+	H.columns    = RESULT_COLUMNS;
+	H.iteration  = iteration;
+	H.residual   = residual;
+
+	memset(header, 0, RESULT_HEADER);
+	memcpy(header, &H, sizeof(H));
+
+	n = 0;
+	SetParameter(P, n++, "gamma",          Data->gamma);
+	SetParameter(P, n++, "R",              Data->R);
+	SetParameter(P, n++, "M_start",        Data->M_start);
+	SetParameter(P, n++, "p_start",        Data->p_start);
+	SetParameter(P, n++, "rho_start",      Data->rho_start);
+	SetParameter(P, n++, "u_exit",         Data->u_exit);
+	SetParameter(P, n++, "length",         Data->length);
+	SetParameter(P, n++, "scheme",         Data->scheme);
+	SetParameter(P, n++, "CFL",            Data->CFL);
+	SetParameter(P, n++, "epsilon",        Data->epsilon);
+	SetParameter(P, n++, "kappa",          Data->kappa);
+	SetParameter(P, n++, "im",             Data->im);
+	SetParameter(P, n++, "limiter",        Data->limiter);
+	SetParameter(P, n++, "kernel",         Data->kernel);
+	SetParameter(P, n++, "threads",        Data->threads);
+	SetParameter(P, n++, "timestep",       Data->timeStepping);
+	SetParameter(P, n++, "solver",         Data->solver);
+	SetParameter(P, n++, "integrator",     Data->integrator);
+	SetParameter(P, n++, "irs",            Data->irs);
+	SetParameter(P, n++, "mg_levels",      Data->mgLevels);
+	SetParameter(P, n++, "sequence",       Data->sequence);
+	SetParameter(P, n++, "adapt",          Data->adapt);
+	SetParameter(P, n++, "adapt_strength", Data->adaptStrength);
+
+	memset(names, 0, sizeof(names));
+	for (c=0; c<RESULT_COLUMNS; c++)
+		strncpy(names[c], columnNames[c], RESULT_NAME-1);
+
+	arrays[0] = Result->x;
+	arrays[1] = Result->A;
+	arrays[2] = Result->Q1;
+	arrays[3] = Result->Q2;
+	arrays[4] = Result->Q3;
+
+	file = fopen(fileName, "wb");
+	if (file == NULL)
+		ret = -1;
+
+	if (ret != -1 && (fwrite(header, 1, RESULT_HEADER, file) != RESULT_HEADER ||
+	                  fwrite(P, sizeof(tResultParameter), RESULT_PARAMETERS, file) != RESULT_PARAMETERS ||
+	                  fwrite(names, RESULT_NAME, RESULT_COLUMNS, file) != RESULT_COLUMNS))
+		ret = -1;
+
+	/* The field as it is */
+	for (c=0; c<5 && ret!=-1; c++)
+		if (fwrite(arrays[c], sizeof(double), im, file) != im)
+			ret = -1;
+
+	/* The primitives, a block at a time */
+	for (c=5; c<RESULT_COLUMNS && ret!=-1; c++)
+		for (i=0; i<(int)im && ret!=-1; i+=RESULT_BLOCK)
+		{
+			n = ((int)im - i < RESULT_BLOCK) ? (int)im - i : RESULT_BLOCK;
+
+			for (j=0; j<n; j++)
+				buffer[j] = Primitive(c, Data->gamma, Data->R, Result->Q1[i+j], Result->Q2[i+j], Result->Q3[i+j], Result->A[i+j]);
+
+			if (fwrite(buffer, sizeof(double), n, file) != (size_t)n)
+				ret = -1;
+		}
+
+	if (file && fclose(file) != 0)
+		ret = -1;
+
+	if (ret == -1)
+		fprintf(stderr, "ERROR in function WriteResult: Could not write '%s'.\n", fileName);
+
+	return ret;
+}
+
+/*
+** Function MapResult
+**    Maps a result file into memory and checks its layout.
+**    Returns the mapping, or NULL.
+*/
+
+static void *MapResult(FILE *in, size_t *size)
+{
+	void   *map;
+	size_t offset;
+
+	struct stat st;
+	tResultHeader H;
+
+	map = NULL;
+
+	if (fstat(fileno(in), &st) == 0 && (size_t)st.st_size >= RESULT_HEADER)
+	{
+		*size = (size_t)st.st_size;
+
+		map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fileno(in), 0);
+		if (map == MAP_FAILED)
+			map = NULL;
+	}
+
+	if (map)
+	{
+		memcpy(&H, map, sizeof(H));
+
+		offset = RESULT_HEADER + (size_t)(H.parameters > 0 ? H.parameters : 0)*sizeof(tResultParameter) +
+		         (size_t)(H.columns > 0 ? H.columns : 0)*RESULT_NAME;
+
+		if (memcmp(H.magic, RESULT_MAGIC, 8) != 0 || H.version != RESULT_VERSION || H.im < 1 ||
+		    H.parameters < 0 || H.columns < 0 || *size != offset + (size_t)H.columns*H.im*sizeof(double))
+		{
+			munmap(map, *size);
+			map = NULL;
+		}
+	}
+
+	if (map == NULL)
+		fprintf(stderr, "ERROR in function MapResult: Not a result file of this version.\n");
+
+	return map;
+}
+
+/*
+** Function Column
+**    Start of the column of the given name, or NULL.
+*/
+
+static const double *Column(const void *map, const char *name)
+{
+	int  c;
+	const char *names;
+
+	tResultHeader H;
+
+	memcpy(&H, map, sizeof(H));
+
+	names = (const char*)map + RESULT_HEADER + H.parameters*sizeof(tResultParameter);
+
+	for (c=0; c<H.columns; c++)
+		if (strncmp(names + c*RESULT_NAME, name, RESULT_NAME) == 0)
+			return (const double*)(names + H.columns*RESULT_NAME) + (size_t)c*H.im;
+
+	return NULL;
+}
+
+/*
+** Function ConvertResult
+**    Converts a result file into the GNUPlot text of
+**    WriteGNUField, with 2 decimals or, exact, all digits.
+**
+** In:       FILE in    = opened result file
+**           FILE out   = output stream
+**           int  exact = 1 for all digits
+** Out:      -
+** Return:   number of nodes, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int ConvertResult(FILE *in, FILE *out, int exact)
+{
+	int    i, c, im;
+	size_t size;
+	void   *map;
+	const double *col[7];
+	const char   *format;
+
+	static const char *names[7] = {"x", "A", "rho", "u", "T", "p", "M"};
+
+	map = MapResult(in, &size);
+	if (map == NULL)
+		return -1;
+
+	im = ((tResultHeader*)map)->im;
+
+	for (c=0; c<7 && map; c++)
+	{
+		col[c] = Column(map, names[c]);
+		if (col[c] == NULL)
+		{
+			fprintf(stderr, "ERROR in function ConvertResult: No column '%s'.\n", names[c]);
+			munmap(map, size);
+			map = NULL;
+		}
+	}
+
+	if (map == NULL)
+		return -1;
+
+	format = exact ? "%3d %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n"
+	               : "%3d %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n";
+
+	fprintf(out, "# I          x          A        rho          u          T          p          M\n");
+	for (i=0; i<im; i++)
+		fprintf(out, format, i, col[0][i], col[1][i], col[2][i], col[3][i], col[4][i], col[5][i], col[6][i]);
+
+	munmap(map, size);
+
+	return im;
+}
+
+/*
+** Function ListResult
+**    Lists the header, the parameters and the columns of a
+**    result file.
+**
+** In:       FILE in  = opened result file
+**           FILE out = output stream
+** Out:      -
+** Return:   number of nodes, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int ListResult(FILE *in, FILE *out)
+{
+	int    n;
+	size_t size;
+	void   *map;
+	const char *names;
+
+	tResultHeader    H;
+	tResultParameter P;
+
+	map = MapResult(in, &size);
+	if (map == NULL)
+		return -1;
+
+	memcpy(&H, map, sizeof(H));
+
+	fprintf(out, "im             %d\n", H.im);
+	fprintf(out, "iteration      %d\n", H.iteration);
+	fprintf(out, "residual       %.17g\n", H.residual);
+
+	for (n=0; n<H.parameters; n++)
+	{
+		memcpy(&P, (char*)map + RESULT_HEADER + n*sizeof(tResultParameter), sizeof(P));
+		P.name[RESULT_NAME-1] = '\0';
+
+		fprintf(out, "%-14s %.17g\n", P.name, P.value);
+	}
+
+	names = (const char*)map + RESULT_HEADER + H.parameters*sizeof(tResultParameter);
+
+	fprintf(out, "columns       ");
+	for (n=0; n<H.columns; n++)
+		fprintf(out, " %.*s", RESULT_NAME, names + n*RESULT_NAME);
+	fprintf(out, "\n");
+
+	munmap(map, size);
+
+	return H.im;
+}
@@ -0,0 +1,27 @@
+/*
+** Header-file for Result
+*/
+
+#ifndef RESULT_H
+#define RESULT_H
+
+#define RESULT_MAGIC   "NZRESLT\0"
+#define RESULT_VERSION 1
+
+/* Size of the header; the parameters follow at this offset */
+#define RESULT_HEADER  64
+
+/* Length of the name of a parameter or a column */
+#define RESULT_NAME    16
+
+/* Values computed and written at a time */
+#define RESULT_BLOCK   8192
+
+/* Name of the result of a run */
+#define RESULT_FILE    "nozzle.res"
+
+int WriteResult(char*, tData*, tResult*, int, double);
+int ConvertResult(FILE*, FILE*, int);
+int ListResult(FILE*, FILE*);
+
+#endif
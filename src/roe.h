@@ -12,6 +12,127 @@ typedef struct
 	double Q3;
 } tConservative;
 
-int Roe(FILE*, tData*, tResult*, double*);
+/* Roe's scheme, one variant per reconstruction */
+int RoeConstant(tData*, tResult*, double*);
+int RoeVanLeer(tData*, tResult*, double*);
+int RoeVanAlbada(tData*, tResult*, double*);
+int RoeKappa(tData*, tResult*, double*);
+
+/* The same with the interface flux of the data-file (see flux.h) */
+int FluxConstant(tData*, tResult*, double*);
+int FluxVanLeer(tData*, tResult*, double*);
+int FluxVanAlbada(tData*, tResult*, double*);
+int FluxKappa(tData*, tResult*, double*);
+
+/*
+** Function RoeFlux
+**    Calculates the averaged flux through one interface using
+**    Roe's approximate Riemann solver with the entropy fix by
+**    Harten and Hyman.
+**
+** In:       double        gamma   = constant
+**           double        epsilon = threshold of the entropy fix
+**           tConservative left    = left conservative variables
+**           tConservative right   = right conservative variables
+**           double        E_l     = flux vector in node left of interface
+**           double        E_r     = flux vector in node right of interface
+** Out:      double        E_tilde = averaged flux through interface
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline void RoeFlux(double gamma, double epsilon, const tConservative *left, const tConservative *right,
+                           const double *E_l, const double *E_r, double *E_tilde)
+{
+	double rho_l, rho_r;
+	double u_l, u_r;
+	double Et_l, Et_r;
+	double p_l, p_r;
+	double H_l, H_r;
+	double R;
+	double rho_tilde, u_tilde, H_tilde, a_tilde;
+	double rhoDelta, uDelta, pDelta;
+	double alpha_1, alpha_2, alpha_3;
+	double lambda_tilde_1, lambda_tilde_2, lambda_tilde_3;
+	double R1_tilde[3], R2_tilde[3], R3_tilde[3];
+
+	/* Decode the primitives */
+	rho_l  = left->Q1;
+	rho_r  = right->Q1;
+
+	u_l    = left->Q2/left->Q1;
+	u_r    = right->Q2/right->Q1;
+
+	Et_l   = left->Q3;
+	Et_r   = right->Q3;
+
+	p_l    = (Et_l - 0.5*rho_l*u_l*u_l)*(gamma-1);
+	p_r    = (Et_r - 0.5*rho_r*u_r*u_r)*(gamma-1);
+
+	H_l    = (Et_l + p_l)/rho_l;
+	H_r    = (Et_r + p_r)/rho_r;
+
+	/* Calculate Roe averaged values */
+	R         = sqrt(rho_r/rho_l);
+	rho_tilde = R*rho_l;
+	u_tilde   = (u_l + R*u_r)/(1+R);
+	H_tilde   = (H_l + R*H_r)/(1+R);
+	a_tilde   = sqrt((gamma-1)*(H_tilde - 0.5*u_tilde*u_tilde));
+
+	/* Calculate deltas */
+	rhoDelta = rho_r - rho_l;
+	uDelta   = u_r   - u_l;
+	pDelta   = p_r   - p_l;
+
+	/* Calculate wave strengths */
+	alpha_1  = (pDelta - rho_tilde*a_tilde*uDelta)/(2*a_tilde*a_tilde);
+	alpha_2  = rhoDelta - pDelta/(a_tilde*a_tilde);
+	alpha_3  = (pDelta + rho_tilde*a_tilde*uDelta)/(2*a_tilde*a_tilde);
+
+	/* Calculate averaged eigenvalues */
+	lambda_tilde_1 = fabs(u_tilde - a_tilde);
+	lambda_tilde_2 = fabs(u_tilde);
+	lambda_tilde_3 = fabs(u_tilde + a_tilde);
+
+	/* Entropy fix by Harten and Hyman */
+	if (lambda_tilde_1 < epsilon)
+		lambda_tilde_1 = 0.5*(lambda_tilde_1/epsilon + epsilon);
+
+	if (lambda_tilde_2 < epsilon)
+		lambda_tilde_2 = 0.5*(lambda_tilde_2/epsilon + epsilon);
+
+	if (lambda_tilde_3 < epsilon)
+		lambda_tilde_3 = 0.5*(lambda_tilde_3/epsilon + epsilon);
+
+	/* Calculate averaged eigenvectors */
+	R1_tilde[0] = 1.0;
+	R1_tilde[1] = u_tilde - a_tilde;
+	R1_tilde[2] = H_tilde - u_tilde*a_tilde;
+
+	R2_tilde[0] = 1.0;
+	R2_tilde[1] = u_tilde;
+	R2_tilde[2] = 0.5*u_tilde*u_tilde;
+
+	R3_tilde[0] = 1.0;
+	R3_tilde[1] = u_tilde + a_tilde;
+	R3_tilde[2] = H_tilde + u_tilde*a_tilde;
+
+	/* Calculate averaged flux through interface */
+	E_tilde[0] = 0.5*(E_l[0]+E_r[0]) - 
+	             0.5*(alpha_1*lambda_tilde_1*R1_tilde[0] + 
+	                  alpha_2*lambda_tilde_2*R2_tilde[0] + 
+	                  alpha_3*lambda_tilde_3*R3_tilde[0]);
+
+	E_tilde[1] = 0.5*(E_l[1]+E_r[1]) - 
+	             0.5*(alpha_1*lambda_tilde_1*R1_tilde[1] + 
+	                  alpha_2*lambda_tilde_2*R2_tilde[1] + 
+	                  alpha_3*lambda_tilde_3*R3_tilde[1]);
+
+	E_tilde[2] = 0.5*(E_l[2]+E_r[2]) - 
+	             0.5*(alpha_1*lambda_tilde_1*R1_tilde[2] + 
+	                  alpha_2*lambda_tilde_2*R2_tilde[2] + 
+	                  alpha_3*lambda_tilde_3*R3_tilde[2]);
+}
 
 #endif
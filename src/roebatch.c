@@ -0,0 +1,584 @@
+/*
+** Function RoeBatch
+**    Roe's approximate Riemann solver in three passes over the
+**    grid, so that the interface fluxes can be computed in
+**    SIMD registers:
+**
+**      1. the left and right states of all interfaces are
+**         collected in structure-of-arrays buffers,
+**      2. the fluxes through all interfaces are computed in
+**         batches of 4 (AVX2) or 8 (AVX-512) interfaces,
+**      3. the conservative update is applied.
+**
+**    As all fluxes are computed from the old Q, the update is a
+**    Jacobi update. For the first order scheme this equals the
+**    in-place update of Roe; with MUSCL the left state of an
+**    interface no longer sees the already updated node i-1.
+**
+**    Pass 1 is compiled once per reconstruction; the variants
+**    are RoeBatchConstant, RoeBatchVanLeer, RoeBatchVanAlbada
+**    and RoeBatchKappa.
+**
+**    The instruction set is chosen at runtime from the CPUID
+**    flags (or forced with 'isa' in the data-file). The vector
+**    kernels evaluate exactly the same operations in the same
+**    order as RoeFlux, without fused multiply-add, so the fluxes
+**    match the scalar kernel to within ROEBATCH_MAXULP units in
+**    the last place.
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results
+**           double  residual = residual for convergence testing
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "main.h"
+#include "norms.h"
+#include "roe.h"
+#include "roebatch.h"
+#include "schemes.h"
+#include "trace.h"
+
+/*
+** Function RoeFluxScalar
+**    Reference kernel; calls RoeFlux for every interface.
+*/
+
+static void RoeFluxScalar(int n, double gamma, double epsilon,
+                          double *L1, double *L2, double *L3, double *R1, double *R2, double *R3,
+                          double *E1, double *E2, double *E3, double *F1, double *F2, double *F3)
+{
+	int i;
+	tConservative left, right;
+	double E_l[3], E_r[3], F[3];
+
+	for (i=0; i<n; i++)
+	{
+		left.Q1  = L1[i]; left.Q2  = L2[i]; left.Q3  = L3[i];
+		right.Q1 = R1[i]; right.Q2 = R2[i]; right.Q3 = R3[i];
+
+		E_l[0] = E1[i];   E_l[1] = E2[i];   E_l[2] = E3[i];
+		E_r[0] = E1[i+1]; E_r[1] = E2[i+1]; E_r[2] = E3[i+1];
+
+		RoeFlux(gamma, epsilon, &left, &right, E_l, E_r, F);
+
+		F1[i] = F[0];
+		F2[i] = F[1];
+		F3[i] = F[2];
+	}
+}
+
+#ifdef HAVE_X86_SIMD
+
+/*
+** Function RoeFluxAVX2
+**    RoeFlux on 4 interfaces per instruction.
+*/
+
+__attribute__((target("avx2")))
+static void RoeFluxAVX2(int n, double gamma, double epsilon,
+                        double *L1, double *L2, double *L3, double *R1, double *R2, double *R3,
+                        double *E1, double *E2, double *E3, double *F1, double *F2, double *F3)
+{
+	int     i;
+	__m256d half, one, two, gm1, eps, sign;
+	__m256d rho_l, rho_r, u_l, u_r, Et_l, Et_r, p_l, p_r, H_l, H_r;
+	__m256d R, rho_tilde, u_tilde, H_tilde, a_tilde, a2;
+	__m256d rhoDelta, uDelta, pDelta, rau;
+	__m256d alpha_1, alpha_2, alpha_3;
+	__m256d lambda_1, lambda_2, lambda_3, fix;
+	__m256d w1, w2, w3, ua;
+
+	half = _mm256_set1_pd(0.5);
+	one  = _mm256_set1_pd(1.0);
+	two  = _mm256_set1_pd(2.0);
+	gm1  = _mm256_set1_pd(gamma-1);
+	eps  = _mm256_set1_pd(epsilon);
+	sign = _mm256_set1_pd(-0.0);
+
+	for (i=0; i+4<=n; i+=4)
+	{
+		/* Decode the primitives */
+		rho_l = _mm256_loadu_pd(L1+i);
+		rho_r = _mm256_loadu_pd(R1+i);
+		u_l   = _mm256_div_pd(_mm256_loadu_pd(L2+i), rho_l);
+		u_r   = _mm256_div_pd(_mm256_loadu_pd(R2+i), rho_r);
+		Et_l  = _mm256_loadu_pd(L3+i);
+		Et_r  = _mm256_loadu_pd(R3+i);
+
+		p_l   = _mm256_mul_pd(_mm256_sub_pd(Et_l, _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(half, rho_l), u_l), u_l)), gm1);
+		p_r   = _mm256_mul_pd(_mm256_sub_pd(Et_r, _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(half, rho_r), u_r), u_r)), gm1);
+
+		H_l   = _mm256_div_pd(_mm256_add_pd(Et_l, p_l), rho_l);
+		H_r   = _mm256_div_pd(_mm256_add_pd(Et_r, p_r), rho_r);
+
+		/* Calculate Roe averaged values */
+		R         = _mm256_sqrt_pd(_mm256_div_pd(rho_r, rho_l));
+		rho_tilde = _mm256_mul_pd(R, rho_l);
+		u_tilde   = _mm256_div_pd(_mm256_add_pd(u_l, _mm256_mul_pd(R, u_r)), _mm256_add_pd(one, R));
+		H_tilde   = _mm256_div_pd(_mm256_add_pd(H_l, _mm256_mul_pd(R, H_r)), _mm256_add_pd(one, R));
+		a_tilde   = _mm256_sqrt_pd(_mm256_mul_pd(gm1, _mm256_sub_pd(H_tilde, _mm256_mul_pd(_mm256_mul_pd(half, u_tilde), u_tilde))));
+
+		/* Calculate deltas */
+		rhoDelta  = _mm256_sub_pd(rho_r, rho_l);
+		uDelta    = _mm256_sub_pd(u_r, u_l);
+		pDelta    = _mm256_sub_pd(p_r, p_l);
+
+		/* Calculate wave strengths */
+		a2        = _mm256_mul_pd(_mm256_mul_pd(two, a_tilde), a_tilde);
+		rau       = _mm256_mul_pd(_mm256_mul_pd(rho_tilde, a_tilde), uDelta);
+		alpha_1   = _mm256_div_pd(_mm256_sub_pd(pDelta, rau), a2);
+		alpha_2   = _mm256_sub_pd(rhoDelta, _mm256_div_pd(pDelta, _mm256_mul_pd(a_tilde, a_tilde)));
+		alpha_3   = _mm256_div_pd(_mm256_add_pd(pDelta, rau), a2);
+
+		/* Calculate averaged eigenvalues */
+		lambda_1  = _mm256_andnot_pd(sign, _mm256_sub_pd(u_tilde, a_tilde));
+		lambda_2  = _mm256_andnot_pd(sign, u_tilde);
+		lambda_3  = _mm256_andnot_pd(sign, _mm256_add_pd(u_tilde, a_tilde));
+
+		/* Entropy fix by Harten and Hyman */
+		fix       = _mm256_mul_pd(half, _mm256_add_pd(_mm256_div_pd(lambda_1, eps), eps));
+		lambda_1  = _mm256_blendv_pd(lambda_1, fix, _mm256_cmp_pd(lambda_1, eps, _CMP_LT_OQ));
+		fix       = _mm256_mul_pd(half, _mm256_add_pd(_mm256_div_pd(lambda_2, eps), eps));
+		lambda_2  = _mm256_blendv_pd(lambda_2, fix, _mm256_cmp_pd(lambda_2, eps, _CMP_LT_OQ));
+		fix       = _mm256_mul_pd(half, _mm256_add_pd(_mm256_div_pd(lambda_3, eps), eps));
+		lambda_3  = _mm256_blendv_pd(lambda_3, fix, _mm256_cmp_pd(lambda_3, eps, _CMP_LT_OQ));
+
+		/* Wave weights */
+		w1        = _mm256_mul_pd(alpha_1, lambda_1);
+		w2        = _mm256_mul_pd(alpha_2, lambda_2);
+		w3        = _mm256_mul_pd(alpha_3, lambda_3);
+		ua        = _mm256_mul_pd(u_tilde, a_tilde);
+
+		/* Calculate averaged flux through interface; eigenvectors inline */
+		_mm256_storeu_pd(F1+i, _mm256_sub_pd(
+			_mm256_mul_pd(half, _mm256_add_pd(_mm256_loadu_pd(E1+i), _mm256_loadu_pd(E1+i+1))),
+			_mm256_mul_pd(half, _mm256_add_pd(_mm256_add_pd(w1, w2), w3))));
+
+		_mm256_storeu_pd(F2+i, _mm256_sub_pd(
+			_mm256_mul_pd(half, _mm256_add_pd(_mm256_loadu_pd(E2+i), _mm256_loadu_pd(E2+i+1))),
+			_mm256_mul_pd(half, _mm256_add_pd(_mm256_add_pd(
+				_mm256_mul_pd(w1, _mm256_sub_pd(u_tilde, a_tilde)),
+				_mm256_mul_pd(w2, u_tilde)),
+				_mm256_mul_pd(w3, _mm256_add_pd(u_tilde, a_tilde))))));
+
+		_mm256_storeu_pd(F3+i, _mm256_sub_pd(
+			_mm256_mul_pd(half, _mm256_add_pd(_mm256_loadu_pd(E3+i), _mm256_loadu_pd(E3+i+1))),
+			_mm256_mul_pd(half, _mm256_add_pd(_mm256_add_pd(
+				_mm256_mul_pd(w1, _mm256_sub_pd(H_tilde, ua)),
+				_mm256_mul_pd(w2, _mm256_mul_pd(_mm256_mul_pd(half, u_tilde), u_tilde))),
+				_mm256_mul_pd(w3, _mm256_add_pd(H_tilde, ua))))));
+	}
+
+	/* Remaining interfaces */
+	RoeFluxScalar(n-i, gamma, epsilon, L1+i, L2+i, L3+i, R1+i, R2+i, R3+i, E1+i, E2+i, E3+i, F1+i, F2+i, F3+i);
+}
+
+/*
+** Function RoeFluxAVX512
+**    RoeFlux on 8 interfaces per instruction.
+*/
+
+__attribute__((target("avx512f")))
+static void RoeFluxAVX512(int n, double gamma, double epsilon,
+                          double *L1, double *L2, double *L3, double *R1, double *R2, double *R3,
+                          double *E1, double *E2, double *E3, double *F1, double *F2, double *F3)
+{
+	int     i;
+	__m512d half, one, two, gm1, eps;
+	__m512d rho_l, rho_r, u_l, u_r, Et_l, Et_r, p_l, p_r, H_l, H_r;
+	__m512d R, rho_tilde, u_tilde, H_tilde, a_tilde, a2;
+	__m512d rhoDelta, uDelta, pDelta, rau;
+	__m512d alpha_1, alpha_2, alpha_3;
+	__m512d lambda_1, lambda_2, lambda_3, fix;
+	__m512d w1, w2, w3, ua;
+
+	half = _mm512_set1_pd(0.5);
+	one  = _mm512_set1_pd(1.0);
+	two  = _mm512_set1_pd(2.0);
+	gm1  = _mm512_set1_pd(gamma-1);
+	eps  = _mm512_set1_pd(epsilon);
+
+	for (i=0; i+8<=n; i+=8)
+	{
+		/* Decode the primitives */
+		rho_l = _mm512_loadu_pd(L1+i);
+		rho_r = _mm512_loadu_pd(R1+i);
+		u_l   = _mm512_div_pd(_mm512_loadu_pd(L2+i), rho_l);
+		u_r   = _mm512_div_pd(_mm512_loadu_pd(R2+i), rho_r);
+		Et_l  = _mm512_loadu_pd(L3+i);
+		Et_r  = _mm512_loadu_pd(R3+i);
+
+		p_l   = _mm512_mul_pd(_mm512_sub_pd(Et_l, _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(half, rho_l), u_l), u_l)), gm1);
+		p_r   = _mm512_mul_pd(_mm512_sub_pd(Et_r, _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(half, rho_r), u_r), u_r)), gm1);
+
+		H_l   = _mm512_div_pd(_mm512_add_pd(Et_l, p_l), rho_l);
+		H_r   = _mm512_div_pd(_mm512_add_pd(Et_r, p_r), rho_r);
+
+		/* Calculate Roe averaged values */
+		R         = _mm512_sqrt_pd(_mm512_div_pd(rho_r, rho_l));
+		rho_tilde = _mm512_mul_pd(R, rho_l);
+		u_tilde   = _mm512_div_pd(_mm512_add_pd(u_l, _mm512_mul_pd(R, u_r)), _mm512_add_pd(one, R));
+		H_tilde   = _mm512_div_pd(_mm512_add_pd(H_l, _mm512_mul_pd(R, H_r)), _mm512_add_pd(one, R));
+		a_tilde   = _mm512_sqrt_pd(_mm512_mul_pd(gm1, _mm512_sub_pd(H_tilde, _mm512_mul_pd(_mm512_mul_pd(half, u_tilde), u_tilde))));
+
+		/* Calculate deltas */
+		rhoDelta  = _mm512_sub_pd(rho_r, rho_l);
+		uDelta    = _mm512_sub_pd(u_r, u_l);
+		pDelta    = _mm512_sub_pd(p_r, p_l);
+
+		/* Calculate wave strengths */
+		a2        = _mm512_mul_pd(_mm512_mul_pd(two, a_tilde), a_tilde);
+		rau       = _mm512_mul_pd(_mm512_mul_pd(rho_tilde, a_tilde), uDelta);
+		alpha_1   = _mm512_div_pd(_mm512_sub_pd(pDelta, rau), a2);
+		alpha_2   = _mm512_sub_pd(rhoDelta, _mm512_div_pd(pDelta, _mm512_mul_pd(a_tilde, a_tilde)));
+		alpha_3   = _mm512_div_pd(_mm512_add_pd(pDelta, rau), a2);
+
+		/* Calculate averaged eigenvalues */
+		lambda_1  = _mm512_abs_pd(_mm512_sub_pd(u_tilde, a_tilde));
+		lambda_2  = _mm512_abs_pd(u_tilde);
+		lambda_3  = _mm512_abs_pd(_mm512_add_pd(u_tilde, a_tilde));
+
+		/* Entropy fix by Harten and Hyman */
+		fix       = _mm512_mul_pd(half, _mm512_add_pd(_mm512_div_pd(lambda_1, eps), eps));
+		lambda_1  = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(lambda_1, eps, _CMP_LT_OQ), lambda_1, fix);
+		fix       = _mm512_mul_pd(half, _mm512_add_pd(_mm512_div_pd(lambda_2, eps), eps));
+		lambda_2  = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(lambda_2, eps, _CMP_LT_OQ), lambda_2, fix);
+		fix       = _mm512_mul_pd(half, _mm512_add_pd(_mm512_div_pd(lambda_3, eps), eps));
+		lambda_3  = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(lambda_3, eps, _CMP_LT_OQ), lambda_3, fix);
+
+		/* Wave weights */
+		w1        = _mm512_mul_pd(alpha_1, lambda_1);
+		w2        = _mm512_mul_pd(alpha_2, lambda_2);
+		w3        = _mm512_mul_pd(alpha_3, lambda_3);
+		ua        = _mm512_mul_pd(u_tilde, a_tilde);
+
+		/* Calculate averaged flux through interface; eigenvectors inline */
+		_mm512_storeu_pd(F1+i, _mm512_sub_pd(
+			_mm512_mul_pd(half, _mm512_add_pd(_mm512_loadu_pd(E1+i), _mm512_loadu_pd(E1+i+1))),
+			_mm512_mul_pd(half, _mm512_add_pd(_mm512_add_pd(w1, w2), w3))));
+
+		_mm512_storeu_pd(F2+i, _mm512_sub_pd(
+			_mm512_mul_pd(half, _mm512_add_pd(_mm512_loadu_pd(E2+i), _mm512_loadu_pd(E2+i+1))),
+			_mm512_mul_pd(half, _mm512_add_pd(_mm512_add_pd(
+				_mm512_mul_pd(w1, _mm512_sub_pd(u_tilde, a_tilde)),
+				_mm512_mul_pd(w2, u_tilde)),
+				_mm512_mul_pd(w3, _mm512_add_pd(u_tilde, a_tilde))))));
+
+		_mm512_storeu_pd(F3+i, _mm512_sub_pd(
+			_mm512_mul_pd(half, _mm512_add_pd(_mm512_loadu_pd(E3+i), _mm512_loadu_pd(E3+i+1))),
+			_mm512_mul_pd(half, _mm512_add_pd(_mm512_add_pd(
+				_mm512_mul_pd(w1, _mm512_sub_pd(H_tilde, ua)),
+				_mm512_mul_pd(w2, _mm512_mul_pd(_mm512_mul_pd(half, u_tilde), u_tilde))),
+				_mm512_mul_pd(w3, _mm512_add_pd(H_tilde, ua))))));
+	}
+
+	/* Remaining interfaces */
+	RoeFluxScalar(n-i, gamma, epsilon, L1+i, L2+i, L3+i, R1+i, R2+i, R3+i, E1+i, E2+i, E3+i, F1+i, F2+i, F3+i);
+}
+
+#endif
+
+
+/*
+** Function ResolveISA
+**    Chooses the instruction set for the batched Roe flux.
+**
+** In:       int isa = requested instruction set (ISA_AUTO: best available)
+** Out:      -
+** Return:   instruction set that will be used
+**
+** Author:   J.L. Klaufus
+*/
+
+int ResolveISA(int isa)
+{
+#ifdef HAVE_X86_SIMD
+	int avx2, avx512;
+
+	__builtin_cpu_init();
+	avx2   = __builtin_cpu_supports("avx2");
+	avx512 = __builtin_cpu_supports("avx512f");
+
+	if (isa == ISA_AUTO)
+		isa = avx512 ? ISA_AVX512 : (avx2 ? ISA_AVX2 : ISA_SCALAR);
+
+	if (isa == ISA_AVX512 && !avx512)
+		isa = avx2 ? ISA_AVX2 : ISA_SCALAR;
+
+	if (isa == ISA_AVX2 && !avx2)
+		isa = ISA_SCALAR;
+#else
+	isa = ISA_SCALAR;
+#endif
+
+	return isa;
+}
+
+/*
+** Function ISAName
+**    Returns the name of an instruction set as used in the data-file.
+*/
+
+char *ISAName(int isa)
+{
+	switch (isa)
+	{
+		case ISA_AUTO:   return "auto";
+		case ISA_AVX2:   return "avx2";
+		case ISA_AVX512: return "avx512";
+		default:         return "scalar";
+	}
+}
+
+/*
+** Function RoeFluxBatch
+**    Calculates the Roe fluxes through n interfaces. Interface i
+**    lies between the left state L[i] and the right state R[i];
+**    the node fluxes left and right of it are E[i] and E[i+1].
+**
+** In:       int    isa      = instruction set (resolved)
+**           int    n        = number of interfaces
+**           double gamma    = constant
+**           double epsilon  = threshold of the entropy fix
+**           double L1..L3   = left states
+**           double R1..R3   = right states
+**           double E1..E3   = node fluxes (n+1 values)
+** Out:      double F1..F3   = interface fluxes
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void RoeFluxBatch(int isa, int n, double gamma, double epsilon,
+                  double *L1, double *L2, double *L3, double *R1, double *R2, double *R3,
+                  double *E1, double *E2, double *E3, double *F1, double *F2, double *F3)
+{
+#ifdef HAVE_X86_SIMD
+	if (isa == ISA_AVX512)
+		RoeFluxAVX512(n, gamma, epsilon, L1, L2, L3, R1, R2, R3, E1, E2, E3, F1, F2, F3);
+	else if (isa == ISA_AVX2)
+		RoeFluxAVX2(n, gamma, epsilon, L1, L2, L3, R1, R2, R3, E1, E2, E3, F1, F2, F3);
+	else
+#endif
+		RoeFluxScalar(n, gamma, epsilon, L1, L2, L3, R1, R2, R3, E1, E2, E3, F1, F2, F3);
+}
+
+/*
+** Function States
+**    Pass 1: collects the left and right states of all interfaces.
+**    The first order states are the nodes themselves, so no
+**    copies are made for RECON_CONSTANT.
+*/
+
+__attribute__((always_inline))
+static inline void States(tData *Data, tResult *Result, double **L, double **R, const int recon)
+{
+	int i;
+	tConservative left, right;
+
+	if (recon == RECON_CONSTANT)
+	{
+		L[0] = Result->Q1;   L[1] = Result->Q2;   L[2] = Result->Q3;
+		R[0] = Result->Q1+1; R[1] = Result->Q2+1; R[2] = Result->Q3+1;
+	}
+	else
+	{
+		L[0] = Result->scratch[0]; L[1] = Result->scratch[1]; L[2] = Result->scratch[2];
+		R[0] = Result->scratch[3]; R[1] = Result->scratch[4]; R[2] = Result->scratch[5];
+
+		for (i=0; i<Data->im-1; i++)
+		{
+			Reconstruct(recon, Data->gamma, Data->kappa, Data->im, Result->Q1, Result->Q2, Result->Q3, i,
+			            &left, &right);
+
+			L[0][i] = left.Q1;  L[1][i] = left.Q2;  L[2][i] = left.Q3;
+			R[0][i] = right.Q1; R[1][i] = right.Q2; R[2][i] = right.Q3;
+		}
+	}
+}
+
+__attribute__((always_inline))
+static inline int RoeBatch(tData *Data, tResult *Result, double *residual, const int recon)
+{
+	int ret;
+	int i, im;
+
+	double timeStep, tau;
+	double rhoBefore, rhoAfter, Q2Before, Q3Before;
+	double *norms;
+
+	double *L[3], *R[3];
+	double *F1, *F2, *F3;
+
+	ret = 0;
+
+	if (Result->nScratch < ROEBATCH_SCRATCH)
+	{
+		fprintf(stderr, "ERROR in function RoeBatch: No workspace allocated.\n");
+		return -1;
+	}
+
+	im       = Data->im;
+	timeStep = Result->timeStep;
+
+	F1 = Result->scratch[6];
+	F2 = Result->scratch[7];
+	F3 = Result->scratch[8];
+
+	/* Pass 1: interface states */
+	States(Data, Result, L, R, recon);
+
+	/* Pass 2: interface fluxes */
+	RoeFluxBatch(Result->isa, im-1, Data->gamma, Data->epsilon, L[0], L[1], L[2], R[0], R[1], R[2],
+	             Result->E1, Result->E2, Result->E3, F1, F2, F3);
+
+	/* Pass 3: conservative update of the inner field */
+	*residual = 0;
+	ClearNorms(Result->norms);
+	norms     = Result->monitor ? Result->norms : NULL;
+	for (i=1; i<im-1 && ret!=-1; i++)
+	{
+		/* Use density for residual calculation */
+		rhoBefore = Result->Q1[i]*Result->invA[i];
+		Q2Before  = Result->Q2[i];
+		Q3Before  = Result->Q3[i];
+
+		/* Local time stepping: the timestep of the node */
+		if (Result->dt)
+			timeStep = Result->dt[i];
+
+		tau = timeStep/Result->dx[i];
+		Result->Q1[i] += -tau*(F1[i] - F1[i-1]);
+		Result->Q2[i] += -tau*(F2[i] - F2[i-1]) + timeStep*Result->H2[i];
+		Result->Q3[i] += -tau*(F3[i] - F3[i-1]);
+
+		/* Calculate the residual and the norms */
+		rhoAfter    = Result->Q1[i]*Result->invA[i];
+		*residual  += AddNorms(norms, (rhoAfter-rhoBefore)/timeStep,
+		                       Result->Q2[i]-Q2Before, Result->Q3[i]-Q3Before, Result->invA[i]/timeStep);
+	}
+
+	/* Trace the new field */
+	if (TRACE_ON(TRACE_SOLVER, TRACE_CELL))
+		for (i=0; i<im; i++)
+			TRACE(TRACE_SOLVER, TRACE_CELL, TRACE_EV_FIELD, i, Result->Q1[i], Result->Q2[i], Result->Q3[i], 0);
+
+	return ret;
+}
+
+int RoeBatchConstant(tData *Data, tResult *Result, double *residual)
+{
+	return RoeBatch(Data, Result, residual, RECON_CONSTANT);
+}
+
+int RoeBatchVanLeer(tData *Data, tResult *Result, double *residual)
+{
+	return RoeBatch(Data, Result, residual, RECON_VANLEER);
+}
+
+int RoeBatchVanAlbada(tData *Data, tResult *Result, double *residual)
+{
+	return RoeBatch(Data, Result, residual, RECON_VANALBADA);
+}
+
+int RoeBatchKappa(tData *Data, tResult *Result, double *residual)
+{
+	return RoeBatch(Data, Result, residual, RECON_KAPPA);
+}
+
+/*
+** Function Ulps
+**    Distance between two doubles in units in the last place.
+*/
+
+static double Ulps(double a, double b)
+{
+	long long ia, ib;
+
+	if (a == b)
+		return 0;
+
+	if (isnan(a) || isnan(b))
+		return isnan(a) && isnan(b) ? 0 : 1e300;
+
+	memcpy(&ia, &a, sizeof(ia));
+	memcpy(&ib, &b, sizeof(ib));
+
+	/* Map the sign-magnitude representation onto a monotonic integer scale */
+	if (ia < 0) ia = (long long)0x8000000000000000ULL - ia;
+	if (ib < 0) ib = (long long)0x8000000000000000ULL - ib;
+
+	return fabs((double)ia - (double)ib);
+}
+
+/*
+** Function RoeBatchCheck
+**    Compares the batched Roe flux of the resolved instruction
+**    set with the scalar RoeFlux for the interface states of
+**    the current field. CalcEH must have been called.
+**
+** In:       tData   Data   = structure containing all data
+**           tResult Result = structure containing results
+** Out:      -
+** Return:   largest difference in units in the last place,
+**           -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+double RoeBatchCheck(tData *Data, tResult *Result)
+{
+	int    i, k, n;
+	double maxUlp, ulp;
+	double *L[3], *R[3];
+	double *F[3];
+	double Fs[3];
+	double E_l[3], E_r[3];
+	tConservative left, right;
+
+	if (Result->nScratch < ROEBATCH_SCRATCH)
+		return -1;
+
+	States(Data, Result, L, R, Result->recon);
+
+	n    = Data->im-1;
+	F[0] = Result->scratch[6];
+	F[1] = Result->scratch[7];
+	F[2] = Result->scratch[8];
+
+	RoeFluxBatch(Result->isa, n, Data->gamma, Data->epsilon, L[0], L[1], L[2], R[0], R[1], R[2],
+	             Result->E1, Result->E2, Result->E3, F[0], F[1], F[2]);
+
+	maxUlp = 0;
+	for (i=0; i<n; i++)
+	{
+		left.Q1  = L[0][i]; left.Q2  = L[1][i]; left.Q3  = L[2][i];
+		right.Q1 = R[0][i]; right.Q2 = R[1][i]; right.Q3 = R[2][i];
+
+		E_l[0] = Result->E1[i];   E_l[1] = Result->E2[i];   E_l[2] = Result->E3[i];
+		E_r[0] = Result->E1[i+1]; E_r[1] = Result->E2[i+1]; E_r[2] = Result->E3[i+1];
+
+		RoeFlux(Data->gamma, Data->epsilon, &left, &right, E_l, E_r, Fs);
+
+		for (k=0; k<3; k++)
+		{
+			ulp = Ulps(F[k][i], Fs[k]);
+			if (ulp > maxUlp)
+				maxUlp = ulp;
+		}
+	}
+
+	return maxUlp;
+}
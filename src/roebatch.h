@@ -0,0 +1,25 @@
+/*
+** Header-file for RoeBatch
+*/
+
+#ifndef ROEBATCH_H
+#define ROEBATCH_H
+
+/* Number of scratch arrays used by RoeBatch: left, right and flux vectors */
+#define ROEBATCH_SCRATCH 9
+
+/* Maximum difference in units in the last place with the scalar RoeFlux */
+#define ROEBATCH_MAXULP  0
+
+int    ResolveISA(int);
+char  *ISAName(int);
+int    RoeBatchConstant(tData*, tResult*, double*);
+int    RoeBatchVanLeer(tData*, tResult*, double*);
+int    RoeBatchVanAlbada(tData*, tResult*, double*);
+int    RoeBatchKappa(tData*, tResult*, double*);
+void   RoeFluxBatch(int, int, double, double,
+                    double*, double*, double*, double*, double*, double*,
+                    double*, double*, double*, double*, double*, double*);
+double RoeBatchCheck(tData*, tResult*);
+
+#endif
@@ -1,14 +1,228 @@
 /*
 ** Header-file for Schemes
+**
+**   The reconstructions are inline, so every solver can be
+**   compiled into variants in which the reconstruction and the
+**   limiter are constants (see Reconstruction).
 */
 
 #ifndef SCHEMES_H
 #define SCHEMES_H
 
-int    Constant(FILE*, tResult*, int, tConservative*, tConservative*);
-int    Muscl(FILE*, tData*, tResult*, int, tConservative*, tConservative*);
-double VanLeer(double);
-double VanAlbada(double);
-double KappaScheme(double, double);
+/* Reconstructions of the interface states */
+#define RECON_CONSTANT  0
+#define RECON_VANLEER   1
+#define RECON_VANALBADA 2
+#define RECON_KAPPA     3
+#define NRECON          4
+
+int    Reconstruction(tData*);
+char  *ReconstructionName(int);
+
+/*
+** Function VanLeer
+**   Functions as a limiter to the MUSCL-scheme.
+** 
+**   In:      double r      = the ratio of the consecutive gradients.
+**   Out:     -
+**   Return:  double psi    = limiter function
+**
+**   Author:  J.L. Klaufus
+*/
+
+static inline double VanLeer(double r)
+{
+	return (r + fabs(r))/(fabs(r) + 1);
+}
+
+/*
+** Function VanAlbada
+**   Functions as a limiter to the MUSCL-scheme.
+** 
+**   In:      double r      = the ratio of the consecutive gradients.
+**   Out:     -
+**   Return:  double psi    = limiter function
+**
+**   Author:  J.L. Klaufus
+*/
+
+static inline double VanAlbada(double r)
+{
+	return (r*r + r)/(r*r + 1);
+}
+
+/*
+** Function KappaScheme
+**   Functions as a limiter to the MUSCL-scheme.
+** 
+**   In:      double r      = the ratio of the consecutive gradients.
+**            double kappa  = value for kappa
+**   Out:     -
+**   Return:  double psi    = limiter function
+**
+**   Author:  J.L. Klaufus
+*/
+
+static inline double KappaScheme(double r, double kappa)
+{
+	double phi;
+
+	phi = (2*r)/(r*r + 1);
+
+	return ((1-kappa)/2 + r*(1+kappa)/2)*phi;
+}
+
+/*
+** Function Limiter
+**   Selects the limiter of a MUSCL reconstruction; 'recon' is
+**   a constant in the specialised solvers, so the selection is
+**   resolved by the compiler.
+*/
+
+static inline double Limiter(const int recon, double r, double kappa)
+{
+	if (recon == RECON_VANALBADA)
+		return VanAlbada(r);
+	else if (recon == RECON_KAPPA)
+		return KappaScheme(r, kappa);
+	else
+		return VanLeer(r);
+}
+
+/*
+** Function MusclPair
+**   Limited left and right state of one conservative variable
+**   from the four values q[0..3] around the interface, which
+**   lies between q[1] and q[2].
+*/
+
+static inline void MusclPair(const int recon, double kappa, const double *q, double *left, double *right)
+{
+	double r;
+
+	if (q[1]-q[0] < SMALL)
+	{
+		*left  = q[1];
+	}
+	else
+	{
+		r      = (q[2] - q[1])/(q[1] - q[0]);
+		*left  = q[1] + 0.5*Limiter(recon, r, kappa)*(q[1] - q[0]);
+	}
+
+	/* q[3] == q[2] would give 1/r = inf; the limited slope is zero then */
+	if (q[2]-q[1] < SMALL || q[3] == q[2])
+	{
+		*right = q[2];
+	}
+	else
+	{
+		r      = (q[3] - q[2])/(q[2] - q[1]);
+		*right = q[2] - 0.5*Limiter(recon, 1/r, kappa)*(q[3] - q[2]);
+	}
+}
+
+/*
+** Function Reconstruct
+**    Calculates the left and right conservative variables
+**    for use in an approximate riemann solver. With
+**    RECON_CONSTANT these are the nodes themselves (first
+**    order), otherwise the limited MUSCL-scheme is used.
+**
+** In:       int           recon    = reconstruction (constant in the caller)
+**           double        gamma    = constant
+**           double        kappa    = value for kappa
+**           int           im       = number of nodes
+**           double        Q1..Q3   = conservative variables
+**           int           i        = number of node left of interface of interest
+** Out:      tConservative left     = structure containing left conservative variables
+**           tConservative right    = structure containing right conservative variables
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline void Reconstruct(const int recon, double gamma, double kappa, int im,
+                               const double *Q1, const double *Q2, const double *Q3, int i,
+                               tConservative *left, tConservative *right)
+{
+	double q1[4], q2[4], q3[4];
+	double rho0, rho1, rho2, rho3;
+	double u0, u1, u2, u3;
+	double p0, p1, p2, p3;
+
+	if (recon == RECON_CONSTANT)
+	{
+		left->Q1  = Q1[i];
+		right->Q1 = Q1[i+1];
+
+		left->Q2  = Q2[i];
+		right->Q2 = Q2[i+1];
+
+		left->Q3  = Q3[i];
+		right->Q3 = Q3[i+1];
+
+		return;
+	}
+
+	if (i==0)
+	{
+		/* Q[i-1] does not exist; use linear extrapolation */
+		rho2  = Q1[i+1];
+		rho1  = Q1[i  ];
+		rho0  = 2*rho1 - rho2;
+
+		u2    = Q2[i+1]/Q1[i+1];
+		u1    = Q2[i  ]/Q1[i  ];
+		u0    = 2*u1 - u2;
+
+		p2    = (Q3[i+1] - 0.5*rho2*u2*u2)*(gamma-1);
+		p1    = (Q3[i  ] - 0.5*rho1*u1*u1)*(gamma-1);
+		p0    = 2*p1 - p2;
+
+		q1[0] = rho0;
+		q2[0] = rho0*u0;
+		q3[0] = 0.5*rho0*u0*u0 + p0/(gamma-1);
+	}
+	else
+	{
+		q1[0] = Q1[i-1];
+		q2[0] = Q2[i-1];
+		q3[0] = Q3[i-1];
+	}
+
+	q1[1] = Q1[i  ]; q2[1] = Q2[i  ]; q3[1] = Q3[i  ];
+	q1[2] = Q1[i+1]; q2[2] = Q2[i+1]; q3[2] = Q3[i+1];
+
+	if (i==im-2)
+	{
+		/* Q[i+2] does not exist; use linear extrapolation */
+		rho1  = Q1[i  ];
+		rho2  = Q1[i+1];
+		rho3  = 2*rho2 - rho1;
+
+		u1    = Q2[i  ]/Q1[i  ];
+		u2    = Q2[i+1]/Q1[i+1];
+		u3    = 2*u2 - u1;
+
+		p1    = (Q3[i  ] - 0.5*rho1*u1*u1)*(gamma-1);
+		p2    = (Q3[i+1] - 0.5*rho2*u2*u2)*(gamma-1);
+		p3    = 2*p2 - p1;
+
+		q1[3] = rho3;
+		q2[3] = rho3*u3;
+		q3[3] = 0.5*rho3*u3*u3 + p3/(gamma-1);
+	}
+	else
+	{
+		q1[3] = Q1[i+2];
+		q2[3] = Q2[i+2];
+		q3[3] = Q3[i+2];
+	}
+
+	MusclPair(recon, kappa, q1, &left->Q1, &right->Q1);
+	MusclPair(recon, kappa, q2, &left->Q2, &right->Q2);
+	MusclPair(recon, kappa, q3, &left->Q3, &right->Q3);
+}
 
 #endif
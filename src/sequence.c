@@ -0,0 +1,168 @@
+/*
+** Sequence
+**    Grid sequencing: the flow is first solved on coarser grids
+**    of (im-1)/2^k + 1 nodes, k = levels..1, each to the looser
+**    tolerance sequence_tol, and interpolated onto the next
+**    finer grid; the solve on the grid of the data-file then
+**    starts with the shock nearly in place.
+**
+**    Every level is a separate solve of the same data with its
+**    own workspace and Init, so x and A are those of its own
+**    grid. Q is interpolated linearly in x, which conserves the
+**    trapezoidal integrals of rho*A, rho*u*A and Et*A when the
+**    coarse nodes are fine nodes, i.e. when im-1 is divisible by
+**    2^levels. The inlet keeps the values of Init and the exit
+**    is set by Boundary.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "main.h"
+#include "boundary.h"
+#include "initialise.h"
+#include "memory.h"
+#include "sequence.h"
+#include "solve.h"
+
+/*
+** Function Prolong
+**    Interpolates the field of a coarse grid linearly onto the
+**    inner and exit nodes of a finer one.
+*/
+
+static void Prolong(tResult *Coarse, tResult *Fine)
+{
+	int    i, j;
+	double w;
+
+	j = 0;
+	for (i=1; i<Fine->im; i++)
+	{
+		while (j < Coarse->im-2 && Coarse->x[j+1] <= Fine->x[i])
+			j++;
+
+		w = (Fine->x[i] - Coarse->x[j])/(Coarse->x[j+1] - Coarse->x[j]);
+
+		Fine->Q1[i] = (1-w)*Coarse->Q1[j] + w*Coarse->Q1[j+1];
+		Fine->Q2[i] = (1-w)*Coarse->Q2[j] + w*Coarse->Q2[j+1];
+		Fine->Q3[i] = (1-w)*Coarse->Q3[j] + w*Coarse->Q3[j+1];
+	}
+}
+
+/*
+** Function Sequence
+**   Solves the coarse levels of the grid sequence and sets the
+**   field of Result, which Init has built, to the interpolated
+**   solution of the finest of them.
+**
+**   The residual of a level is normalised with the first
+**   residual of the coarsest level, scaled to the number of
+**   nodes of the level; normResidual returns this normalisation
+**   for the grid of the data-file, so that its tolerance means
+**   the same as after a start from the uniform field.
+**
+** In:       FILE    log          = pointer to log file
+**           tData   Data         = structure containing all data
+**           tResult Result       = initialised workspace of the data-file
+**           int     maxIter      = maximum number of iterations per level (0: no limit)
+** Out:      tResult Result       = interpolated field
+**           double  normResidual = normalisation of the residual
+**           long    work         = node updates of the coarse levels
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int Sequence(FILE *log, tData *Data, tResult *Result, int maxIter, double *normResidual, long *work)
+{
+	int    ret;
+	int    k, i;
+	double residual, norm;
+
+	tData   LevelData[2];
+	tResult LevelResult[2];
+	tResult *Coarse, *Fine;
+
+	ret   = 0;
+	norm  = 0;
+	*work = 0;
+
+	Coarse = NULL;
+
+	for (k=Data->sequence; k>=1 && ret!=-1; k--)
+	{
+		/* Alternate between two workspaces; the coarser one is still needed */
+		LevelData[k%2]    = *Data;
+		LevelData[k%2].im = (Data->im-1)/(1<<k) + 1;
+		Fine = &LevelResult[k%2];
+
+		if (LevelData[k%2].im < 3)
+		{
+			fprintf(stderr, "ERROR in function Sequence: %d levels leave less than 3 nodes.\n", Data->sequence);
+			ret = -1;
+			break;
+		}
+
+		ret = InitMem(NULL, &LevelData[k%2], Fine);
+
+		if (ret != -1)
+			ret = Init(NULL, &LevelData[k%2], Fine);
+
+		if (ret != -1 && Coarse)
+		{
+			Prolong(Coarse, Fine);
+			ret = Boundary(&LevelData[k%2], Fine);
+		}
+
+		if (Coarse)
+		{
+			FreeMem(Coarse);
+			Coarse = NULL;
+		}
+
+		/* The first residual of the coarsest level, per node */
+		i        = 0;
+		residual = Data->sequenceTol+1;
+		while (ret != -1 && residual > Data->sequenceTol && (maxIter <= 0 || i < maxIter))
+		{
+			i++;
+			ret = Iterate(&LevelData[k%2], Fine, &residual);
+
+			if (norm == 0)
+				norm = residual/LevelData[k%2].im;
+
+			residual /= norm*LevelData[k%2].im;
+
+			if (!isfinite(residual))
+			{
+				fprintf(stderr, "ERROR in function Sequence: The solve on %d nodes diverged.\n", LevelData[k%2].im);
+				ret = -1;
+			}
+		}
+
+		*work += Fine->sweeps*LevelData[k%2].im;
+
+		if (log)
+			fprintf(log, "Grid sequence: im = %d, %d iterations, residual %10.7f.\n", LevelData[k%2].im, i, residual);
+
+		if (ret == -1)
+			FreeMem(Fine);
+		else
+			Coarse = Fine;
+	}
+
+	if (Coarse)
+	{
+		Prolong(Coarse, Result);
+		ret = Boundary(Data, Result);
+
+		FreeMem(Coarse);
+	}
+
+	*normResidual = norm*Data->im;
+
+	return ret;
+}
@@ -0,0 +1,10 @@
+/*
+** Header-file for Sequence
+*/
+
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+int Sequence(FILE*, tData*, tResult*, int, double*, long*);
+
+#endif
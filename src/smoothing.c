@@ -0,0 +1,130 @@
+/*
+** Smoothing
+**    Implicit residual smoothing of the explicit schemes. The
+**    change dQ = dt*R of a step is replaced by the solution of
+**
+**      -eps dQs[i-1] + (1+2 eps) dQs[i] - eps dQs[i+1] = dQ[i]
+**
+**    for every conservative variable, over the inner nodes. The
+**    inlet gets no change and the exit is set by Boundary, so
+**    both ends are dQs = 0. The smoothing damps the short waves
+**    only: a Lax-Wendroff type step (MacCormack) is stable up to
+**    CFL = sqrt(1+4 eps), but a single forward Euler step of an
+**    upwind scheme (Roe) still amplifies the long waves above
+**    CFL 1, if slowly.
+**
+**    The change is smoothed after the scheme updated the whole
+**    field, so every kernel and the blocks are smoothed alike;
+**    the residual of the step is the one of the scheme.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "main.h"
+#include "smoothing.h"
+
+/*
+** Function KeepField
+**   Stores the field before a step of which the change is to be
+**   smoothed.
+**
+** In:       tResult Result = structure containing results
+** Out:      tResult Result = irs[0..2] hold Q1, Q2 and Q3
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void KeepField(tResult *Result)
+{
+	memcpy(Result->irs[0], Result->Q1, Result->im*sizeof(double));
+	memcpy(Result->irs[1], Result->Q2, Result->im*sizeof(double));
+	memcpy(Result->irs[2], Result->Q3, Result->im*sizeof(double));
+}
+
+/*
+** Function SmoothArrays
+**   Smooths the inner nodes of three arrays in place. The
+**   tridiagonal system is the same for the three: its pivots
+**   are computed once and the three are solved in the same
+**   sweeps (Thomas algorithm). Both ends count as zero.
+**
+** In:       double eps = smoothing coefficient
+**           int    im  = number of nodes
+**           double m   = workspace of im doubles (inverse pivots)
+**           double R   = three arrays to smooth
+** Out:      double R   = smoothed arrays
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void SmoothArrays(double eps, int im, double *m, double **R)
+{
+	int    i, c;
+	double d[3];
+
+	/* Forward sweep; R holds the modified right hand side */
+	for (c=0; c<3; c++)
+		d[c] = 0;
+
+	for (i=1; i<im-1; i++)
+	{
+		m[i] = 1/(1 + 2*eps - ((i > 1) ? eps*eps*m[i-1] : 0));
+
+		for (c=0; c<3; c++)
+		{
+			d[c]    = (R[c][i] + eps*d[c])*m[i];
+			R[c][i] = d[c];
+		}
+	}
+
+	/* Backward sweep */
+	for (c=0; c<3; c++)
+		d[c] = 0;
+
+	for (i=im-2; i>0; i--)
+		for (c=0; c<3; c++)
+		{
+			d[c]    = R[c][i] + eps*m[i]*d[c];
+			R[c][i] = d[c];
+		}
+}
+
+/*
+** Function SmoothResidual
+**   Replaces the change of the inner nodes since KeepField by the
+**   smoothed change.
+**
+** In:       tData   Data   = structure containing all data
+**           tResult Result = field after the step
+** Out:      tResult Result = field after the smoothed step
+** Return:   -
+**
+** Author:   J.L. Klaufus
+*/
+
+void SmoothResidual(tData *Data, tResult *Result)
+{
+	int    i, c, im;
+	double *Q[3];
+
+	im = Result->im;
+
+	Q[0] = Result->Q1;
+	Q[1] = Result->Q2;
+	Q[2] = Result->Q3;
+
+	for (c=0; c<3; c++)
+		for (i=1; i<im-1; i++)
+			Q[c][i] -= Result->irs[c][i];
+
+	SmoothArrays(Data->irs, im, Result->irs[3], Q);
+
+	for (c=0; c<3; c++)
+		for (i=1; i<im-1; i++)
+			Q[c][i] += Result->irs[c][i];
+}
@@ -0,0 +1,12 @@
+/*
+** Header-file for Smoothing
+*/
+
+#ifndef SMOOTHING_H
+#define SMOOTHING_H
+
+void KeepField(tResult*);
+void SmoothArrays(double, int, double*, double**);
+void SmoothResidual(tData*, tResult*);
+
+#endif
@@ -0,0 +1,288 @@
+/*
+** Function SelectSolver
+**   Resolves the scheme, limiter, flux and kernel of the
+**   data-file into the specialised solver of one iteration.
+**   Called once when the workspace is set up; Iterate only
+**   calls Result->solver.
+**
+** In:       FILE    log    = pointer to log file
+**           tData   Data   = structure containing all data
+** Out:      tResult Result = recon and solver are set
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "main.h"
+#include "adapt.h"
+#include "block.h"
+#include "boundary.h"
+#include "eh.h"
+#include "extrapolate.h"
+#include "fused.h"
+#include "implicit.h"
+#include "integrator.h"
+#include "monitor.h"
+#include "maccormack.h"
+#include "multigrid.h"
+#include "newton.h"
+#include "roe.h"
+#include "flux.h"
+#include "roebatch.h"
+#include "schemes.h"
+#include "smoothing.h"
+#include "solve.h"
+#include "timestep.h"
+#include "trace.h"
+
+/* Roe variants, indexed by reconstruction */
+static const tSolver roeSolvers[NRECON]      = {RoeConstant, RoeVanLeer, RoeVanAlbada, RoeKappa};
+static const tSolver fusedRoeSolvers[NRECON] = {FusedRoeConstant, FusedRoeVanLeer, FusedRoeVanAlbada, FusedRoeKappa};
+static const tSolver roeBatchSolvers[NRECON] = {RoeBatchConstant, RoeBatchVanLeer, RoeBatchVanAlbada, RoeBatchKappa};
+static const tSolver blockRoeSolvers[NRECON] = {BlockRoeConstant, BlockRoeVanLeer, BlockRoeVanAlbada, BlockRoeKappa};
+static const tSolver rkSolvers[NRECON]       = {RungeKuttaConstant, RungeKuttaVanLeer, RungeKuttaVanAlbada, RungeKuttaKappa};
+static const tSolver fluxSolvers[NRECON]     = {FluxConstant, FluxVanLeer, FluxVanAlbada, FluxKappa};
+
+int SelectSolver(FILE *log, tData *Data, tResult *Result)
+{
+	int ret;
+
+	ret = 0;
+
+	Result->recon  = Reconstruction(Data);
+	Result->solver = NULL;
+
+	if (Data->scheme == 'C')
+	{
+		if (Data->threads > 0)
+			Result->solver = BlockMacCormack;
+		else
+			Result->solver = (Data->kernel == KERNEL_FUSED) ? FusedMacCormack : MacCormack;
+	}
+	else if (Data->scheme == 'I')
+		Result->solver = Implicit;
+	else if (Data->scheme == 'R' || Data->scheme == 'M')
+	{
+		if (Data->integrator != INTEGRATOR_EULER)
+			Result->solver = rkSolvers[Result->recon];
+		else if (Data->flux != FLUX_ROE)
+			Result->solver = fluxSolvers[Result->recon];
+		else if (Data->threads > 0)
+			Result->solver = blockRoeSolvers[Result->recon];
+		else if (Data->kernel == KERNEL_FUSED)
+			Result->solver = fusedRoeSolvers[Result->recon];
+		else if (Data->kernel == KERNEL_SIMD)
+			Result->solver = roeBatchSolvers[Result->recon];
+		else
+			Result->solver = roeSolvers[Result->recon];
+	}
+	else
+	{
+		fprintf(stderr, "ERROR in function SelectSolver: UNKNOWN scheme type...\n");
+		if (log)
+			fprintf(log,    "ERROR in function SelectSolver: UNKNOWN scheme type...\n");
+		ret = -1;
+	}
+
+	if (log && ret != -1)
+		fprintf(log, "\n   Solver: scheme %c, reconstruction %s, flux %s\n\n", Data->scheme,
+		        ReconstructionName(Result->recon), FluxName(Data->flux));
+
+	return ret;
+}
+
+
+/*
+** Function Step
+**   Performs a single step of the selected scheme: calculates
+**   the E and H vectors and the timestep, advances the inner
+**   field and updates the exit boundary.
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results
+**           double  residual = residual (not normalised)
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int Step(tData *Data, tResult *Result, double *residual)
+{
+	int ret;
+	int smooth;
+
+	ret = 0;
+
+	/* The multistage integrators smooth the residual of every stage themselves */
+	smooth = Result->irs[0] && Data->integrator == INTEGRATOR_EULER;
+
+	if (smooth)
+		KeepField(Result);
+
+	/*
+	** Blocks: E and H, the timestep and the update are computed
+	** by the threads of the blocks in one call.
+	*/
+	if (Result->blocks)
+	{
+		ret = Result->solver(Data, Result, residual);
+
+		if (ret != -1 && smooth)
+			SmoothResidual(Data, Result);
+
+		if (ret != -1)
+			ret = Boundary(Data, Result);
+	}
+	/*
+	** Fused kernel: one sweep computes E and H on the fly and
+	** the timestep of the next iteration; only the very first
+	** timestep, and that after residual smoothing, needs a
+	** separate pass.
+	*/
+	else if (Data->kernel == KERNEL_FUSED)
+	{
+		if (Result->timeStep <= 0)
+			ret = TimeStep(Data, Result);
+
+		if (ret != -1)
+			ret = Result->solver(Data, Result, residual);
+
+		/* The timestep of the sweep is that of the unsmoothed field */
+		if (ret != -1 && smooth)
+		{
+			SmoothResidual(Data, Result);
+			Result->timeStep = 0;
+		}
+
+		if (ret != -1)
+			ret = Boundary(Data, Result);
+	}
+	else
+	{
+		/* Calculate E and H vectors */
+		if (ret != -1)
+			ret = CalcEH(Data, Result);
+
+		/* Calculate timestep */
+		if (ret != -1)
+			ret = TimeStep(Data, Result);
+
+		/* Solve */
+		if (ret != -1)
+			ret = Result->solver(Data, Result, residual);
+
+		/* Smooth the change of the step */
+		if (ret != -1 && smooth)
+			SmoothResidual(Data, Result);
+
+		/* Update boundaries */
+		if (ret != -1)
+			ret = Boundary(Data, Result);
+	}
+
+	Result->sweeps++;
+
+	return ret;
+}
+
+
+/*
+** Function Iterate
+**   Performs a single iteration: one step of the selected
+**   scheme, one multigrid cycle or one Newton step. The step is
+**   followed by the adaptation of the grid and the extrapolation
+**   of the field when they are due.
+**
+** In:       tData   Data     = structure containing all data
+** Out:      tResult Result   = structure containing results
+**           double  residual = residual (not normalised)
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int Iterate(tData *Data, tResult *Result, double *residual)
+{
+	int ret;
+
+	TRACE_ITERATION();
+
+	if (Result->newton)
+		ret = NewtonStep(Data, Result, residual);
+	else if (Result->multigrid)
+		ret = MultigridCycle(Data, Result, residual);
+	else
+	{
+		ret = Step(Data, Result, residual);
+
+		/* Move the grid to the shock every adapt iterations */
+		if (ret != -1 && Result->adapt[0] && Result->sweeps % Data->adapt == 0)
+			ret = Adapt(Data, Result);
+
+		/* Jump ahead along the last iterates when the window is full */
+		if (ret != -1 && Result->extrapolation)
+			ret = Extrapolate(Data, Result, residual);
+	}
+
+	if (ret != -1)
+		TRACE(TRACE_SOLVER, TRACE_ITER, TRACE_EV_ITERATION, -1, *residual, Result->timeStep, 0, 0);
+	else
+		TRACE(TRACE_SOLVER, TRACE_ERROR, TRACE_EV_ERROR, -1, *residual, Result->timeStep, 0, 0);
+
+	return ret;
+}
+
+
+/*
+** Function Solve
+**   Iterates until the stopping rule of the data-file holds;
+**   by default, until the residual, normalised with the
+**   residual of the first iteration, drops below stop_tol.
+**
+** In:       tData   Data       = structure containing all data
+**           int     maxIter    = maximum number of iterations (0: no limit)
+**           double  norm       = normalisation of the residual (0: first iteration)
+** Out:      tResult Result     = structure containing results
+**           int     iterations = number of iterations done
+**           double  residual   = final normalised residual
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int Solve(tData *Data, tResult *Result, int maxIter, double norm, int *iterations, double *residual)
+{
+	int    ret;
+	int    i, converged;
+	double normResidual;
+
+	ret          = 0;
+	i            = 0;
+	converged    = 0;
+	normResidual = norm;
+	*residual    = SMALL+1;
+
+	while (!converged && (maxIter <= 0 || i < maxIter) && ret != -1)
+	{
+		i++;
+
+		ret = Iterate(Data, Result, residual);
+
+		if (normResidual == 0)
+			normResidual = *residual;
+
+		*residual /= normResidual;
+		if (ret != -1 && (converged = Converged(Data, Result, *residual)) == -1)
+		{
+			converged = 0;
+			ret       = -1;
+		}
+	}
+
+	*iterations = i;
+
+	return ret;
+}
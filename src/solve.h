@@ -0,0 +1,13 @@
+/*
+** Header-file for Solve
+*/
+
+#ifndef SOLVE_H
+#define SOLVE_H
+
+int SelectSolver(FILE*, tData*, tResult*);
+int Step(tData*, tResult*, double*);
+int Iterate(tData*, tResult*, double*);
+int Solve(tData*, tResult*, int, double, int*, double*);
+
+#endif
@@ -0,0 +1,318 @@
+/*
+** Function Sweep
+**    Solves all cases of a case table (see ReadCase) on a
+**    work-stealing pool of threads. Every worker has its own
+**    solver context (tResult), so the cases share nothing but
+**    the read-only table. The output of case N is written to
+**    PREFIX_N.gnu, or, combined, as GNUPlot data block N of
+**    PREFIX.gnu ('index N'). PREFIX.sum lists the iterations,
+**    residual, time and status of every case.
+**
+** In:       FILE log           = pointer to log file
+**           char tableFileName = name of the case table
+**           char prefix        = prefix of the output files
+**           int  nThreads      = number of threads (0: one per core)
+**           int  maxIter       = maximum iterations per case (0: no limit)
+**           int  combined      = 1 for one combined output file
+** Out:      -
+** Return:   0 when all cases succeeded, -1 otherwise
+**
+** Author:   J.L. Klaufus
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "data.h"
+#include "initialise.h"
+#include "memory.h"
+#include "pool.h"
+#include "sequence.h"
+#include "solve.h"
+#include "sweep.h"
+#include "timer.h"
+
+typedef struct
+{
+	tData  Data;
+	int    status;
+	int    iterations;
+	double residual;
+	double seconds;
+	char   *field;
+	size_t fieldSize;
+} tCase;
+
+typedef struct
+{
+	tCase   *cases;
+	tResult *contexts;
+	char    *prefix;
+	int     maxIter;
+	int     combined;
+} tSweep;
+
+/*
+** Function ReadTable
+**    Reads all cases of the case table.
+**
+** Return:   number of cases, -1 on failure
+*/
+
+static int ReadTable(char *tableFileName, tCase **cases)
+{
+	int   n, size;
+	int   status;
+	char  line[1024];
+	tCase *grown;
+	FILE  *tableFile;
+
+	tableFile = fopen(tableFileName, "r");
+	if (tableFile == NULL)
+	{
+		fprintf(stderr, "ERROR in function Sweep: Could not open '%s'.\n", tableFileName);
+		return -1;
+	}
+
+	n      = 0;
+	size   = 0;
+	*cases = NULL;
+	while (n != -1 && fgets(line, sizeof(line), tableFile))
+	{
+		line[strcspn(line, "\r\n")] = '\0';
+
+		if (n == size)
+		{
+			size  = size ? 2*size : 256;
+			grown = realloc(*cases, size*sizeof(tCase));
+			if (grown == NULL)
+			{
+				fprintf(stderr, "ERROR in function Sweep: could not allocate memory...\n");
+				n = -1;
+				break;
+			}
+			*cases = grown;
+		}
+
+		memset(&(*cases)[n], 0, sizeof(tCase));
+		status = ReadCase(line, &(*cases)[n].Data);
+		if (status == -1)
+			n = -1;
+		else
+			n += status;
+	}
+
+	fclose(tableFile);
+
+	if (n == -1)
+	{
+		free(*cases);
+		*cases = NULL;
+	}
+
+	return n;
+}
+
+/*
+** Function SolveCase
+**    Task of the pool: solves one case in the context of the
+**    worker and writes or keeps its output.
+*/
+
+static int SolveCase(void *context, int worker, int index)
+{
+	int     ret;
+	char    fileName[512];
+	long    work;
+	double  t1, norm;
+	FILE    *stream;
+	tSweep  *Run    = context;
+	tCase   *Case   = &Run->cases[index];
+	tResult *Result = &Run->contexts[worker];
+
+	t1 = WallTime();
+
+	ret = InitMem(NULL, &Case->Data, Result);
+
+	if (ret != -1)
+		ret = Init(NULL, &Case->Data, Result);
+
+	norm = 0;
+	if (ret != -1 && Case->Data.sequence > 0)
+		ret = Sequence(NULL, &Case->Data, Result, Run->maxIter, &norm, &work);
+
+	if (ret != -1)
+		ret = Solve(&Case->Data, Result, Run->maxIter, norm, &Case->iterations, &Case->residual);
+
+	if (ret != -1)
+	{
+		if (Run->combined)
+		{
+			/* Kept in memory; written in case order when all cases are done */
+			stream = open_memstream(&Case->field, &Case->fieldSize);
+			if (stream)
+			{
+				WriteGNUField(stream, &Case->Data, Result);
+				fclose(stream);
+			}
+			else
+				ret = -1;
+		}
+		else
+		{
+			snprintf(fileName, sizeof(fileName), "%s_%d.gnu", Run->prefix, index);
+			ret = WriteGNUData(NULL, fileName, &Case->Data, Result);
+		}
+	}
+
+	FreeMem(Result);
+
+	Case->seconds = WallTime() - t1;
+	Case->status  = ret;
+
+	return ret;
+}
+
+/*
+** Function WriteSweep
+**    Writes the summary and, if combined, all data blocks in
+**    case order.
+*/
+
+static int WriteSweep(tSweep *Run, int nCases)
+{
+	int   ret;
+	int   i;
+	char  fileName[512];
+	FILE  *sumFile, *gnuFile;
+	tCase *Case;
+
+	ret     = 0;
+	gnuFile = NULL;
+
+	snprintf(fileName, sizeof(fileName), "%s.sum", Run->prefix);
+	sumFile = fopen(fileName, "w");
+	if (sumFile == NULL)
+	{
+		fprintf(stderr, "ERROR in function Sweep: Could not open '%s'.\n", fileName);
+		ret = -1;
+	}
+	else
+		fprintf(sumFile, "#  Case Scheme         im Iterations     Residual    Seconds Status\n");
+
+	if (Run->combined)
+	{
+		snprintf(fileName, sizeof(fileName), "%s.gnu", Run->prefix);
+		gnuFile = fopen(fileName, "w");
+		if (gnuFile == NULL)
+		{
+			fprintf(stderr, "ERROR in function Sweep: Could not open '%s'.\n", fileName);
+			ret = -1;
+		}
+	}
+
+	for (i=0; i<nCases; i++)
+	{
+		Case = &Run->cases[i];
+
+		if (sumFile)
+			fprintf(sumFile, "%7d %6c %10d %10d %12.5e %10.4f %6s\n", i, Case->Data.scheme, Case->Data.im,
+			        Case->iterations, Case->residual, Case->seconds, Case->status == -1 ? "FAILED" : "OK");
+
+		/* One block per case, also for failed cases, so that 'index N' is case N */
+		if (gnuFile)
+		{
+			fprintf(gnuFile, "# Case %d\n", i);
+			if (Case->field)
+				fwrite(Case->field, 1, Case->fieldSize, gnuFile);
+			else
+				fprintf(gnuFile, "# FAILED\n");
+			fprintf(gnuFile, "\n\n");
+		}
+	}
+
+	if (sumFile && fclose(sumFile) != 0)
+		ret = -1;
+
+	if (gnuFile && fclose(gnuFile) != 0)
+		ret = -1;
+
+	return ret;
+}
+
+int Sweep(FILE *log, char *tableFileName, char *prefix, int nThreads, int maxIter, int combined)
+{
+	int    ret;
+	int    i;
+	int    nCases, failed;
+	double t1, t2;
+	tSweep Run;
+
+	ret = 0;
+
+	nCases = ReadTable(tableFileName, &Run.cases);
+	if (nCases <= 0)
+	{
+		if (nCases == 0)
+			fprintf(stderr, "ERROR in function Sweep: No cases in '%s'.\n", tableFileName);
+		return -1;
+	}
+
+	if (nThreads <= 0)
+		nThreads = NumberOfCores();
+	if (nThreads > nCases)
+		nThreads = nCases;
+
+	Run.prefix   = prefix;
+	Run.maxIter  = maxIter;
+	Run.combined = combined;
+	Run.contexts = calloc(nThreads, sizeof(tResult));
+
+	if (Run.contexts == NULL)
+	{
+		fprintf(stderr, "ERROR in function Sweep: could not allocate memory...\n");
+		free(Run.cases);
+		return -1;
+	}
+
+	printf("Sweep: %d cases on %d threads...\n", nCases, nThreads);
+
+	t1 = WallTime();
+	failed = RunPool(nThreads, nCases, SolveCase, &Run);
+	t2 = WallTime();
+
+	if (failed != 0)
+		ret = -1;
+
+	if (WriteSweep(&Run, nCases) == -1)
+		ret = -1;
+
+	printf("Sweep: %d cases, %d failed, %.3f sec (%.1f cases/sec)\n", nCases, failed < 0 ? nCases : failed,
+	       t2-t1, nCases/(t2-t1));
+
+	/* Write report */
+	if (log)
+	{
+		fprintf(log, "\n***** FUNCTION SWEEP *****\n\n");
+
+		fprintf(log, "  Table    = %s\n", tableFileName);
+		fprintf(log, "  Cases    = %d\n", nCases);
+		fprintf(log, "  Threads  = %d\n", nThreads);
+		fprintf(log, "  Failed   = %d\n", failed < 0 ? nCases : failed);
+		fprintf(log, "  Time     = %.3f sec\n", t2-t1);
+
+		fprintf(log, "\n**************************\n\n");
+	}
+
+	for (i=0; i<nCases; i++)
+		free(Run.cases[i].field);
+
+	free(Run.cases);
+	free(Run.contexts);
+
+	return ret;
+}
@@ -0,0 +1,10 @@
+/*
+** Header-file for Sweep
+*/
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+int Sweep(FILE*, char*, char*, int, int, int);
+
+#endif
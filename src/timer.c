@@ -0,0 +1,28 @@
+/*
+** Function WallTime
+**   Returns the time elapsed since an arbitrary, fixed point
+**   in the past. Uses the monotonic clock, so differences
+**   between two calls give the wall time spent in between
+**   with sub-microsecond resolution.
+**
+** In:       -
+** Out:      -
+** Return:   double time = wall time in seconds
+**
+** Author:   J.L. Klaufus
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "timer.h"
+
+double WallTime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
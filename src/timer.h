@@ -0,0 +1,10 @@
+/*
+** Header-file for Timer
+*/
+
+#ifndef TIMER_H
+#define TIMER_H
+
+double WallTime(void);
+
+#endif
@@ -2,6 +2,11 @@
 ** Function TimeStep
 ** Calculates the appropiate timestep
 **
+**   Result->timeStep is the smallest timestep of the inner
+**   nodes. With local time stepping Result->dt holds the
+**   timestep of every inner node as well; the inlet node takes
+**   the timestep of its neighbour.
+**
 ** In:       tData   Data   = structure containing all data
 ** Out:      tResult Result = structure containing results
 ** Return:   0 on success, -1 on failure
@@ -14,63 +19,47 @@
 
 #include "main.h"
 #include "timestep.h"
+#include "trace.h"
 
-int TimeStep(FILE *log, tData *Data, tResult *Result)
+int TimeStep(tData *Data, tResult *Result)
 {
 	int ret;
 	int i;
 
 	double CFL;
-	double X1, X2;
-
 	double gamma;
-	double A, rho, u, Et, p, a;
-
 	double localTimeStep;
 
 	/*printf("Calculating timestep...\n");*/
 
 	ret = 0;
 
+	gamma = Data->gamma;
+	CFL   = Data->CFL;
+
 	for (i=1; i<Result->im-1; i++)
 	{
-		gamma = Data->gamma;
-		CFL   = Data->CFL;
-
-		/* Solve for primitives */
-		X1    = Result->x[i];
-		X2    = Result->x[i+1];
-		A     = Result->A[i];
-		rho   = Result->Q1[i]/A;
-		u     = Result->Q2[i]/Result->Q1[i];
-		Et    = Result->Q3[i]/A;
-		p     = (Et-0.5*rho*u*u)*(gamma-1);
-		a     = sqrt(gamma*p/rho);
-
-		/* Calculate timestep */
-		if (a < SMALL)
+		/* Calculate deltaT */
+		if (CellTimeStep(gamma, CFL, Result->dx[i], Result->invA[i],
+		                 Result->Q1[i], Result->Q2[i], Result->Q3[i], &localTimeStep) == -1)
 		{
-			fprintf(stderr, "ERROR in function TimeStep: a = %10.3f\n", a);
+			TRACE(TRACE_TIMESTEP, TRACE_ERROR, TRACE_EV_ERROR, i, Result->Q1[i], Result->Q2[i], Result->Q3[i], 0);
 			ret = -1;
 		}
 		else
 		{
-			/* Calculate deltaT */
-			localTimeStep = CFL*(X2 - X1)/(fabs(u)+a);
+			if (Result->dt)
+				Result->dt[i] = localTimeStep;
 
 			if ((i==1) || (localTimeStep < Result->timeStep))
 				Result->timeStep = localTimeStep;
 		}
 	}
 
-	if (log)
-	{
-		fprintf(log, "\n***** FUNCTION TIMESTEP *****\n\n");
-
-		fprintf(log, "Timestep = %f\n", Result->timeStep);
+	if (Result->dt && Result->im > 2)
+		Result->dt[0] = Result->dt[1];
 
-		fprintf(log, "\n*****************************\n\n");
-	}
+	TRACE(TRACE_TIMESTEP, TRACE_CALL, TRACE_EV_TIMESTEP, -1, Result->timeStep, 0, 0, 0);
 
 	return ret;
 }
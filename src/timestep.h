@@ -5,6 +5,50 @@
 #ifndef TIMESTEP_H
 #define TIMESTEP_H
 
-int TimeStep(FILE*, tData*, tResult*);
+/* Largest CFL of MacCormack's scheme with local time stepping */
+#define TIMESTEP_LOCAL_CFL_C 0.9
+
+int TimeStep(tData*, tResult*);
+
+/*
+** Function CellTimeStep
+**   Calculates the timestep allowed by the CFL condition in a
+**   single node. Used by TimeStep and by the fused kernels,
+**   which reduce the timestep of the next iteration while
+**   updating the field.
+**
+** In:       double gamma    = constant
+**           double CFL      = CFL number
+**           double deltaX   = x[i+1] - x[i]
+**           double invA     = 1/area in the node
+**           double Q1,Q2,Q3 = conservative variables in the node
+** Out:      double dt       = timestep allowed in the node
+** Return:   0 on success, -1 when the speed of sound vanishes
+**
+** Author:   J.L. Klaufus
+*/
+
+static inline int CellTimeStep(double gamma, double CFL, double deltaX, double invA,
+                               double Q1, double Q2, double Q3, double *dt)
+{
+	double rho, u, Et, p, a;
+
+	/* Solve for primitives */
+	rho   = Q1*invA;
+	u     = Q2/Q1;
+	Et    = Q3*invA;
+	p     = (Et-0.5*rho*u*u)*(gamma-1);
+	a     = sqrt(gamma*p/rho);
+
+	if (a < SMALL)
+	{
+		fprintf(stderr, "ERROR in function TimeStep: a = %10.3f\n", a);
+		return -1;
+	}
+
+	*dt = CFL*deltaX/(fabs(u)+a);
+
+	return 0;
+}
 
 #endif
@@ -0,0 +1,357 @@
+/*
+** Tracing
+**    Every thread that records a trace gets its own ring buffer
+**    of fixed-size binary records, so recording needs neither a
+**    lock nor a format conversion. Only the last records of each
+**    thread are kept. TraceClose writes all rings to the trace
+**    file; TraceDecode (program tracedump) turns the file into
+**    text.
+**
+**    The trace file consists of a header (magic, record size,
+**    ring size) followed per thread by the thread number, the
+**    number of records stored, the number of records recorded
+**    and the records themselves, oldest first.
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "trace.h"
+
+#define TRACE_MAGIC "NZTRACE1"
+
+typedef struct sTraceRing
+{
+	tTraceRecord       *records;
+	unsigned long long count;
+	int                thread;
+	struct sTraceRing  *next;
+} tTraceRing;
+
+int traceMask  = 0;
+int traceLevel = 0;
+
+static char            traceFileName[256];
+static int             ringSize    = 0;
+static int             nRings      = 0;
+static tTraceRing      *rings      = NULL;
+static pthread_mutex_t ringLock    = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local tTraceRing *ring      = NULL;
+static _Thread_local int        iteration = 0;
+
+static struct
+{
+	char *name;
+	int  nValues;
+	char *values[4];
+} events[TRACE_NEVENTS] =
+{
+	{"ITERATION", 2, {"residual", "timeStep"}},
+	{"FIELD",     3, {"Q1", "Q2", "Q3"}},
+	{"LEFT",      3, {"Q1", "Q2", "Q3"}},
+	{"RIGHT",     3, {"Q1", "Q2", "Q3"}},
+	{"FLUX",      3, {"F1", "F2", "F3"}},
+	{"AV",        4, {"D1", "D2", "D3", "p_term"}},
+	{"EH",        4, {"E1", "E2", "E3", "H2"}},
+	{"TIMESTEP",  1, {"timeStep"}},
+	{"BOUNDARY",  3, {"rho", "u", "p"}},
+	{"DERIVATIVE",1, {"dA_dx"}},
+	{"ERROR",     4, {"v1", "v2", "v3", "v4"}}
+};
+
+static struct
+{
+	char *name;
+	int  mask;
+} subsystems[] =
+{
+	{"solver",   TRACE_SOLVER},
+	{"scheme",   TRACE_SCHEME},
+	{"av",       TRACE_AV},
+	{"eh",       TRACE_EH},
+	{"timestep", TRACE_TIMESTEP},
+	{"boundary", TRACE_BOUNDARY},
+	{"grid",     TRACE_GRID},
+	{"all",      TRACE_ALL}
+};
+
+#define NSUBSYSTEMS ((int)(sizeof(subsystems)/sizeof(subsystems[0])))
+
+/*
+** Function TraceOpen
+**    Enables tracing. The specification is a comma separated
+**    list of subsystems, optionally followed by ':' and the
+**    level, e.g. "solver,av:4" or "all".
+**
+** In:       char fileName = name of the trace file
+**           char spec     = subsystems and level
+**           int  records  = records kept per thread (power of 2)
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int TraceOpen(char *fileName, char *spec, int records)
+{
+	int  ret;
+	int  k;
+	char list[256];
+	char *name, *level;
+
+	ret = 0;
+
+#ifndef NOZZLE_TRACE
+	fprintf(stderr, "WARNING: Tracing is not compiled in; rebuild with 'make TRACE=1'.\n");
+#endif
+
+	strncpy(list, spec, sizeof(list)-1);
+	list[sizeof(list)-1] = '\0';
+
+	traceLevel = TRACE_CELL;
+	level = strchr(list, ':');
+	if (level)
+	{
+		*level++   = '\0';
+		traceLevel = atoi(level);
+	}
+
+	traceMask = 0;
+	for (name=strtok(list, ","); name && ret != -1; name=strtok(NULL, ","))
+	{
+		for (k=0; k<NSUBSYSTEMS; k++)
+			if (strcmp(name, subsystems[k].name) == 0)
+				break;
+
+		if (k == NSUBSYSTEMS)
+		{
+			fprintf(stderr, "ERROR in function TraceOpen: Unknown subsystem '%s'.\n", name);
+			ret = -1;
+		}
+		else
+			traceMask |= subsystems[k].mask;
+	}
+
+	if (records < 1 || (records & (records-1)) != 0)
+	{
+		fprintf(stderr, "ERROR in function TraceOpen: Ring size %d is not a power of 2.\n", records);
+		ret = -1;
+	}
+
+	if (ret != -1)
+	{
+		strncpy(traceFileName, fileName, sizeof(traceFileName)-1);
+		ringSize = records;
+	}
+	else
+		traceMask = traceLevel = 0;
+
+	return ret;
+}
+
+/*
+** Function TraceRecord
+**    Stores one record in the ring of the calling thread; the
+**    ring is allocated by the first record of a thread. Called
+**    through the TRACE macro only.
+*/
+
+void TraceRecord(int subsystem, int level, int event, int i, double a, double b, double c, double d)
+{
+	tTraceRecord *record;
+
+	if (ring == NULL)
+	{
+		if (ringSize == 0 || (ring = malloc(sizeof(tTraceRing))) == NULL)
+			return;
+
+		ring->records = malloc(ringSize*sizeof(tTraceRecord));
+		ring->count   = 0;
+		if (ring->records == NULL)
+		{
+			free(ring);
+			ring = NULL;
+			return;
+		}
+
+		pthread_mutex_lock(&ringLock);
+		ring->thread = nRings++;
+		ring->next   = rings;
+		rings        = ring;
+		pthread_mutex_unlock(&ringLock);
+	}
+
+	record = &ring->records[ring->count & (ringSize-1)];
+	ring->count++;
+
+	record->subsystem = subsystem;
+	record->level     = level;
+	record->event     = event;
+	record->iteration = iteration;
+	record->i         = i;
+	record->thread    = ring->thread;
+	record->v[0]      = a;
+	record->v[1]      = b;
+	record->v[2]      = c;
+	record->v[3]      = d;
+}
+
+/*
+** Function TraceIteration
+**    Advances the iteration counter of the calling thread.
+*/
+
+void TraceIteration(void)
+{
+	iteration++;
+}
+
+/*
+** Function TraceClose
+**    Writes the rings of all threads to the trace file and frees
+**    them. Must be called after all recording threads are done.
+**
+** In:       -
+** Out:      -
+** Return:   0 on success, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int TraceClose(void)
+{
+	int                ret;
+	int                header[2];
+	int                n, start;
+	FILE               *traceFile;
+	tTraceRing         *next;
+
+	ret = 0;
+
+	if (ringSize == 0)
+		return ret;
+
+	traceFile = fopen(traceFileName, "wb");
+	if (traceFile == NULL)
+	{
+		fprintf(stderr, "ERROR in function TraceClose: Could not open '%s'.\n", traceFileName);
+		ret = -1;
+	}
+	else
+	{
+		header[0] = sizeof(tTraceRecord);
+		header[1] = ringSize;
+		fwrite(TRACE_MAGIC, 1, 8, traceFile);
+		fwrite(header, sizeof(int), 2, traceFile);
+	}
+
+	pthread_mutex_lock(&ringLock);
+	for (; rings; rings=next)
+	{
+		next = rings->next;
+
+		if (traceFile)
+		{
+			n     = rings->count < (unsigned long long)ringSize ? (int)rings->count : ringSize;
+			start = (n == ringSize) ? (int)(rings->count & (ringSize-1)) : 0;
+
+			fwrite(&rings->thread, sizeof(int), 1, traceFile);
+			fwrite(&n, sizeof(int), 1, traceFile);
+			fwrite(&rings->count, sizeof(rings->count), 1, traceFile);
+
+			/* Oldest first: from the write position to the end, then from the start */
+			fwrite(rings->records + start, sizeof(tTraceRecord), n - start, traceFile);
+			fwrite(rings->records, sizeof(tTraceRecord), start, traceFile);
+		}
+
+		free(rings->records);
+		free(rings);
+	}
+	nRings = 0;
+	pthread_mutex_unlock(&ringLock);
+
+	if (traceFile && fclose(traceFile) != 0)
+		ret = -1;
+
+	ring       = NULL;
+	ringSize   = 0;
+	traceMask  = traceLevel = 0;
+
+	return ret;
+}
+
+/*
+** Function TraceDecode
+**    Converts a trace file into text; one line per record.
+**
+** In:       FILE in  = opened trace file
+**           FILE out = output stream
+** Out:      -
+** Return:   number of records decoded, -1 on failure
+**
+** Author:   J.L. Klaufus
+*/
+
+int TraceDecode(FILE *in, FILE *out)
+{
+	int                ret;
+	int                header[2];
+	int                thread, n;
+	int                j, k, sys;
+	unsigned long long count;
+	char               magic[8];
+	tTraceRecord       record;
+
+	if (fread(magic, 1, 8, in) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0 ||
+	    fread(header, sizeof(int), 2, in) != 2 || header[0] != (int)sizeof(tTraceRecord))
+	{
+		fprintf(stderr, "ERROR in function TraceDecode: Not a trace file of this version.\n");
+		return -1;
+	}
+
+	ret = 0;
+	while (ret != -1 && fread(&thread, sizeof(int), 1, in) == 1)
+	{
+		if (fread(&n, sizeof(int), 1, in) != 1 || fread(&count, sizeof(count), 1, in) != 1)
+		{
+			ret = -1;
+			break;
+		}
+
+		fprintf(out, "# Thread %d: %llu records, last %d kept\n", thread, count, n);
+		fprintf(out, "#  iter thr subsystem level event          i  values\n");
+
+		for (j=0; j<n && ret != -1; j++)
+		{
+			if (fread(&record, sizeof(record), 1, in) != 1 || record.event >= TRACE_NEVENTS)
+			{
+				ret = -1;
+				break;
+			}
+
+			for (sys=0; sys<NSUBSYSTEMS-1; sys++)
+				if (subsystems[sys].mask == record.subsystem)
+					break;
+
+			fprintf(out, "%7d %3d %-9s %5d %-10s %6d ", record.iteration, record.thread,
+			        sys < NSUBSYSTEMS-1 ? subsystems[sys].name : "?", record.level,
+			        events[record.event].name, record.i);
+
+			for (k=0; k<events[record.event].nValues; k++)
+				fprintf(out, " %s=%.17g", events[record.event].values[k], record.v[k]);
+			fprintf(out, "\n");
+
+			ret++;
+		}
+	}
+
+	if (ret == -1)
+		fprintf(stderr, "ERROR in function TraceDecode: Trace file is truncated.\n");
+
+	return ret;
+}
@@ -0,0 +1,76 @@
+/*
+** Header-file for Trace
+**
+**   TRACE statements are only compiled in when NOZZLE_TRACE is
+**   defined (make TRACE=1). Otherwise the preprocessor removes
+**   them completely, arguments included.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/* Levels; a record is kept when its level <= traceLevel */
+#define TRACE_ERROR    1
+#define TRACE_ITER     2
+#define TRACE_CALL     3
+#define TRACE_CELL     4
+
+/* Subsystems; a record is kept when its bit is set in traceMask */
+#define TRACE_SOLVER   0x01
+#define TRACE_SCHEME   0x02
+#define TRACE_AV       0x04
+#define TRACE_EH       0x08
+#define TRACE_TIMESTEP 0x10
+#define TRACE_BOUNDARY 0x20
+#define TRACE_GRID     0x40
+#define TRACE_ALL      0x7f
+
+/* Events; the names of their values are in trace.c */
+#define TRACE_EV_ITERATION 0
+#define TRACE_EV_FIELD     1
+#define TRACE_EV_LEFT      2
+#define TRACE_EV_RIGHT     3
+#define TRACE_EV_FLUX      4
+#define TRACE_EV_AV        5
+#define TRACE_EV_EH        6
+#define TRACE_EV_TIMESTEP  7
+#define TRACE_EV_BOUNDARY  8
+#define TRACE_EV_DERIV     9
+#define TRACE_EV_ERROR     10
+#define TRACE_NEVENTS      11
+
+/* Records kept per thread (power of 2); older records are overwritten */
+#define TRACE_RECORDS  65536
+
+typedef struct
+{
+	unsigned char  subsystem;
+	unsigned char  level;
+	unsigned short event;
+	int            iteration;
+	int            i;
+	int            thread;
+	double         v[4];
+} tTraceRecord;
+
+extern int traceMask;
+extern int traceLevel;
+
+int   TraceOpen(char*, char*, int);
+int   TraceClose(void);
+void  TraceRecord(int, int, int, int, double, double, double, double);
+void  TraceIteration(void);
+int   TraceDecode(FILE*, FILE*);
+
+#ifdef NOZZLE_TRACE
+#define TRACE_ON(sys, level)  (((sys) & traceMask) && (level) <= traceLevel)
+#define TRACE(sys, level, event, i, a, b, c, d) \
+	do { if (TRACE_ON(sys, level)) TraceRecord(sys, level, event, i, a, b, c, d); } while (0)
+#define TRACE_ITERATION()     TraceIteration()
+#else
+#define TRACE_ON(sys, level)  0
+#define TRACE(sys, level, event, i, a, b, c, d) ((void)0)
+#define TRACE_ITERATION()     ((void)0)
+#endif
+
+#endif
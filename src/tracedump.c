@@ -0,0 +1,41 @@
+/*
+** Program TraceDump
+**   Converts a binary trace file of program Nozzle (built with
+**   'make TRACE=1' and run with '-t') into text.
+**
+** Use:      tracedump [FILENAME]
+**
+** Author:   J.L. Klaufus
+*/
+
+#include <stdio.h>
+
+#include "trace.h"
+
+int main(int argc, char *argv[])
+{
+	int  ret;
+	char *traceFileName = "nozzle.trace";
+	FILE *traceFile;
+
+	if (argc > 2)
+	{
+		printf("Use : tracedump [FILENAME]\n");
+		return -1;
+	}
+
+	if (argc == 2)
+		traceFileName = argv[1];
+
+	traceFile = fopen(traceFileName, "rb");
+	if (traceFile == NULL)
+	{
+		fprintf(stderr, "ERROR in function TraceDump: Could not open '%s'.\n", traceFileName);
+		return -1;
+	}
+
+	ret = TraceDecode(traceFile, stdout);
+	fclose(traceFile);
+
+	return ret == -1 ? -1 : 0;
+}